@@ -19,7 +19,20 @@
 				"./src/Cluster.cpp",
 				"./src/Index.cpp",
 				"./src/Set.cpp",
-				"./src/Multiset.cpp"
+				"./src/Multiset.cpp",
+				"./src/Topology.cpp",
+				"./src/RandomWalk.cpp",
+				"./src/Similarity.cpp",
+				"./src/Features.cpp",
+				"./src/Scheduler.cpp",
+				"./src/Job.cpp",
+				"./src/Store.cpp",
+				"./src/Snapshot.cpp",
+				"./src/Loader.cpp",
+				"./src/Pool.cpp",
+				"./src/Ring.cpp",
+				"./src/Codec.cpp",
+				"./src/Encoder.cpp"
 			],
 			"conditions": [
 				["OS=='mac'", {
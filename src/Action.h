@@ -24,11 +24,13 @@
 #define GRAPHKIT_SRC_ACTION_H
 
 #include <cstring>
+#include <memory>
 #include <utility>
 #include <string>
 #include <cassert>
 #include <uv.h>
 #include "Node.h"
+#include "Encoder.h"
 #include "symbols.h"
 #include "Set.h"
 
@@ -122,10 +124,12 @@ namespace gk {
 		virtual std::string toJSON() noexcept;
 
 		/**
-		* persist
-		* Saves the Action<T> instance to disk.
+		* encode
+		* Appends the binary image of the Action<T> instance.
+		* @param		gk::Encoder& encoder
+		* @param		std::string& out
 		*/
-		virtual void persist() noexcept;
+		virtual void encode(gk::Encoder& encoder, std::string& out) noexcept;
 
 		/**
 		* Instance
@@ -203,7 +207,7 @@ namespace gk {
 		auto result = subjects(isolate)->insert(node);
 		if (result) {
 			node->actions(isolate)->insert(this);
-			persist();
+			this->record(gk::Mutation::AddSubject, node);
 		}
 		return result;
 	}
@@ -214,7 +218,7 @@ namespace gk {
 		auto result = subjects(isolate)->remove(node->hash());
 		if (result) {
 			node->actions(isolate)->remove(this->hash());
-			persist();
+			this->record(gk::Mutation::RemoveSubject, node);
 		}
 		return result;
 	}
@@ -235,7 +239,7 @@ namespace gk {
 		auto result = objects(isolate)->insert(node);
 		if (result) {
 			node->actions(isolate)->insert(this);
-			persist();
+			this->record(gk::Mutation::AddObject, node);
 		}
 		return result;
 	}
@@ -246,22 +250,35 @@ namespace gk {
 		auto result = objects(isolate)->remove(node->hash());
 		if (result) {
 			node->actions(isolate)->remove(this->hash());
-			persist();
+			this->record(gk::Mutation::RemoveObject, node);
 		}
 		return result;
 	}
 
+	template <typename T>
+	void gk::Action<T>::encode(gk::Encoder& encoder, std::string& out) noexcept {
+		this->image(encoder, out);
+		for (auto set : {subjects_, objects_}) {
+			encoder.count(out, nullptr == set ? 0 : set->count());
+			if (nullptr != set) {
+				set->each([&](const std::string&, gk::Node* node) {
+					encoder.reference(out, node);
+				});
+			}
+		}
+	}
+
 	template <typename T>
 	std::string gk::Action<T>::toJSON() noexcept {
 		std::string json = "{\"id\":" + std::to_string(id()) +
 			",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(nodeClass())) +
-			",\"type\":\"" + type() + "\"";
+			",\"type\":" + escape(type());
 
 		// store properties
 		json += ",\"properties\":[";
 		for (auto i = properties()->count(); 0 < i; --i) {
 			auto q = properties_->node(i);
-			json += "[\"" + q->key() + "\",\"" + *q->data() + "\"]";
+			json += "[" + escape(q->key()) + "," + escape(*q->data()) + "]";
 			if (1 != i) {
 				json += ",";
 			}
@@ -270,7 +287,7 @@ namespace gk {
 		json += "],\"groups\":[";
 		// store groups
 		for (auto i = groups()->count(); 0 < i; --i) {
-			json += "\"" + *groups_->select(i) + "\"";
+			json += escape(*groups_->select(i));
 			if (1 != i) {
 				json += ",";
 			}
@@ -280,7 +297,7 @@ namespace gk {
 		if (nullptr != subjects_) {
 			for (auto i = subjects_->count(); 0 < i; --i) {
 				auto subject = subjects_->select(i);
-				json += "{\"id\":" + std::to_string(subject->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(subject->nodeClass())) + ",\"type\":\"" + subject->type() + "\"}";
+				json += "{\"id\":" + std::to_string(subject->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(subject->nodeClass())) + ",\"type\":" + escape(subject->type()) + "}";
 				if (1 != i) {
 					json += ",";
 				}
@@ -291,7 +308,7 @@ namespace gk {
 		if (nullptr != objects_) {
 			for (auto i = objects_->count(); 0 < i; --i) {
 				auto object = objects_->select(i);
-				json += "{\"id\":" + std::to_string(object->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(object->nodeClass())) + ",\"type\":\"" + object->type() + "\"}";
+				json += "{\"id\":" + std::to_string(object->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(object->nodeClass())) + ",\"type\":" + escape(object->type()) + "}";
 				if (1 != i) {
 					json += ",";
 				}
@@ -302,27 +319,6 @@ namespace gk {
 		return json;
 	}
 
-	template <typename T>
-	void gk::Action<T>::persist() noexcept {
-		if (indexed()) {
-			std::string dir (GK_FS_DB_DIR);
-			uv_fs_t open_req;
-			uv_fs_open(uv_default_loop(), &open_req, ("./" + dir + "/" + hash() + ".gk").c_str(), O_CREAT | O_RDWR, S_IRWXU, NULL);
-			std::string json = toJSON();
-			int len = json.length() + 1;
-			char buf[len];
-			snprintf(buf, len, "%s", json.c_str());
-			uv_buf_t iov = uv_buf_init(buf, sizeof(buf));
-			uv_fs_t write_req;
-			uv_fs_write(uv_default_loop(), &write_req, open_req.result, &iov, 1, 0, NULL);
-			uv_fs_t close_req;
-			uv_fs_close(uv_default_loop(), &close_req, open_req.result, NULL);
-			uv_fs_req_cleanup(&open_req);
-			uv_fs_req_cleanup(&write_req);
-			uv_fs_req_cleanup(&close_req);
-		};
-	}
-
 	template <typename T>
 	gk::Action<T>* gk::Action<T>::Instance(v8::Isolate* isolate, const char* type) noexcept {
 		const int argc = 1;
@@ -520,12 +516,13 @@ namespace gk {
 
 		v8::String::Utf8Value v(value);
 		auto a = node::ObjectWrap::Unwrap<gk::Action<T>>(args.Holder());
-		a->properties()->remove(*p, [](std::string* v) {
-			delete v;
+		std::unique_ptr<std::string> prior;
+		a->properties()->remove(*p, [&](std::string* v) {
+			prior.reset(v);
 		});
 		auto result = a->properties()->insert(*p, new std::string{*v});
 		if (result) {
-			a->persist();
+			a->record(gk::Mutation::Set, *p, *v, prior.get());
 		}
 		GK_RETURN(GK_BOOLEAN(result));
 	}
@@ -558,8 +555,8 @@ namespace gk {
 
 		auto a = node::ObjectWrap::Unwrap<gk::Action<T>>(args.Holder());
 		GK_RETURN(GK_BOOLEAN(a->properties()->remove(*p, [&](std::string* v) {
+			a->record(gk::Mutation::Delete, *p, "", v);
 			delete v;
-			a->persist();
 		})));
 	}
 
@@ -25,8 +25,10 @@
 
 #include <cstring>
 #include <cassert>
+#include <memory>
 #include <uv.h>
 #include "Node.h"
+#include "Encoder.h"
 #include "symbols.h"
 
 namespace gk {
@@ -71,7 +73,7 @@ namespace gk {
 		bool removeObject() noexcept;
 
 		virtual std::string toJSON() noexcept;
-		virtual void persist() noexcept;
+		virtual void encode(gk::Encoder& encoder, std::string& out) noexcept;
 
 		static Bond<T>* Instance(v8::Isolate* isolate, const char* type) noexcept;
 		static GK_INIT(Init);
@@ -118,11 +120,13 @@ namespace gk {
 	bool gk::Bond<T>::subject(v8::Isolate* isolate, T* node) noexcept {
 		assert(node);
 		assert(this->indexed());
+
+		// recorded first so a batch holds the previous subject before it is let go
+		this->record(gk::Mutation::Subject, node, subject_);
 		removeSubject();
 		subject_ = node;
 		subject_->Ref();
 		subject_->bonds(isolate)->insert(this);
-		persist();
 		return true;
 	}
 
@@ -147,11 +151,13 @@ namespace gk {
 	bool gk::Bond<T>::object(v8::Isolate* isolate, T* node) noexcept {
 		assert(node);
 		assert(this->indexed());
+
+		// recorded first so a batch holds the previous object before it is let go
+		this->record(gk::Mutation::Object, node, object_);
 		removeObject();
 		object_ = node;
 		object_->Ref();
 		object_->bonds(isolate)->insert(this);
-		persist();
 		return true;
 	}
 
@@ -167,17 +173,28 @@ namespace gk {
 		return false;
 	}
 
+	template <typename T>
+	void gk::Bond<T>::encode(gk::Encoder& encoder, std::string& out) noexcept {
+		this->image(encoder, out);
+		for (auto node : {subject_, object_}) {
+			encoder.count(out, nullptr == node ? 0 : 1);
+			if (nullptr != node) {
+				encoder.reference(out, node);
+			}
+		}
+	}
+
 	template <typename T>
 	std::string gk::Bond<T>::toJSON() noexcept {
 		std::string json = "{\"id\":" + std::to_string(id()) +
 			",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(nodeClass())) +
-			",\"type\":\"" + type() + "\"";
+			",\"type\":" + escape(type());
 
 		// store properties
 		json += ",\"properties\":[";
 		for (auto i = properties()->count(); 0 < i; --i) {
 			auto q = properties_->node(i);
-			json += "[\"" + q->key() + "\",\"" + *q->data() + "\"]";
+			json += "[" + escape(q->key()) + "," + escape(*q->data()) + "]";
 			if (1 != i) {
 				json += ",";
 			}
@@ -186,7 +203,7 @@ namespace gk {
 		json += "],\"groups\":[";
 		// store groups
 		for (auto i = groups()->count(); 0 < i; --i) {
-			json += "\"" + *groups_->select(i) + "\"";
+			json += escape(*groups_->select(i));
 			if (1 != i) {
 				json += ",";
 			}
@@ -194,38 +211,17 @@ namespace gk {
 
 		json += "]";
 		if (nullptr != subject_) {
-			json += ",\"subject\":{\"id\":" + std::to_string(subject_->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(subject_->nodeClass())) + ",\"type\":\"" + subject_->type() + "\"}";
+			json += ",\"subject\":{\"id\":" + std::to_string(subject_->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(subject_->nodeClass())) + ",\"type\":" + escape(subject_->type()) + "}";
 		}
 
 		if (nullptr != object_) {
-			json += ",\"object\":{\"id\":" + std::to_string(object_->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(object_->nodeClass())) + ",\"type\":\"" + object_->type() + "\"}";
+			json += ",\"object\":{\"id\":" + std::to_string(object_->id()) + ",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(object_->nodeClass())) + ",\"type\":" + escape(object_->type()) + "}";
 		}
 
 		json += "}";
 		return json;
 	}
 
-	template <typename T>
-	void gk::Bond<T>::persist() noexcept {
-		if (indexed()) {
-			std::string dir (GK_FS_DB_DIR);
-			uv_fs_t open_req;
-			uv_fs_open(uv_default_loop(), &open_req, ("./" + dir + "/" + hash() + ".gk").c_str(), O_CREAT | O_RDWR, S_IRWXU, NULL);
-			std::string json = toJSON();
-			int len = json.length() + 1;
-			char buf[len];
-			snprintf(buf, len, "%s", json.c_str());
-			uv_buf_t iov = uv_buf_init(buf, sizeof(buf));
-			uv_fs_t write_req;
-			uv_fs_write(uv_default_loop(), &write_req, open_req.result, &iov, 1, 0, NULL);
-			uv_fs_t close_req;
-			uv_fs_close(uv_default_loop(), &close_req, open_req.result, NULL);
-			uv_fs_req_cleanup(&open_req);
-			uv_fs_req_cleanup(&write_req);
-			uv_fs_req_cleanup(&close_req);
-		}
-	}
-
 	template <typename T>
 	gk::Bond<T>* gk::Bond<T>::Instance(v8::Isolate* isolate, const char* type) noexcept {
 		const int argc = 1;
@@ -387,12 +383,13 @@ namespace gk {
 
 		v8::String::Utf8Value v(value);
 		auto prop = std::string{*p};
-		b->properties()->remove(prop, [](std::string* v) {
-			delete v;
+		std::unique_ptr<std::string> prior;
+		b->properties()->remove(prop, [&](std::string* v) {
+			prior.reset(v);
 		});
 		auto result = b->properties()->insert(prop, new std::string{*v});
 		if (result) {
-			b->persist();
+			b->record(gk::Mutation::Set, prop, *v, prior.get());
 		}
 		GK_RETURN(GK_BOOLEAN(result));
 	}
@@ -420,23 +417,25 @@ namespace gk {
 
 		auto b = node::ObjectWrap::Unwrap<gk::Bond<T>>(args.Holder());
 		if (0 == strcmp(*p, GK_SYMBOL_OPERATION_SUBJECT)) {
+			auto subject = b->subject();
 			if (b->removeSubject()) {
-				b->persist();
+				b->record(gk::Mutation::RemoveSubject, subject);
 				GK_RETURN(GK_BOOLEAN(true));
 			}
 			GK_RETURN(GK_BOOLEAN(false));
 		}
 		if (0 == strcmp(*p, GK_SYMBOL_OPERATION_OBJECT)) {
+			auto object = b->object();
 			if (b->removeObject()) {
-				b->persist();
+				b->record(gk::Mutation::RemoveObject, object);
 				GK_RETURN(GK_BOOLEAN(true));
 			}
 			GK_RETURN(GK_BOOLEAN(false));
 		}
 
 		GK_RETURN(GK_BOOLEAN(b->properties()->remove(*p, [&](std::string* v) {
+			b->record(gk::Mutation::Delete, *p, "", v);
 			delete v;
-			b->persist();
 		})));
 	}
 
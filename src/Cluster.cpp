@@ -22,10 +22,11 @@
 
 GK_CONSTRUCTOR(gk::Cluster::constructor_);
 
-gk::Cluster::Cluster(const gk::NodeClass& nodeClass) noexcept
+gk::Cluster::Cluster(const gk::NodeClass& nodeClass, const std::string& dir) noexcept
 	: gk::Export{},
 	  gk::RedBlackTree<gk::Index, true, std::string>{},
-	  nodeClass_{std::move(nodeClass)} {}
+	  nodeClass_{std::move(nodeClass)},
+	  dir_{dir} {}
 
 gk::Cluster::~Cluster() {
 	this->clear([](gk::Index* index) {
@@ -39,18 +40,23 @@ const gk::NodeClass& gk::Cluster::nodeClass() const noexcept {
 }
 
 bool gk::Cluster::insert(v8::Isolate* isolate, gk::Node* node) noexcept {
-	auto index = this->findByKey(node->type());
+	auto index = this->index(isolate, node->type());
+	return index && index->insert(node);
+}
+
+gk::Index* gk::Cluster::index(v8::Isolate* isolate, const std::string& type) noexcept {
+	auto index = this->findByKey(type);
 	if (!index) {
-		auto nodeClass = node->nodeClass();
-		auto type = node->type();
-		index = gk::Index::Instance(isolate, nodeClass, type);
+		auto nodeClass = nodeClass_;
+		auto t = type;
+		index = gk::Index::Instance(isolate, nodeClass, t, dir_);
 		if (!gk::RedBlackTree<gk::Index, true, std::string>::insert(index->type(), index, [](gk::Index* index) {
 			index->Ref();
 		})) {
-			return false;
+			return nullptr;
 		}
 	}
-	return index->insert(node);
+	return index;
 }
 
 void gk::Cluster::cleanUp() noexcept {
@@ -65,9 +71,9 @@ GK_METHOD(gk::Cluster::NodeClassToString) {
 	GK_RETURN(GK_STRING(gk::NodeClassToString(cluster->nodeClass())));
 }
 
-gk::Cluster* gk::Cluster::Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass) noexcept {
-	const int argc = 1;
-	v8::Local<v8::Value> argv[argc] = {GK_INTEGER(gk::NodeClassToInt(nodeClass))};
+gk::Cluster* gk::Cluster::Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass, const std::string& dir) noexcept {
+	const int argc = 2;
+	v8::Local<v8::Value> argv[argc] = {GK_INTEGER(gk::NodeClassToInt(nodeClass)), GK_STRING(dir.c_str())};
 	auto ctor = GK_FUNCTION(constructor_);
 	return node::ObjectWrap::Unwrap<gk::Cluster>(ctor->NewInstance(argc, argv));
 }
@@ -98,14 +104,18 @@ GK_METHOD(gk::Cluster::New) {
 		GK_EXCEPTION("[GraphKit Error: Please specify a correct NodeClass value.]");
 	}
 
+	if (!args[1]->IsUndefined() && !args[1]->IsString()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct path value.]");
+	}
+
 	if (args.IsConstructCall()) {
 		auto nodeClass = gk::NodeClassFromInt(args[0]->IntegerValue());
-		auto obj = new gk::Cluster{nodeClass};
+		auto obj = args[1]->IsString() ? new gk::Cluster{nodeClass, *v8::String::Utf8Value(args[1]->ToString())} : new gk::Cluster{nodeClass};
 		obj->Wrap(args.This());
 		GK_RETURN(args.This());
 	} else {
-		const int argc = 1;
-		v8::Local<v8::Value> argv[argc] = {args[0]};
+		const int argc = 2;
+		v8::Local<v8::Value> argv[argc] = {args[0], args[1]};
 		auto ctor = GK_FUNCTION(constructor_);
 		GK_RETURN(ctor->NewInstance(argc, argv));
 	}
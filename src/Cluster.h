@@ -36,8 +36,9 @@ namespace gk {
 		* Cluser
 		* Explicit Constructor.
 		* @param		const gk::NodeClass& nodeClass
+		* @param		const std::string& dir, the data directory of its Indexes
 		*/
-		explicit Cluster(const gk::NodeClass& nodeClass) noexcept;
+		explicit Cluster(const gk::NodeClass& nodeClass, const std::string& dir = "./" GK_FS_DB_DIR) noexcept;
 
 		/**
 		* ~Cluster
@@ -67,17 +68,27 @@ namespace gk {
 		*/
 		bool insert(v8::Isolate* isolate, gk::Node* node) noexcept;
 
+		/**
+		* index
+		* Finds the Index of a type, creating it if needed.
+		* @param		v8::Isolate* isolate
+		* @param		const std::string& type
+		* @return		gk::Index*, nullptr if it could not be created
+		*/
+		gk::Index* index(v8::Isolate* isolate, const std::string& type) noexcept;
+
 		/**
 		* cleanUp
 		* Should be called when wanting to cleanup the cluster for v8 garbage collection references.
 		*/
 		void cleanUp() noexcept;
 
-		static gk::Cluster* Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass) noexcept;
+		static gk::Cluster* Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass, const std::string& dir = "./" GK_FS_DB_DIR) noexcept;
 		static GK_INIT(Init);
 
 	private:
 		const gk::NodeClass nodeClass_;
+		const std::string dir_;
 
 		static GK_CONSTRUCTOR(constructor_);
 		static GK_METHOD(New);
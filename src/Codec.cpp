@@ -0,0 +1,333 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstddef>
+#include <cstring>
+#include "Codec.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define GK_CODEC_SSE42
+#include <nmmintrin.h>
+#endif
+
+static const char GK_CODEC_MAGIC[4] = {'\x1f', 'G', 'K', 'Z'};
+
+// the block format, a match is at least 4 bytes, the last 5 bytes are
+// literals and the last match starts 12 bytes before the end
+static const std::size_t GK_CODEC_MIN_MATCH = 4;
+static const std::size_t GK_CODEC_LAST_LITERALS = 5;
+static const std::size_t GK_CODEC_MF_LIMIT = 12;
+static const std::size_t GK_CODEC_MAX_DISTANCE = 65535;
+static const unsigned GK_CODEC_HASH_LOG = 12;
+
+// blocks larger than the frame sizes can hold are stored as is
+static const std::size_t GK_CODEC_MAX_BLOCK = 0x7E000000;
+
+static uint32_t read32(const char* p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static uint32_t hash(uint32_t v) {
+	return (v * 2654435761u) >> (32 - GK_CODEC_HASH_LOG);
+}
+
+// writes the 15 and over part of a length
+static char* length(char* op, std::size_t n) {
+	for (; 255 <= n; n -= 255) {
+		*op++ = static_cast<char>(255);
+	}
+	*op++ = static_cast<char>(n);
+	return op;
+}
+
+// the bytes a sequence of literals and a match may take
+static std::size_t sequence(std::size_t literals, std::size_t match) {
+	return 1 + literals / 255 + 1 + literals + 2 + match / 255 + 1;
+}
+
+std::size_t gk::Codec::bound(std::size_t size) noexcept {
+	return size + size / 255 + 16;
+}
+
+std::size_t gk::Codec::compress(const char* src, std::size_t size, char* dst, std::size_t capacity) noexcept {
+	if (GK_CODEC_MAX_BLOCK < size) {
+		return 0;
+	}
+	auto op = dst;
+	auto end = dst + capacity;
+	std::size_t anchor = 0;
+	if (GK_CODEC_MF_LIMIT < size) {
+		uint32_t table[1 << GK_CODEC_HASH_LOG] = {};
+		auto limit = size - GK_CODEC_MF_LIMIT;
+		auto matchLimit = size - GK_CODEC_LAST_LITERALS;
+		std::size_t ip = 1;
+		std::size_t misses = 0;
+		while (ip < limit) {
+			auto h = hash(read32(src + ip));
+			std::size_t ref = table[h];
+			table[h] = static_cast<uint32_t>(ip);
+			if (GK_CODEC_MAX_DISTANCE < ip - ref || read32(src + ref) != read32(src + ip)) {
+				// incompressible data is skipped faster the longer nothing matches
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+			while (anchor < ip && 0 < ref && src[ip - 1] == src[ref - 1]) {
+				--ip;
+				--ref;
+			}
+			auto n = GK_CODEC_MIN_MATCH;
+			while (ip + n < matchLimit && src[ip + n] == src[ref + n]) {
+				++n;
+			}
+
+			auto literals = ip - anchor;
+			if (static_cast<std::size_t>(end - op) < sequence(literals, n - GK_CODEC_MIN_MATCH)) {
+				return 0;
+			}
+			auto token = op++;
+			if (15 <= literals) {
+				*token = static_cast<char>(15 << 4);
+				op = length(op, literals - 15);
+			} else {
+				*token = static_cast<char>(literals << 4);
+			}
+			memcpy(op, src + anchor, literals);
+			op += literals;
+			auto distance = ip - ref;
+			*op++ = static_cast<char>(distance & 255);
+			*op++ = static_cast<char>(distance >> 8);
+			auto match = n - GK_CODEC_MIN_MATCH;
+			if (15 <= match) {
+				*token = static_cast<char>(*token | 15);
+				op = length(op, match - 15);
+			} else {
+				*token = static_cast<char>(*token | match);
+			}
+			ip += n;
+			anchor = ip;
+			if (ip < limit) {
+				table[hash(read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+			}
+		}
+	}
+
+	// the block ends with its remaining literals
+	auto literals = size - anchor;
+	if (static_cast<std::size_t>(end - op) < 1 + literals / 255 + 1 + literals) {
+		return 0;
+	}
+	auto token = op++;
+	if (15 <= literals) {
+		*token = static_cast<char>(15 << 4);
+		op = length(op, literals - 15);
+	} else {
+		*token = static_cast<char>(literals << 4);
+	}
+	memcpy(op, src + anchor, literals);
+	op += literals;
+	return op - dst;
+}
+
+bool gk::Codec::decompress(const char* src, std::size_t size, char* dst, std::size_t length) noexcept {
+	auto s = reinterpret_cast<const unsigned char*>(src);
+	std::size_t ip = 0;
+	std::size_t op = 0;
+	while (ip < size) {
+		unsigned token = s[ip++];
+		std::size_t literals = token >> 4;
+		if (15 == literals) {
+			unsigned char b;
+			do {
+				if (ip >= size) {
+					return false;
+				}
+				b = s[ip++];
+				literals += b;
+			} while (255 == b);
+		}
+		if (literals > size - ip || literals > length - op) {
+			return false;
+		}
+		memcpy(dst + op, src + ip, literals);
+		ip += literals;
+		op += literals;
+
+		// the last sequence has no match
+		if (ip == size) {
+			break;
+		}
+		if (2 > size - ip) {
+			return false;
+		}
+		std::size_t distance = s[ip] | (s[ip + 1] << 8);
+		ip += 2;
+		if (0 == distance || distance > op) {
+			return false;
+		}
+		std::size_t match = token & 15;
+		if (15 == match) {
+			unsigned char b;
+			do {
+				if (ip >= size) {
+					return false;
+				}
+				b = s[ip++];
+				match += b;
+			} while (255 == b);
+		}
+		match += GK_CODEC_MIN_MATCH;
+		if (match > length - op) {
+			return false;
+		}
+
+		// a match may overlap the bytes it produces
+		auto from = dst + op - distance;
+		if (distance >= match) {
+			memcpy(dst + op, from, match);
+		} else {
+			for (std::size_t i = 0; i < match; ++i) {
+				dst[op + i] = from[i];
+			}
+		}
+		op += match;
+	}
+	return op == length;
+}
+
+// the reflected Castagnoli polynomial, eight tables so eight bytes are folded at a time
+struct Crc32cTable {
+	uint32_t t[8][256];
+
+	Crc32cTable() {
+		for (uint32_t i = 0; i < 256; ++i) {
+			auto c = i;
+			for (auto k = 0; k < 8; ++k) {
+				c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+			}
+			t[0][i] = c;
+		}
+		for (uint32_t i = 0; i < 256; ++i) {
+			for (auto k = 1; k < 8; ++k) {
+				t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 255];
+			}
+		}
+	}
+};
+
+#ifdef GK_CODEC_SSE42
+__attribute__((target("sse4.2")))
+static uint32_t hardware(const unsigned char* p, std::size_t size, uint32_t crc) {
+	uint64_t c = crc;
+	for (; 8 <= size; p += 8, size -= 8) {
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		c = _mm_crc32_u64(c, v);
+	}
+	auto c32 = static_cast<uint32_t>(c);
+	for (; 0 < size; ++p, --size) {
+		c32 = _mm_crc32_u8(c32, *p);
+	}
+	return c32;
+}
+#endif
+
+uint32_t gk::Codec::crc32c(const void* data, std::size_t size, uint32_t crc) noexcept {
+	auto p = static_cast<const unsigned char*>(data);
+	crc = ~crc;
+#ifdef GK_CODEC_SSE42
+	static const bool sse42 = __builtin_cpu_supports("sse4.2");
+	if (sse42) {
+		return ~hardware(p, size, crc);
+	}
+#endif
+	static const Crc32cTable table;
+	auto& t = table.t;
+	for (; 8 <= size; p += 8, size -= 8) {
+		uint32_t lo;
+		uint32_t hi;
+		memcpy(&lo, p, sizeof(lo));
+		memcpy(&hi, p + 4, sizeof(hi));
+		lo ^= crc;
+		crc = t[7][lo & 255] ^ t[6][(lo >> 8) & 255] ^ t[5][(lo >> 16) & 255] ^ t[4][lo >> 24] ^
+			t[3][hi & 255] ^ t[2][(hi >> 8) & 255] ^ t[1][(hi >> 16) & 255] ^ t[0][hi >> 24];
+	}
+	for (; 0 < size; ++p, --size) {
+		crc = (crc >> 8) ^ t[0][(crc ^ *p) & 255];
+	}
+	return ~crc;
+}
+
+bool gk::Codec::frame(const char* data, std::size_t size, std::string& out) noexcept {
+	// the sizes are 32 bits, larger blocks are left to the caller
+	if (GK_CODEC_MAX_BLOCK < size) {
+		return false;
+	}
+	Header h;
+	memcpy(h.magic, GK_CODEC_MAGIC, sizeof(h.magic));
+	h.length = static_cast<uint32_t>(size);
+	auto at = out.size();
+	out.resize(at + sizeof(Header) + bound(size));
+	auto body = &out[at + sizeof(Header)];
+	auto stored = compress(data, size, body, bound(size));
+	if (0 == stored || stored >= size) {
+		memcpy(body, data, size);
+		stored = size;
+	}
+	h.stored = static_cast<uint32_t>(stored);
+	h.checksum = checksum(h, body);
+	memcpy(&out[at], &h, sizeof(Header));
+	out.resize(at + sizeof(Header) + stored);
+	return true;
+}
+
+bool gk::Codec::framed(const char* data, std::size_t size) noexcept {
+	return sizeof(GK_CODEC_MAGIC) <= size && 0 == memcmp(data, GK_CODEC_MAGIC, sizeof(GK_CODEC_MAGIC));
+}
+
+bool gk::Codec::unframe(const char* data, std::size_t size, std::string& out, std::size_t& used) noexcept {
+	Header h;
+	if (sizeof(Header) > size || !framed(data, size)) {
+		return false;
+	}
+	memcpy(&h, data, sizeof(Header));
+
+	// a corrupt length must not size the output, a compressed byte expands to at most 255
+	if (h.stored > size - sizeof(Header) || h.stored > h.length || GK_CODEC_MAX_BLOCK < h.length ||
+		(h.stored < h.length && static_cast<uint64_t>(h.stored) * 255 < h.length)) {
+		return false;
+	}
+	auto body = data + sizeof(Header);
+	if (h.checksum != checksum(h, body)) {
+		return false;
+	}
+	out.resize(h.length);
+	if (h.stored == h.length) {
+		memcpy(&out[0], body, h.length);
+	} else if (!decompress(body, h.stored, &out[0], h.length)) {
+		return false;
+	}
+	used = sizeof(Header) + h.stored;
+	return true;
+}
+
+uint32_t gk::Codec::checksum(const Header& h, const char* body) noexcept {
+	return crc32c(body, h.stored, crc32c(&h, offsetof(Header, checksum)));
+}
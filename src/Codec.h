@@ -0,0 +1,131 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Codec.h
+*
+* A fast block codec in the LZ4 block format with CRC32C checksums, so no
+* library is needed. Blocks are framed with a small header holding their
+* sizes and the checksum of the sizes and the stored bytes, a block that
+* does not shrink is stored as is. The frame starts with a byte no JSON record starts with,
+* so framed blocks and plain records can follow each other in one file.
+*/
+
+#ifndef GRAPHKIT_SRC_CODEC_H
+#define GRAPHKIT_SRC_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gk {
+	class Codec {
+	public:
+
+		/**
+		* Header
+		* The frame of a block, in native byte order.
+		*/
+		struct Header {
+			char magic[4];
+			uint32_t length;
+			uint32_t stored;
+			uint32_t checksum;
+		};
+
+		/**
+		* bound
+		* The largest compressed size of a block.
+		* @param		std::size_t size
+		* @return		std::size_t
+		*/
+		static std::size_t bound(std::size_t size) noexcept;
+
+		/**
+		* compress
+		* Compresses a block into the LZ4 block format.
+		* @param		const char* src
+		* @param		std::size_t size
+		* @param		char* dst
+		* @param		std::size_t capacity
+		* @return		std::size_t, the compressed size or 0 if it does not fit
+		*/
+		static std::size_t compress(const char* src, std::size_t size, char* dst, std::size_t capacity) noexcept;
+
+		/**
+		* decompress
+		* Decompresses a block of a known length, checking every bound.
+		* @param		const char* src
+		* @param		std::size_t size
+		* @param		char* dst
+		* @param		std::size_t length
+		* @return		bool, false if the block is malformed
+		*/
+		static bool decompress(const char* src, std::size_t size, char* dst, std::size_t length) noexcept;
+
+		/**
+		* crc32c
+		* The CRC32C (Castagnoli) checksum, in hardware where available.
+		* @param		const void* data
+		* @param		std::size_t size
+		* @param		uint32_t crc, of the preceding data
+		* @return		uint32_t
+		*/
+		static uint32_t crc32c(const void* data, std::size_t size, uint32_t crc = 0) noexcept;
+
+		/**
+		* frame
+		* Appends a framed block, compressed if that makes it smaller.
+		* @param		const char* data
+		* @param		std::size_t size
+		* @param		std::string& out
+		* @return		bool, false if the block is too large for a frame and nothing was appended
+		*/
+		static bool frame(const char* data, std::size_t size, std::string& out) noexcept;
+
+		/**
+		* framed
+		* Whether a framed block starts at data.
+		* @param		const char* data
+		* @param		std::size_t size
+		* @return		bool
+		*/
+		static bool framed(const char* data, std::size_t size) noexcept;
+
+		/**
+		* unframe
+		* Reads the framed block at data into out.
+		* @param		const char* data
+		* @param		std::size_t size
+		* @param		std::string& out
+		* @param		std::size_t& used, the bytes of the frame
+		* @return		bool, false if the block is torn, too large or fails its checksum
+		*/
+		static bool unframe(const char* data, std::size_t size, std::string& out, std::size_t& used) noexcept;
+
+	protected:
+		/**
+		* checksum
+		* The checksum of the sizes of a frame and its stored bytes.
+		* @param		const Header& h
+		* @param		const char* body
+		* @return		uint32_t
+		*/
+		static uint32_t checksum(const Header& h, const char* body) noexcept;
+	};
+}
+
+#endif
@@ -16,248 +16,276 @@
 * in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cstdlib>
 #include <uv.h>
 #include "Coordinator.h"
-#include "json.h"
 #include "symbols.h"
 #include "Entity.h"
 #include "Action.h"
 #include "Bond.h"
+#include "Snapshot.h"
+#include "Loader.h"
+
+// Nodes of a dropped Index released per loop iteration
+static const std::size_t GK_COORDINATOR_DROP_CHUNK = 4096;
+
+std::map<std::string, std::weak_ptr<gk::Coordinator::State>> gk::Coordinator::states_;
+
+// the logs outlive their Graphs until closed, never destroyed so the exit hook can close the rest
+static auto& stores_ = *new std::map<std::string, std::shared_ptr<gk::Store>>;
+
+static std::string resolve(const std::string& path) noexcept {
+	// the directory must exist to resolve, so every spelling of it shares one Graph
+	uv_fs_t mkdir_req;
+	uv_fs_mkdir(uv_default_loop(), &mkdir_req, path.c_str(), S_IRWXU, NULL);
+	uv_fs_req_cleanup(&mkdir_req);
+	uv_fs_t realpath_req;
+	auto r = uv_fs_realpath(uv_default_loop(), &realpath_req, path.c_str(), NULL);
+	std::string resolved{0 == r ? static_cast<const char*>(realpath_req.ptr) : path};
+	uv_fs_req_cleanup(&realpath_req);
+	return resolved;
+}
 
-bool gk::Coordinator::synched_ = false;
-std::shared_ptr<gk::Coordinator::NodeGraph> gk::Coordinator::nodeGraph_;
-std::shared_ptr<gk::Coordinator::GroupGraph> gk::Coordinator::groupGraph_;
-
-gk::Coordinator::Coordinator() noexcept {}
+gk::Coordinator::Coordinator() noexcept
+	: Coordinator{"./" GK_FS_DB_DIR} {}
+
+gk::Coordinator::Coordinator(const std::string& path) noexcept
+	: state_{} {
+	auto dir = resolve(path);
+	auto& state = states_[dir];
+	state_ = state.lock();
+	if (!state_) {
+		state_ = std::make_shared<State>(State{dir, false, nullptr, nullptr, nullptr, {}});
+		state = state_;
+	}
+}
 
 gk::Coordinator::~Coordinator() {
-	if (1 == nodeGraph_.use_count()) {
-		// cleanup when the last instance
-		nodeGraph_->clear([](Cluster* cluster) {
+	// the last Coordinator of a data directory cleans up its Graph
+	if (!state_ || 1 < state_.use_count()) {
+		return;
+	}
+	clear();
+}
+
+void gk::Coordinator::close() noexcept {
+	// the Graph holds its Nodes and they hold it, both go once the Graph is cleared
+	store()->shutdown();
+
+	// an Entity and its Actions and Bonds hold each other, the log is closed so nothing is recorded
+	auto entities = nodeGraph()->findByKey(gk::NodeClass::Entity);
+	for (auto i = entities ? entities->count() : 0; 0 < i; --i) {
+		auto index = entities->select(i);
+		for (auto j = index->count(); 0 < j; --j) {
+			static_cast<gk::Entity*>(index->select(j))->detach();
+		}
+	}
+
+	auto store = stores_.find(state_->path);
+	if (stores_.end() != store && store->second == state_->store) {
+		stores_.erase(store);
+	}
+	clear();
+}
+
+void gk::Coordinator::clear() noexcept {
+	// a newer Graph may already be open for the directory
+	auto state = states_.find(state_->path);
+	if (states_.end() != state && !state->second.owner_before(state_) && !state_.owner_before(state->second)) {
+		states_.erase(state);
+	}
+
+	if (state_->nodeGraph) {
+		state_->nodeGraph->clear([](Cluster* cluster) {
 			cluster->cleanUp();
 			cluster->Unref();
 		});
-		nodeGraph_.reset();
-
-		// no longer synched
-		synched_ = false;
+		state_->nodeGraph.reset();
 	}
 
-	if (1 == groupGraph_.use_count()) {
-		// cleanup when the last instance
-		groupGraph_->clear([](gk::Set* set) {
+	if (state_->groupGraph) {
+		state_->groupGraph->clear([](gk::Set* set) {
 			set->cleanUp();
 			set->Unref();
 		});
-		groupGraph_.reset();
+		state_->groupGraph.reset();
+	}
+}
+
+bool gk::Coordinator::synched() const noexcept {
+	return state_->synched;
+}
+
+const std::string& gk::Coordinator::path() const noexcept {
+	return state_->path;
+}
+
+std::shared_ptr<gk::Coordinator> gk::Coordinator::shared() noexcept {
+	// held weakly, the Nodes own the handle and the State never owns itself
+	auto handle = state_->handle.lock();
+	if (!handle) {
+		handle = std::make_shared<gk::Coordinator>(*this);
+		state_->handle = handle;
 	}
+	return handle;
 }
 
 std::shared_ptr<gk::Coordinator::NodeGraph> gk::Coordinator::nodeGraph() noexcept {
-	if (0 == nodeGraph_.use_count()) {
-		nodeGraph_ = std::make_shared<NodeGraph>();
+	if (!state_->nodeGraph) {
+		state_->nodeGraph = std::make_shared<NodeGraph>();
 	}
-	return nodeGraph_;
+	return state_->nodeGraph;
 }
 
 std::shared_ptr<gk::Coordinator::GroupGraph> gk::Coordinator::groupGraph() noexcept {
-	if (0 == groupGraph_.use_count()) {
-		groupGraph_ = std::make_shared<GroupGraph>();
+	if (!state_->groupGraph) {
+		state_->groupGraph = std::make_shared<GroupGraph>();
 	}
-	return groupGraph_;
+	return state_->groupGraph;
+}
+
+std::shared_ptr<gk::Store> gk::Coordinator::store() noexcept {
+	if (!state_->store) {
+		auto& store = stores_[state_->path];
+		if (!store) {
+			// process.exit does not run the node AtExit hooks on every version
+			static bool hooked = false;
+			if (!hooked) {
+				hooked = true;
+				std::atexit([]() {
+					for (auto& s : stores_) {
+						s.second->close();
+					}
+				});
+			}
+			store = std::make_shared<gk::Store>(state_->path);
+		}
+		state_->store = store;
+
+		// checkpoints list Entities first, so the relationships of the others resolve on load
+		std::weak_ptr<State> weak = state_;
+		store->collector([weak]() {
+			std::vector<gk::Node*> nodes;
+			auto state = weak.lock();
+			if (state && state->nodeGraph) {
+				auto& nodeGraph = state->nodeGraph;
+				for (auto i = 1; i <= nodeGraph->count(); ++i) {
+					auto cluster = nodeGraph->select(i);
+					for (auto j = 1; j <= cluster->count(); ++j) {
+						auto index = cluster->select(j);
+						for (auto k = 1; k <= index->count(); ++k) {
+							nodes.push_back(index->select(k));
+						}
+					}
+				}
+			}
+			// ranked Nodes first, in rank order, so loading the image allocates neighbours together
+			std::stable_sort(nodes.begin(), nodes.end(), [](gk::Node* a, gk::Node* b) {
+				return 0 <= a->rank() && (0 > b->rank() || a->rank() < b->rank());
+			});
+			return nodes;
+		});
+	}
+	return state_->store;
 }
 
 void gk::Coordinator::sync(v8::Isolate* isolate) noexcept {
-	// should only sync once across instances
-	if (!synched_) {
-		synched_ = true;
+	// should only sync once across the instances of a data directory
+	if (!state_->synched) {
+		state_->synched = true;
 
-		std::string dir (GK_FS_DB_DIR);
-		uv_fs_t mkdir_req;
-		uv_fs_mkdir(uv_default_loop(), &mkdir_req, ("./" + dir).c_str(), S_IRWXU, NULL);
+		// loading must not record the Nodes again
+		store()->suspend(true);
 
-		// scan through the data directory and insert the Nodes.
+		auto& dir = state_->path;
+		// Node files of the older one file per Node format, read and parsed in parallel
+		gk::Loader files;
 		uv_fs_t scandir_req;
-		uv_fs_scandir(uv_default_loop(), &scandir_req, ("./" + dir).c_str(), O_CREAT | O_RDWR, NULL);
+		uv_fs_scandir(uv_default_loop(), &scandir_req, dir.c_str(), 0, NULL);
 		uv_dirent_t dent;
-		assert(scandir_req.fs_type == UV_FS_SCANDIR);
-		assert(scandir_req.path);
-		assert(memcmp(scandir_req.path, ("./" + dir + "\0").c_str(), 8) == 0);
-
-		// create a buffer
 		std::string dat = ".gk";
-		while (UV_EOF != uv_fs_scandir_next(&scandir_req, &dent)) {
-			assert(dent.type == UV_DIRENT_FILE || dent.type == UV_DIRENT_UNKNOWN);
-
-			std::string dirname = "./" + dir + "/" + std::string(dent.name);
-			if (dirname.compare(dirname.length() - 3, 3, dat) == 0) {
-				// open the file
-				uv_fs_t open_req;
-				uv_fs_open(uv_default_loop(), &open_req, dirname.c_str(), O_RDONLY, 0, NULL);
-
-				char buf[4096];
-				uv_buf_t iov = uv_buf_init(buf, sizeof(buf));
-
-				// read in file.
-				uv_fs_t read_req;
-				uv_fs_read(uv_default_loop(), &read_req, open_req.result, &iov, 1, -1, NULL);
-
-				// cleanup file if empty
-				if (0 == read_req.result) {
-					uv_fs_t unlink_req;
-					uv_fs_unlink(uv_default_loop(), &unlink_req, dirname.c_str(), NULL);
-					uv_fs_req_cleanup(&unlink_req);
-					continue;
-				}
-
-				auto json = nlohmann::json::parse(buf);
-				auto nodeClass = gk::NodeClassFromInt(json["nodeClass"].get<short>());
-				if  (nodeClass == gk::NodeClass::Entity) {
-					// insert the nodes into the Graph.
-					auto entity = gk::Entity::Instance(isolate, json["type"].get<std::string>().c_str());
-					entity->id(json["id"].get<long long>());
-					entity->indexed(true);
-					insertNode(isolate, entity);
-
-					// groups
-					for (auto name : json["groups"]) {
-						std::string *v = new std::string(name.get<std::string>());
-						entity->groups()->insert(*v, v);
-						insertGroup(isolate, *v, entity);
-					}
-
-					// properties
-					for (auto property : json["properties"]) {
-						std::string *v = new std::string(property[1].get<std::string>());
-						entity->properties()->insert(property[0].get<std::string>(), v);
-					}
-				} else if (nodeClass == gk::NodeClass::Action) {
-					// insert the nodes into the Graph.
-					auto action = gk::Action<gk::Entity>::Instance(isolate, json["type"].get<std::string>().c_str());
-					action->id(json["id"].get<long long>());
-					action->indexed(true);
-					insertNode(isolate, action);
-
-					// groups
-					for (auto name : json["groups"]) {
-						std::string* v = new std::string(name.get<std::string>());
-						action->groups()->insert(*v, v);
-						insertGroup(isolate, *v, action);
-					}
-
-					// properties
-					for (auto property : json["properties"]) {
-						std::string* v = new std::string(property[1].get<std::string>());
-						action->properties()->insert(property[0].get<std::string>(), v);
-					}
-
-					for (auto subject : json["subjects"]) {
-						if (subject.is_object()) {
-							auto cluster = nodeGraph()->findByKey(gk::NodeClassFromInt(subject["nodeClass"].get<short>()));
-							if (cluster && 0 < cluster->count()) {
-								auto index = cluster->findByKey(subject["type"].get<std::string>());
-								if (index && 0 < index->count()) {
-									auto node = index->findByKey(subject["id"].get<long long>());
-									if (node) {
-										action->addSubject(isolate, dynamic_cast<gk::Entity*>(node));
-									}
-								}
-							}
-						}
-					}
+		while (0 == uv_fs_scandir_next(&scandir_req, &dent)) {
+			std::string name = dir + "/" + std::string(dent.name);
+			if (name.compare(name.length() - 3, 3, dat) == 0) {
+				files.file(name);
+			}
+		}
+		uv_fs_req_cleanup(&scandir_req);
+		files.parse();
+		files.apply(isolate, this);
+
+		// then the latest checkpoint and the log written after it
+		gk::Loader log;
+		store()->replay([&](const std::string& checkpoint) {
+			return gk::Snapshot::load(isolate, this, checkpoint);
+		}, [&](const std::string& segment) {
+			log.segment(segment);
+		});
+		log.parse();
+		log.apply(isolate, this);
+		store()->suspend(false);
+	}
+}
 
-					for (auto object : json["objects"]) {
-						if (object.is_object()) {
-							auto cluster = nodeGraph()->findByKey(gk::NodeClassFromInt(object["nodeClass"].get<short>()));
-							if (cluster && 0 < cluster->count()) {
-								auto index = cluster->findByKey(object["type"].get<std::string>());
-								if (index && 0 < index->count()) {
-									auto node = index->findByKey(object["id"].get<long long>());
-									if (node) {
-										action->addObject(isolate, dynamic_cast<gk::Entity*>(node));
-									}
-								}
-							}
-						}
-					}
-				} else if (nodeClass == gk::NodeClass::Bond) {
-					// insert the nodes into the Graph.
-					auto bond = gk::Bond<gk::Entity>::Instance(isolate, json["type"].get<std::string>().c_str());
-					bond->id(json["id"].get<long long>());
-					bond->indexed(true);
-					insertNode(isolate, bond);
-
-					// groups
-					for (auto name : json["groups"]) {
-						std::string *v = new std::string(name.get<std::string>());
-						bond->groups()->insert(*v, v);
-						insertGroup(isolate, *v, bond);
-					}
+bool gk::Coordinator::insertNode(v8::Isolate* isolate, gk::Coordinator::Node* node) noexcept {
+	auto cluster = this->cluster(isolate, node->nodeClass());
+	if (!cluster) {
+		return false;
+	}
 
-					// properties
-					for (auto property : json["properties"]) {
-						std::string *v = new std::string(property[1].get<std::string>());
-						bond->properties()->insert(property[0].get<std::string>(), v);
-					}
+	// the Node logs its changes to the Graph it is inserted into
+	if (!node->indexed()) {
+		node->coordinator(shared());
+	}
+	return cluster->insert(isolate, node);
+}
 
-					auto subject = json["subject"];
-					if (subject.is_object()) {
-						auto cluster = nodeGraph()->findByKey(gk::NodeClassFromInt(subject["nodeClass"].get<short>()));
-						if (cluster && 0 < cluster->count()) {
-							auto index = cluster->findByKey(subject["type"].get<std::string>());
-							if (index && 0 < index->count()) {
-								auto node = index->findByKey(subject["id"].get<long long>());
-								if (node) {
-									bond->subject(isolate, dynamic_cast<gk::Entity*>(node));
-								}
-							}
-						}
-					}
+std::size_t gk::Coordinator::insertNodes(v8::Isolate* isolate, const std::vector<gk::Coordinator::Node*>& nodes) noexcept {
+	// the Nodes of each type in their given order
+	std::map<std::pair<int, IndexKey>, std::vector<Node*>> types;
+	for (auto node : nodes) {
+		if (!node->indexed()) {
+			types[{gk::NodeClassToInt(node->nodeClass()), node->type()}].push_back(node);
+		}
+	}
 
-					auto object = json["object"];
-					if (object.is_object()) {
-						auto cluster = nodeGraph()->findByKey(gk::NodeClassFromInt(object["nodeClass"].get<short>()));
-						if (cluster && 0 < cluster->count()) {
-							auto index = cluster->findByKey(object["type"].get<std::string>());
-							if (index && 0 < index->count()) {
-								auto node = index->findByKey(object["id"].get<long long>());
-								if (node) {
-									bond->object(isolate, dynamic_cast<gk::Entity*>(node));
-								}
-							}
-						}
-					}
+	std::size_t inserted = 0;
+	for (auto& type : types) {
+		auto& group = type.second;
+		auto cluster = this->cluster(isolate, group.front()->nodeClass());
+		auto index = cluster ? cluster->index(isolate, type.first.second) : nullptr;
+		if (!index) {
+			continue;
+		}
+		for (auto node : group) {
+			node->coordinator(shared());
+		}
+		inserted += index->insert(group);
+		for (auto node : group) {
+			if (node->indexed()) {
+				auto groups = node->groups();
+				for (auto i = groups->count(); 0 < i; --i) {
+					insertGroup(isolate, *groups->select(i), node);
 				}
-
-				// close the directory
-				uv_fs_t close_req;
-				uv_fs_close(uv_default_loop(), &close_req, open_req.result, NULL);
-
-				// cleanup
-				uv_fs_req_cleanup(&open_req);
-				uv_fs_req_cleanup(&read_req);
-				uv_fs_req_cleanup(&close_req);
 			}
 		}
-
-		// cleanup
-		uv_fs_req_cleanup(&scandir_req);
-		uv_fs_req_cleanup(&mkdir_req);
 	}
+	return inserted;
 }
 
-bool gk::Coordinator::insertNode(v8::Isolate* isolate, gk::Coordinator::Node* node) noexcept {
-	auto cluster = nodeGraph()->findByKey(node->nodeClass());
+gk::Coordinator::Cluster* gk::Coordinator::cluster(v8::Isolate* isolate, const ClusterKey& cKey) noexcept {
+	auto cluster = nodeGraph()->findByKey(cKey);
 	if (!cluster) {
-		auto nodeClass = node->nodeClass();
-		cluster = Cluster::Instance(isolate, nodeClass);
+		auto nodeClass = cKey;
+		cluster = Cluster::Instance(isolate, nodeClass, state_->path);
 		if (!nodeGraph()->insert(nodeClass, cluster, [](Cluster* cluster) {
 			cluster->Ref();
 		})) {
-			return false;
+			return nullptr;
 		}
 	}
-	return cluster->insert(isolate, node);
+	return cluster;
 }
 
 bool gk::Coordinator::removeNode(const ClusterKey& cKey, const IndexKey& iKey, const NodeKey& nKey) noexcept {
@@ -271,6 +299,65 @@ bool gk::Coordinator::removeNode(const ClusterKey& cKey, const IndexKey& iKey, c
 	return false;
 }
 
+bool gk::Coordinator::dropType(const ClusterKey& cKey, const IndexKey& iKey) noexcept {
+	auto cluster = nodeGraph()->findByKey(cKey);
+	auto index = cluster ? cluster->findByKey(iKey) : nullptr;
+	if (!index) {
+		return false;
+	}
+
+	// the Cluster reference passes to the release
+	auto type = iKey;
+	cluster->gk::RedBlackTree<gk::Index, true, std::string>::remove(type, [](gk::Index* index) {});
+	store()->drop(cKey, type);
+	release(index);
+	return true;
+}
+
+bool gk::Coordinator::dropCluster(const ClusterKey& cKey) noexcept {
+	auto cluster = nodeGraph()->findByKey(cKey);
+	if (!cluster) {
+		return false;
+	}
+	while (0 < cluster->count()) {
+		dropType(cKey, cluster->back()->type());
+	}
+	return nodeGraph()->remove(cKey, [](Cluster* cluster) {
+		cluster->Unref();
+	});
+}
+
+void gk::Coordinator::release(gk::Index* index) noexcept {
+	struct Release {
+		uv_idle_t idler;
+		gk::Index* index;
+		std::shared_ptr<gk::Coordinator> coordinator;
+	};
+
+	auto release = new Release{{}, index, shared()};
+	uv_idle_init(uv_default_loop(), &release->idler);
+	release->idler.data = release;
+	uv_idle_start(&release->idler, [](uv_idle_t* idler) {
+		GK_SCOPE();
+		auto release = static_cast<Release*>(idler->data);
+		auto coordinator = release->coordinator;
+		release->index->release(GK_COORDINATOR_DROP_CHUNK, [&](Node* node) {
+			auto groups = node->groups();
+			for (auto i = groups->count(); 0 < i; --i) {
+				coordinator->removeGroup(*groups->select(i), node->hash());
+			}
+		});
+		if (0 < release->index->count()) {
+			return;
+		}
+		uv_idle_stop(idler);
+		release->index->Unref();
+		uv_close(reinterpret_cast<uv_handle_t*>(idler), [](uv_handle_t* handle) {
+			delete static_cast<Release*>(handle->data);
+		});
+	});
+}
+
 bool gk::Coordinator::insertGroup(v8::Isolate* isolate, std::string& group, gk::Coordinator::Node* node) noexcept {
 	auto set = groupGraph()->findByKey(group);
 	if (!set) {
@@ -19,12 +19,16 @@
 #ifndef GRAPHKIT_SRC_COORDINATOR_H
 #define GRAPHKIT_SRC_COORDINATOR_H
 
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include "RedBlackTree.h"
 #include "Cluster.h"
 #include "Node.h"
 #include "Set.h"
+#include "Store.h"
 
 namespace gk {
 	class Coordinator {
@@ -32,10 +36,19 @@ namespace gk {
 
 		/**
 		* Coordinator
-		* Constructor.
+		* Constructor, coordinates the Graph of the default data directory.
 		*/
 		Coordinator() noexcept;
 
+		/**
+		* Coordinator
+		* Explicit Constructor, coordinates the Graph of a data directory.
+		* Every Coordinator of the same directory shares its Graph and log,
+		* those of other directories are independent.
+		* @param		const std::string& path
+		*/
+		explicit Coordinator(const std::string& path) noexcept;
+
 		/**
 		* ~Coordinator
 		* Destructor.
@@ -43,9 +56,9 @@ namespace gk {
 		virtual ~Coordinator();
 
 		// defaults
-		Coordinator(const Coordinator& other) = default;
+		Coordinator(const Coordinator&) = default;
 		Coordinator& operator= (const Coordinator&) = default;
-		Coordinator(Coordinator&& other) = default;
+		Coordinator(Coordinator&&) = default;
 		Coordinator& operator= (Coordinator&&) = default;
 
 		// aliases
@@ -67,6 +80,27 @@ namespace gk {
 		*/
 		void sync(v8::Isolate* isolate) noexcept;
 
+		/**
+		* synched
+		* Whether the Graph was loaded from disk.
+		* @return		bool
+		*/
+		bool synched() const noexcept;
+
+		/**
+		* path
+		* The data directory of the Graph.
+		* @return		const std::string&
+		*/
+		const std::string& path() const noexcept;
+
+		/**
+		* shared
+		* A Coordinator of the same Graph for Nodes to hold.
+		* @return		std::shared_ptr<gk::Coordinator>
+		*/
+		std::shared_ptr<gk::Coordinator> shared() noexcept;
+
 		/**
 		* nodeGraph
 		* Lazy loader for a nodeGraph instance.
@@ -90,6 +124,25 @@ namespace gk {
 		*/
 		bool insertNode(v8::Isolate* isolate, Node* node) noexcept;
 
+		/**
+		* insertNodes
+		* Inserts many Nodes into the Node Graph, looking up the Cluster and
+		* Index once per type.
+		* @param		v8::Isolate* isolate
+		* @param		const std::vector<Node*>& nodes
+		* @return		std::size_t, the number of Nodes inserted
+		*/
+		std::size_t insertNodes(v8::Isolate* isolate, const std::vector<Node*>& nodes) noexcept;
+
+		/**
+		* cluster
+		* Finds the Cluster of a NodeClass, creating it if needed.
+		* @param		v8::Isolate* isolate
+		* @param		const ClusterKey& cKey
+		* @return		Cluster*, nullptr if it could not be created
+		*/
+		Cluster* cluster(v8::Isolate* isolate, const ClusterKey& cKey) noexcept;
+
 		/**
 		* removeNode
 		* Removes a Node from the Node Graph.
@@ -100,6 +153,25 @@ namespace gk {
 		*/
 		bool removeNode(const ClusterKey& cKey, const IndexKey& iKey, const NodeKey& nKey) noexcept;
 
+		/**
+		* dropType
+		* Drops every Node of a type. The Index is detached at once and a
+		* single record is logged, its Nodes and group memberships are
+		* released in the background.
+		* @param		const ClusterKey& cKey
+		* @param		const IndexKey& iKey
+		* @return		A boolean if the type was dropped, or false otherwise.
+		*/
+		bool dropType(const ClusterKey& cKey, const IndexKey& iKey) noexcept;
+
+		/**
+		* dropCluster
+		* Drops every Node of a NodeClass, one type at a time.
+		* @param		const ClusterKey& cKey
+		* @return		A boolean if the Cluster was dropped, or false otherwise.
+		*/
+		bool dropCluster(const ClusterKey& cKey) noexcept;
+
 		/**
 		* insertGroup
 		* Inserts a Node into the Group Graph.
@@ -119,10 +191,51 @@ namespace gk {
 		*/
 		bool removeGroup(const SetKey& sKey, const NodeHash& nHash) noexcept;
 
+		/**
+		* store
+		* Lazy loader for the log of the data directory, shared across
+		* instances. Pending records are written when the process exits.
+		* @return		std::shared_ptr<gk::Store>
+		*/
+		std::shared_ptr<gk::Store> store() noexcept;
+
+		/**
+		* close
+		* Writes the pending records and closes the log, then releases the
+		* Graph of the data directory. The Graph stays empty and logs
+		* nothing, a new Coordinator of the directory loads it again.
+		*/
+		void close() noexcept;
+
 	private:
-		static bool synched_;
-		static std::shared_ptr<NodeGraph> nodeGraph_;
-		static std::shared_ptr<GroupGraph> groupGraph_;
+		struct State {
+			std::string path;
+			bool synched;
+			std::shared_ptr<NodeGraph> nodeGraph;
+			std::shared_ptr<GroupGraph> groupGraph;
+			std::shared_ptr<gk::Store> store;
+			std::weak_ptr<gk::Coordinator> handle;
+		};
+
+		std::shared_ptr<State> state_;
+
+		/**
+		* clear
+		* Forgets the State unless a newer one replaced it, and releases
+		* its Node and Group Graphs.
+		*/
+		void clear() noexcept;
+
+		/**
+		* release
+		* Releases the Nodes of a dropped Index a chunk per loop iteration,
+		* then the Index itself.
+		* @param		gk::Index* index
+		*/
+		void release(gk::Index* index) noexcept;
+
+		// the live Graphs by their resolved data directory
+		static std::map<std::string, std::weak_ptr<State>> states_;
 	};
 }
 
@@ -0,0 +1,294 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Encoder.h"
+#include "Node.h"
+
+// the ASCII record separator, JSON records start with a brace and frames with 0x1f
+static const char GK_ENCODER_MARK = '\x1e';
+
+// the mark and the length
+static const std::size_t GK_ENCODER_HEADER = 5;
+
+// names remembered between batches, the table is let go once it grows past this
+static const std::size_t GK_ENCODER_SYMBOLS = 1 << 16;
+
+gk::Encoder::Encoder(gk::Encoder* shared) noexcept
+	: symbols_{},
+	  used_{},
+	  epoch_{1},
+	  shared_{shared},
+	  mutex_{} {}
+
+std::size_t gk::Encoder::open(std::string& out, gk::Mutation mutation) noexcept {
+	auto at = out.size();
+	out.append(GK_ENCODER_HEADER, GK_ENCODER_MARK);
+	out += static_cast<char>(mutation);
+	return at;
+}
+
+void gk::Encoder::close(std::string& out, std::size_t at) noexcept {
+	auto length = static_cast<uint32_t>(out.size() - at - GK_ENCODER_HEADER);
+	for (std::size_t i = 1; i < GK_ENCODER_HEADER; ++i, length >>= 8) {
+		out[at + i] = static_cast<char>(length & 255);
+	}
+}
+
+void gk::Encoder::count(std::string& out, uint64_t value) noexcept {
+	for (; 0x80 <= value; value >>= 7) {
+		out += static_cast<char>(0x80 | (value & 0x7f));
+	}
+	out += static_cast<char>(value);
+}
+
+void gk::Encoder::number(std::string& out, long long value) noexcept {
+	count(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void gk::Encoder::string(std::string& out, const std::string& value) noexcept {
+	count(out, value.length());
+	out += value;
+}
+
+void gk::Encoder::symbol(std::string& out, const std::string& name) noexcept {
+	if (nullptr == shared_) {
+		count(out, id(name));
+		return;
+	}
+
+	// a worker caches the ids of the shared batch and only locks for the names it has not seen in it
+	auto epoch = shared_->epoch_;
+	auto it = symbols_.find(name);
+	if (symbols_.end() == it || epoch != it->second.second) {
+		uint32_t id;
+		{
+			std::lock_guard<std::mutex> lock{shared_->mutex_};
+			id = shared_->id(name);
+		}
+		if (symbols_.end() == it) {
+			if (GK_ENCODER_SYMBOLS < symbols_.size()) {
+				symbols_.clear();
+			}
+			it = symbols_.emplace(name, std::make_pair(0u, 0u)).first;
+		}
+		it->second = std::make_pair(id, epoch);
+	}
+	count(out, it->second.first);
+}
+
+uint32_t gk::Encoder::id(const std::string& name) noexcept {
+	auto it = symbols_.find(name);
+	if (symbols_.end() == it) {
+		it = symbols_.emplace(name, std::make_pair(0u, 0u)).first;
+	}
+
+	// the first use in a batch gives the name the next id of its table
+	auto& symbol = it->second;
+	if (epoch_ != symbol.second) {
+		symbol.first = static_cast<uint32_t>(used_.size());
+		symbol.second = epoch_;
+		used_.push_back(&it->first);
+	}
+	return symbol.first;
+}
+
+void gk::Encoder::reference(std::string& out, gk::Node* node) noexcept {
+	if (nullptr == node) {
+		count(out, GK_SYMBOL_NODE_CLASS_NODE_CONSTANT);
+		return;
+	}
+	count(out, gk::NodeClassToInt(node->nodeClass()));
+	symbol(out, node->type());
+	number(out, node->id());
+}
+
+void gk::Encoder::insert(std::string& out, gk::Node* node) noexcept {
+	auto at = open(out, gk::Mutation::Insert);
+	reference(out, node);
+	node->encode(*this, out);
+	close(out, at);
+}
+
+void gk::Encoder::record(std::string& out, gk::Mutation mutation, gk::Node* node, const std::string& key, const std::string& value) noexcept {
+	auto at = open(out, mutation);
+	reference(out, node);
+	symbol(out, key);
+	string(out, value);
+	close(out, at);
+}
+
+void gk::Encoder::record(std::string& out, gk::Mutation mutation, gk::Node* node, gk::Node* target) noexcept {
+	auto at = open(out, mutation);
+	reference(out, node);
+	reference(out, target);
+	close(out, at);
+}
+
+void gk::Encoder::update(std::string& out, gk::Node* node, const std::map<std::string, std::pair<bool, std::string>>& changes) noexcept {
+	auto at = open(out, gk::Mutation::Update);
+	reference(out, node);
+	std::size_t sets = 0;
+	for (auto& change : changes) {
+		sets += change.second.first;
+	}
+	count(out, sets);
+	for (auto& change : changes) {
+		if (change.second.first) {
+			symbol(out, change.first);
+			string(out, change.second.second);
+		}
+	}
+	count(out, changes.size() - sets);
+	for (auto& change : changes) {
+		if (!change.second.first) {
+			symbol(out, change.first);
+		}
+	}
+	close(out, at);
+}
+
+void gk::Encoder::drop(std::string& out, const gk::NodeClass& nodeClass, const std::string& type) noexcept {
+	auto at = open(out, gk::Mutation::Drop);
+	count(out, gk::NodeClassToInt(nodeClass));
+	symbol(out, type);
+	number(out, 0);
+	close(out, at);
+}
+
+void gk::Encoder::table(std::string& out) noexcept {
+	if (!used_.empty()) {
+		auto at = open(out, gk::Mutation::Symbols);
+		count(out, used_.size());
+		for (auto name : used_) {
+			string(out, *name);
+		}
+		close(out, at);
+	}
+	reset();
+}
+
+void gk::Encoder::reset() noexcept {
+	used_.clear();
+	++epoch_;
+	if (GK_ENCODER_SYMBOLS < symbols_.size()) {
+		symbols_.clear();
+	}
+}
+
+gk::Decoder::Decoder(const char* data, std::size_t size, const std::vector<std::string>* symbols) noexcept
+	: p_{reinterpret_cast<const unsigned char*>(data)},
+	  end_{reinterpret_cast<const unsigned char*>(data) + size},
+	  symbols_{symbols} {}
+
+bool gk::Decoder::done() const noexcept {
+	return p_ == end_;
+}
+
+bool gk::Decoder::mutation(gk::Mutation& out) noexcept {
+	if (p_ == end_ || static_cast<unsigned>(gk::Mutation::Symbols) < *p_) {
+		return false;
+	}
+	out = static_cast<gk::Mutation>(*p_++);
+	return true;
+}
+
+bool gk::Decoder::count(uint64_t& out) noexcept {
+	out = 0;
+	for (unsigned shift = 0; p_ < end_ && 64 > shift; shift += 7) {
+		auto b = *p_++;
+		out |= static_cast<uint64_t>(b & 0x7f) << shift;
+		if (0 == (b & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool gk::Decoder::number(long long& out) noexcept {
+	uint64_t v;
+	if (!count(v)) {
+		return false;
+	}
+	out = static_cast<long long>((v >> 1) ^ (~(v & 1) + 1));
+	return true;
+}
+
+bool gk::Decoder::string(std::string& out) noexcept {
+	uint64_t length;
+	if (!count(length) || length > static_cast<uint64_t>(end_ - p_)) {
+		return false;
+	}
+	out.assign(reinterpret_cast<const char*>(p_), length);
+	p_ += length;
+	return true;
+}
+
+bool gk::Decoder::symbol(std::string& out) noexcept {
+	uint64_t id;
+	if (!count(id) || nullptr == symbols_ || id >= symbols_->size()) {
+		return false;
+	}
+	out = (*symbols_)[id];
+	return true;
+}
+
+bool gk::Decoder::record(gk::Decoder& out) noexcept {
+	const char* payload;
+	std::size_t length;
+	std::size_t used;
+	if (!record(reinterpret_cast<const char*>(p_), end_ - p_, payload, length, used)) {
+		return false;
+	}
+	out = gk::Decoder{payload, length, symbols_};
+	p_ += used;
+	return true;
+}
+
+bool gk::Decoder::marked(const char* data, std::size_t size) noexcept {
+	return 0 < size && GK_ENCODER_MARK == *data;
+}
+
+bool gk::Decoder::record(const char* data, std::size_t size, const char*& payload, std::size_t& length, std::size_t& used) noexcept {
+	if (GK_ENCODER_HEADER > size || !marked(data, size)) {
+		return false;
+	}
+	auto p = reinterpret_cast<const unsigned char*>(data);
+	length = static_cast<std::size_t>(p[1]) | static_cast<std::size_t>(p[2]) << 8 | static_cast<std::size_t>(p[3]) << 16 | static_cast<std::size_t>(p[4]) << 24;
+	if (0 == length || length > size - GK_ENCODER_HEADER) {
+		return false;
+	}
+	payload = data + GK_ENCODER_HEADER;
+	used = GK_ENCODER_HEADER + length;
+	return true;
+}
+
+bool gk::Decoder::table(const char* payload, std::size_t length, std::vector<std::string>& out) noexcept {
+	gk::Decoder decoder{payload, length, nullptr};
+	gk::Mutation mutation;
+	uint64_t n;
+	if (!decoder.mutation(mutation) || gk::Mutation::Symbols != mutation || !decoder.count(n) || n > length) {
+		return false;
+	}
+	out.resize(n);
+	for (auto& name : out) {
+		if (!decoder.string(name)) {
+			return false;
+		}
+	}
+	return decoder.done();
+}
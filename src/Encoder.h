@@ -0,0 +1,308 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Encoder.h
+*
+* The binary format of log records. A record is a mark byte, its length
+* as 4 little endian bytes and its payload, the mutation as a byte and its
+* fields. Numbers are varints, strings are length prefixed and written as
+* is, types, groups and property keys are symbols, ids into a table of
+* names. Every batch written to the log starts with the table of the
+* symbols it uses, so each one can be read on its own. The mark byte is
+* one no JSON record starts with, so binary records follow the plain ones
+* of older segments.
+*
+* Records are appended to a caller owned buffer in one pass, nothing is
+* allocated once the buffer and the table have grown to their working size.
+* An Encoder made over a shared one takes its ids from the shared table,
+* so records encoded on several threads into their own buffers can be
+* written after a single table.
+*/
+
+#ifndef GRAPHKIT_SRC_ENCODER_H
+#define GRAPHKIT_SRC_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Mutation.h"
+#include "NodeClass.h"
+
+namespace gk {
+	class Node;
+
+	class Encoder {
+	public:
+
+		/**
+		* Encoder
+		* Explicit Constructor, a shared Encoder assigns the ids of its symbols.
+		* @param		gk::Encoder* shared, nullptr for its own table
+		*/
+		explicit Encoder(gk::Encoder* shared = nullptr) noexcept;
+
+		// defaults
+		Encoder(const Encoder&) = delete;
+		Encoder& operator= (const Encoder&) = delete;
+		Encoder(Encoder&&) = delete;
+		Encoder& operator= (Encoder&&) = delete;
+
+		/**
+		* open
+		* Starts a record, its length is written when it is closed.
+		* @param		std::string& out
+		* @param		gk::Mutation mutation
+		* @return		std::size_t, the position of the record
+		*/
+		std::size_t open(std::string& out, gk::Mutation mutation) noexcept;
+
+		/**
+		* close
+		* Ends the record started at a position.
+		* @param		std::string& out
+		* @param		std::size_t at
+		*/
+		void close(std::string& out, std::size_t at) noexcept;
+
+		/**
+		* count
+		* Appends an unsigned varint.
+		* @param		std::string& out
+		* @param		uint64_t value
+		*/
+		void count(std::string& out, uint64_t value) noexcept;
+
+		/**
+		* number
+		* Appends a signed varint.
+		* @param		std::string& out
+		* @param		long long value
+		*/
+		void number(std::string& out, long long value) noexcept;
+
+		/**
+		* string
+		* Appends a length prefixed string.
+		* @param		std::string& out
+		* @param		const std::string& value
+		*/
+		void string(std::string& out, const std::string& value) noexcept;
+
+		/**
+		* symbol
+		* Appends the id of a name, adding it to the table of the batch.
+		* @param		std::string& out
+		* @param		const std::string& name
+		*/
+		void symbol(std::string& out, const std::string& name) noexcept;
+
+		/**
+		* reference
+		* Appends the class, type and id of a Node, a null Node has class 0.
+		* @param		std::string& out
+		* @param		gk::Node* node
+		*/
+		void reference(std::string& out, gk::Node* node) noexcept;
+
+		/**
+		* insert
+		* Appends the image of a Node.
+		* @param		std::string& out
+		* @param		gk::Node* node
+		*/
+		void insert(std::string& out, gk::Node* node) noexcept;
+
+		/**
+		* record
+		* Appends a change of a Node with a key and a value.
+		* @param		std::string& out
+		* @param		gk::Mutation mutation
+		* @param		gk::Node* node
+		* @param		const std::string& key
+		* @param		const std::string& value
+		*/
+		void record(std::string& out, gk::Mutation mutation, gk::Node* node, const std::string& key, const std::string& value) noexcept;
+
+		/**
+		* record
+		* Appends a change of a relationship between two Nodes.
+		* @param		std::string& out
+		* @param		gk::Mutation mutation
+		* @param		gk::Node* node
+		* @param		gk::Node* target
+		*/
+		void record(std::string& out, gk::Mutation mutation, gk::Node* node, gk::Node* target) noexcept;
+
+		/**
+		* update
+		* Appends the last change of each property of a Node, true marks a set.
+		* @param		std::string& out
+		* @param		gk::Node* node
+		* @param		const std::map<std::string, std::pair<bool, std::string>>& changes
+		*/
+		void update(std::string& out, gk::Node* node, const std::map<std::string, std::pair<bool, std::string>>& changes) noexcept;
+
+		/**
+		* drop
+		* Appends the drop of every Node of a type.
+		* @param		std::string& out
+		* @param		const gk::NodeClass& nodeClass
+		* @param		const std::string& type
+		*/
+		void drop(std::string& out, const gk::NodeClass& nodeClass, const std::string& type) noexcept;
+
+		/**
+		* table
+		* Appends the table of the symbols used since the last one and starts
+		* a new batch.
+		* @param		std::string& out
+		*/
+		void table(std::string& out) noexcept;
+
+		/**
+		* reset
+		* Starts a new batch without writing the table.
+		*/
+		void reset() noexcept;
+
+	protected:
+		/**
+		* id
+		* The id of a name in the table of the batch, given on its first use.
+		* @param		const std::string& name
+		* @return		uint32_t
+		*/
+		uint32_t id(const std::string& name) noexcept;
+
+		std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> symbols_;
+		std::vector<const std::string*> used_;
+		uint32_t epoch_;
+		gk::Encoder* shared_;
+		std::mutex mutex_;
+	};
+
+	class Decoder {
+	public:
+
+		/**
+		* Decoder
+		* Constructor, reads a payload resolving symbols in a table.
+		* @param		const char* data
+		* @param		std::size_t size
+		* @param		const std::vector<std::string>* symbols
+		*/
+		Decoder(const char* data, std::size_t size, const std::vector<std::string>* symbols) noexcept;
+
+		/**
+		* done
+		* Whether the whole payload was read.
+		* @return		bool
+		*/
+		bool done() const noexcept;
+
+		/**
+		* mutation
+		* Reads the mutation of a record.
+		* @param		gk::Mutation& out
+		* @return		bool
+		*/
+		bool mutation(gk::Mutation& out) noexcept;
+
+		/**
+		* count
+		* Reads an unsigned varint.
+		* @param		uint64_t& out
+		* @return		bool
+		*/
+		bool count(uint64_t& out) noexcept;
+
+		/**
+		* number
+		* Reads a signed varint.
+		* @param		long long& out
+		* @return		bool
+		*/
+		bool number(long long& out) noexcept;
+
+		/**
+		* string
+		* Reads a length prefixed string.
+		* @param		std::string& out
+		* @return		bool
+		*/
+		bool string(std::string& out) noexcept;
+
+		/**
+		* symbol
+		* Reads a symbol and resolves its name.
+		* @param		std::string& out
+		* @return		bool, false if the id is not in the table
+		*/
+		bool symbol(std::string& out) noexcept;
+
+		/**
+		* record
+		* Reads the nested record at the current position.
+		* @param		gk::Decoder& out, reads its payload with the same table
+		* @return		bool
+		*/
+		bool record(gk::Decoder& out) noexcept;
+
+		/**
+		* marked
+		* Whether a binary record starts at data.
+		* @param		const char* data
+		* @param		std::size_t size
+		* @return		bool
+		*/
+		static bool marked(const char* data, std::size_t size) noexcept;
+
+		/**
+		* record
+		* Finds the payload of the binary record at data.
+		* @param		const char* data
+		* @param		std::size_t size
+		* @param		const char*& payload
+		* @param		std::size_t& length
+		* @param		std::size_t& used, the bytes of the record
+		* @return		bool, false if the record is torn
+		*/
+		static bool record(const char* data, std::size_t size, const char*& payload, std::size_t& length, std::size_t& used) noexcept;
+
+		/**
+		* table
+		* Reads the names of a symbol table record.
+		* @param		const char* payload
+		* @param		std::size_t length
+		* @param		std::vector<std::string>& out
+		* @return		bool, false if the payload is not a table
+		*/
+		static bool table(const char* payload, std::size_t length, std::vector<std::string>& out) noexcept;
+
+	protected:
+		const unsigned char* p_;
+		const unsigned char* end_;
+		const std::vector<std::string>* symbols_;
+	};
+}
+
+#endif
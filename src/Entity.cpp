@@ -17,6 +17,7 @@
 */
 
 #include <iostream>
+#include <memory>
 #include <utility>
 #include <uv.h>
 #include "Entity.h"
@@ -56,16 +57,30 @@ gk::Set* gk::Entity::actions(v8::Isolate* isolate) noexcept {
 	return actions_;
 }
 
+void gk::Entity::detach() noexcept {
+	if (nullptr != bonds_) {
+		bonds_->cleanUp();
+	}
+	if (nullptr != actions_) {
+		actions_->cleanUp();
+	}
+}
+
 std::string gk::Entity::toJSON() noexcept {
 	std::string json = "{\"id\":" + std::to_string(id()) +
 		",\"nodeClass\":" + std::to_string(gk::NodeClassToInt(nodeClass())) +
-		",\"type\":\"" + type() + "\"";
+		",\"type\":" + escape(type());
+
+	// store the locality rank, if reordered
+	if (0 <= rank()) {
+		json += ",\"rank\":" + std::to_string(rank());
+	}
 
 	// store properties
 	json += ",\"properties\":[";
 	for (auto i = properties()->count(); 0 < i; --i) {
 		auto q = properties_->node(i);
-		json += "[\"" + q->key() + "\",\"" + *q->data() + "\"]";
+		json += "[" + escape(q->key()) + "," + escape(*q->data()) + "]";
 		if (1 != i) {
 			json += ",";
 		}
@@ -74,7 +89,7 @@ std::string gk::Entity::toJSON() noexcept {
 	json += "],\"groups\":[";
 	// store groups
 	for (auto i = groups()->count(); 0 < i; --i) {
-		json += "\"" + *groups_->select(i) + "\"";
+		json += escape(*groups_->select(i));
 		if (1 != i) {
 			json += ",";
 		}
@@ -83,26 +98,6 @@ std::string gk::Entity::toJSON() noexcept {
 	return json;
 }
 
-void gk::Entity::persist() noexcept {
-	if (indexed()) {
-		std::string dir (GK_FS_DB_DIR);
-		uv_fs_t open_req;
-		uv_fs_open(uv_default_loop(), &open_req, ("./" + dir + "/" + hash() + ".gk").c_str(), O_CREAT | O_RDWR, S_IRWXU, NULL);
-		std::string json = toJSON();
-		int len = json.length() + 1;
-		char buf[len];
-		snprintf(buf, len, "%s", json.c_str());
-		uv_buf_t iov = uv_buf_init(buf, sizeof(buf));
-		uv_fs_t write_req;
-		uv_fs_write(uv_default_loop(), &write_req, open_req.result, &iov, 1, 0, NULL);
-		uv_fs_t close_req;
-		uv_fs_close(uv_default_loop(), &close_req, open_req.result, NULL);
-		uv_fs_req_cleanup(&open_req);
-		uv_fs_req_cleanup(&write_req);
-		uv_fs_req_cleanup(&close_req);
-	}
-}
-
 gk::Entity* gk::Entity::Instance(v8::Isolate* isolate, const char* type) noexcept {
 	const int argc = 1;
 	v8::Local<v8::Value> argv[argc] = {GK_STRING(type)};
@@ -222,12 +217,13 @@ GK_PROPERTY_SETTER(gk::Entity::PropertySetter) {
 
 	v8::String::Utf8Value v(value);
 	auto e = node::ObjectWrap::Unwrap<gk::Entity>(args.Holder());
-	e->properties()->remove(*p, [](std::string* v) {
-		delete v;
+	std::unique_ptr<std::string> prior;
+	e->properties()->remove(*p, [&](std::string* v) {
+		prior.reset(v);
 	});
 	auto result = e->properties()->insert(*p, new std::string{*v});
 	if (result) {
-		e->persist();
+		e->record(gk::Mutation::Set, *p, *v, prior.get());
 	}
 	GK_RETURN(GK_BOOLEAN(result));
 }
@@ -259,8 +255,8 @@ GK_PROPERTY_DELETER(gk::Entity::PropertyDeleter) {
 
 	auto e = node::ObjectWrap::Unwrap<gk::Entity>(args.Holder());
 	GK_RETURN(GK_BOOLEAN(e->properties()->remove(*p, [&](std::string* v) {
+		e->record(gk::Mutation::Delete, *p, "", v);
 		delete v;
-		e->persist();
 	})));
 }
 
@@ -77,6 +77,13 @@ namespace gk {
 		*/
 		gk::Set* actions(v8::Isolate* isolate) noexcept;
 
+		/**
+		* detach
+		* Lets go of the Bonds and Actions that point to this Entity
+		* Node, they hold it in turn.
+		*/
+		void detach() noexcept;
+
 		/**
 		* toJSON
 		* Outputs a JSON string of the Entity instance.
@@ -84,12 +91,6 @@ namespace gk {
 		*/
 		virtual std::string toJSON() noexcept;
 
-		/**
-		* persist
-		* Saves the Entity instance to disk.
-		*/
-		virtual void persist() noexcept;
-
 		/**
 		* Instance
 		* Constructs a new Entity instance through the v8 engine.
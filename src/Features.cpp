@@ -0,0 +1,121 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include "Features.h"
+#include "Entity.h"
+#include "Action.h"
+#include "Bond.h"
+
+// converts a stored property value, booleans become 1 and 0
+static float numeric(const std::string* v) {
+	if (nullptr == v) {
+		return std::numeric_limits<float>::quiet_NaN();
+	}
+	if (0 == v->compare("true")) {
+		return 1;
+	}
+	if (0 == v->compare("false")) {
+		return 0;
+	}
+	char* end;
+	auto d = strtod(v->c_str(), &end);
+	if (end == v->c_str() || '\0' != *end) {
+		return std::numeric_limits<float>::quiet_NaN();
+	}
+	return static_cast<float>(d);
+}
+
+// counts the incoming and outgoing relationships of a Node
+static void degrees(v8::Isolate* isolate, gk::Node* node, float& in, float& out) {
+	in = 0;
+	out = 0;
+	if (gk::NodeClass::Entity == node->nodeClass()) {
+		auto entity = dynamic_cast<gk::Entity*>(node);
+		auto bonds = entity->bonds(isolate);
+		for (auto i = bonds->count(); 0 < i; --i) {
+			auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(bonds->select(i));
+			if (entity == bond->subject()) {
+				++out;
+			}
+			if (entity == bond->object()) {
+				++in;
+			}
+		}
+		auto actions = entity->actions(isolate);
+		for (auto i = actions->count(); 0 < i; --i) {
+			auto action = dynamic_cast<gk::Action<gk::Entity>*>(actions->select(i));
+			if (action->subjects(isolate)->has(entity->hash())) {
+				++out;
+			}
+			if (action->objects(isolate)->has(entity->hash())) {
+				++in;
+			}
+		}
+	} else if (gk::NodeClass::Action == node->nodeClass()) {
+		auto action = dynamic_cast<gk::Action<gk::Entity>*>(node);
+		in = action->subjects(isolate)->count();
+		out = action->objects(isolate)->count();
+	} else if (gk::NodeClass::Bond == node->nodeClass()) {
+		auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(node);
+		in = nullptr == bond->subject() ? 0 : 1;
+		out = nullptr == bond->object() ? 0 : 1;
+	}
+}
+
+gk::Features::Features(const Options& options) noexcept
+	: options_{options} {}
+
+gk::Features::~Features() {}
+
+std::vector<std::string> gk::Features::columns() const noexcept {
+	std::vector<std::string> c{"id"};
+	c.insert(c.end(), options_.properties.begin(), options_.properties.end());
+	c.insert(c.end(), options_.groups.begin(), options_.groups.end());
+	if (options_.degrees) {
+		c.push_back("in");
+		c.push_back("out");
+	}
+	return c;
+}
+
+std::size_t gk::Features::width() const noexcept {
+	return 1 + options_.properties.size() + options_.groups.size() + (options_.degrees ? 2 : 0);
+}
+
+void gk::Features::write(v8::Isolate* isolate, gk::Index* index, float* out) const noexcept {
+	auto w = width();
+	for (auto i = index->count(); 0 < i; --i) {
+		auto node = index->select(i);
+		auto row = out + (i - 1) * w;
+		*row++ = static_cast<float>(node->id());
+		auto properties = node->properties();
+		for (auto& p : options_.properties) {
+			*row++ = numeric(properties->findByKey(p));
+		}
+		auto groups = node->groups();
+		for (auto& g : options_.groups) {
+			*row++ = groups->has(g) ? 1 : 0;
+		}
+		if (options_.degrees) {
+			degrees(isolate, node, row[0], row[1]);
+		}
+	}
+}
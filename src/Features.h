@@ -0,0 +1,96 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Features.h
+*
+* Writes a dense row major feature matrix for the Nodes of an Index. Each row
+* holds the Node id, the requested numeric properties, a one hot column per
+* requested group and optionally the in and out degrees.
+*/
+
+#ifndef GRAPHKIT_SRC_FEATURES_H
+#define GRAPHKIT_SRC_FEATURES_H
+
+#include <string>
+#include <vector>
+#include "exports.h"
+#include "Index.h"
+
+namespace gk {
+	class Features {
+	public:
+
+		/**
+		* Options
+		* The property and group columns, in order.
+		*/
+		struct Options {
+			std::vector<std::string> properties;
+			std::vector<std::string> groups;
+			bool degrees = false;
+		};
+
+		/**
+		* Features
+		* Constructor.
+		* @param		const Options& options
+		*/
+		explicit Features(const Options& options) noexcept;
+
+		/**
+		* ~Features
+		* Destructor.
+		*/
+		virtual ~Features();
+
+		// defaults
+		Features(const Features&) = default;
+		Features& operator= (const Features&) = default;
+		Features(Features&&) = default;
+		Features& operator= (Features&&) = default;
+
+		/**
+		* columns
+		* The column names of a row.
+		* @return		std::vector<std::string>
+		*/
+		std::vector<std::string> columns() const noexcept;
+
+		/**
+		* width
+		* The number of columns of a row.
+		* @return		std::size_t
+		*/
+		std::size_t width() const noexcept;
+
+		/**
+		* write
+		* Writes one row per Node of the Index into out, which must hold
+		* index->count() * width() values. Properties that are missing or
+		* not numeric are written as NaN. Must be called on the v8 thread.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Index* index
+		* @param		float* out
+		*/
+		void write(v8::Isolate* isolate, gk::Index* index, float* out) const noexcept;
+
+	protected:
+		Options options_;
+	};
+}
+
+#endif
@@ -16,7 +16,15 @@
 * in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <uv.h>
 #include "Graph.h"
 #include "exports.h"
 #include "symbols.h"
@@ -26,6 +34,266 @@
 #include "Entity.h"
 #include "Action.h"
 #include "Bond.h"
+#include "Topology.h"
+#include "RandomWalk.h"
+#include "Similarity.h"
+#include "Features.h"
+#include "Job.h"
+#include "Snapshot.h"
+#include "Pool.h"
+#include "Loader.h"
+
+// a thread count is clamped to this many per Scheduler thread
+static const unsigned GK_GRAPH_THREADS_PER_WORKER = 4;
+
+// the most Entities a single createEntities call makes
+static const double GK_GRAPH_MAX_CREATE = 1 << 24;
+
+// reads a boolean option, falling back to a default value when not set
+static bool optionBoolean(v8::Isolate* isolate, v8::Local<v8::Object> options, const char* key, bool value) {
+	auto v = options->Get(GK_STRING(key));
+	return v->IsUndefined() ? value : v->BooleanValue();
+}
+
+// reads a numeric option, falling back to a default value when not set
+static double optionNumber(v8::Isolate* isolate, v8::Local<v8::Object> options, const char* key, double value) {
+	auto v = options->Get(GK_STRING(key));
+	return v->IsNumber() ? v->NumberValue() : value;
+}
+
+// reads a thread count option, 0 uses every Scheduler thread, false if it is negative or not an integer
+static bool optionThreads(v8::Isolate* isolate, v8::Local<v8::Object> options, const char* key, unsigned& threads) {
+	auto v = optionNumber(isolate, options, key, 0);
+	if (!(0 <= v) || v != std::floor(v)) {
+		return false;
+	}
+	auto limit = GK_GRAPH_THREADS_PER_WORKER * std::max(1u, gk::Scheduler::instance().threads());
+	threads = v < limit ? static_cast<unsigned>(v) : limit;
+	return true;
+}
+
+// reads a string option, falling back to an empty string when not set
+static std::string optionString(v8::Isolate* isolate, v8::Local<v8::Object> options, const char* key) {
+	auto v = options->Get(GK_STRING(key));
+	if (!v->IsString()) {
+		return "";
+	}
+	v8::String::Utf8Value s(v->ToString());
+	return *s;
+}
+
+// reads an Array of strings option
+static std::vector<std::string> optionStrings(v8::Isolate* isolate, v8::Local<v8::Object> options, const char* key) {
+	std::vector<std::string> strings;
+	auto v = options->Get(GK_STRING(key));
+	if (v->IsArray()) {
+		auto array = v8::Local<v8::Array>::Cast(v);
+		for (uint32_t i = 0; i < array->Length(); ++i) {
+			v8::String::Utf8Value s(array->Get(i)->ToString());
+			strings.push_back(*s);
+		}
+	}
+	return strings;
+}
+
+// reads a vertex ordering option, the stored ranks by default
+static bool topologyOrdering(v8::Isolate* isolate, v8::Local<v8::Object> options, const char* key, gk::Topology::Ordering& ordering) {
+	auto o = optionString(isolate, options, key);
+	if (o.empty() || GK_SYMBOL_OPTION_ORDER_RANK == o) {
+		ordering = gk::Topology::Ordering::Rank;
+	} else if (GK_SYMBOL_OPTION_ORDER_INDEX == o) {
+		ordering = gk::Topology::Ordering::Index;
+	} else if (GK_SYMBOL_OPTION_ORDER_BFS == o) {
+		ordering = gk::Topology::Ordering::BFS;
+	} else if (GK_SYMBOL_OPTION_ORDER_RCM == o) {
+		ordering = gk::Topology::Ordering::RCM;
+	} else if (GK_SYMBOL_OPTION_ORDER_DEGREE == o) {
+		ordering = gk::Topology::Ordering::Degree;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+// reads the durability of the log, group commits by default
+static bool storeDurability(v8::Isolate* isolate, v8::Local<v8::Object> options, const char* key, gk::Store::Durability& durability) {
+	auto o = optionString(isolate, options, key);
+	if (o.empty()) {
+		return true;
+	} else if (GK_SYMBOL_OPTION_DURABILITY_NONE == o) {
+		durability = gk::Store::Durability::None;
+	} else if (GK_SYMBOL_OPTION_DURABILITY_ASYNC == o) {
+		durability = gk::Store::Durability::Async;
+	} else if (GK_SYMBOL_OPTION_DURABILITY_GROUP == o) {
+		durability = gk::Store::Durability::Group;
+	} else if (GK_SYMBOL_OPTION_DURABILITY_STRICT == o) {
+		durability = gk::Store::Durability::Strict;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+// reads the options of the log over o, the message of the first value out of range or nullptr
+static const char* storeOptions(v8::Isolate* isolate, v8::Local<v8::Object> options, gk::Store::Options& o) {
+	auto batch = optionNumber(isolate, options, GK_SYMBOL_OPTION_BATCH, o.batch);
+	auto delay = optionNumber(isolate, options, GK_SYMBOL_OPTION_DELAY, o.delay);
+	auto segment = optionNumber(isolate, options, GK_SYMBOL_OPTION_SEGMENT, o.segment);
+	auto checkpoint = optionNumber(isolate, options, GK_SYMBOL_OPTION_CHECKPOINT, o.checkpoint);
+	auto interval = optionNumber(isolate, options, GK_SYMBOL_OPTION_INTERVAL, o.interval);
+	if (!std::isfinite(batch) || 1 > batch) {
+		return "[GraphKit Error: Please specify a correct batch value.]";
+	}
+	if (!std::isfinite(delay) || 0 > delay) {
+		return "[GraphKit Error: Please specify a correct delay value.]";
+	}
+	if (!std::isfinite(segment) || 0 > segment) {
+		return "[GraphKit Error: Please specify a correct segment value.]";
+	}
+	if (!std::isfinite(checkpoint) || 0 > checkpoint) {
+		return "[GraphKit Error: Please specify a correct checkpoint value.]";
+	}
+	if (!std::isfinite(interval) || 0 > interval) {
+		return "[GraphKit Error: Please specify a correct interval value.]";
+	}
+	if (!storeDurability(isolate, options, GK_SYMBOL_OPTION_DURABILITY, o.durability)) {
+		return "[GraphKit Error: Please specify a correct durability value.]";
+	}
+	o.batch = static_cast<std::size_t>(batch);
+	o.delay = static_cast<uint64_t>(delay);
+	o.segment = static_cast<std::size_t>(segment);
+	o.checkpoint = static_cast<std::size_t>(checkpoint);
+	o.interval = static_cast<uint64_t>(interval);
+	o.coalesce = optionBoolean(isolate, options, GK_SYMBOL_OPTION_COALESCE, o.coalesce);
+	o.ring = optionBoolean(isolate, options, GK_SYMBOL_OPTION_RING, o.ring);
+	o.compress = optionBoolean(isolate, options, GK_SYMBOL_OPTION_COMPRESS, o.compress);
+	return nullptr;
+}
+
+// whether two sets of log options are the same
+static bool storeOptionsEqual(const gk::Store::Options& a, const gk::Store::Options& b) {
+	return a.batch == b.batch && a.delay == b.delay && a.segment == b.segment &&
+		a.checkpoint == b.checkpoint && a.interval == b.interval && a.coalesce == b.coalesce &&
+		a.durability == b.durability && a.ring == b.ring && a.compress == b.compress;
+}
+
+// the name of a durability
+static const char* storeDurabilityToString(gk::Store::Durability durability) {
+	switch (durability) {
+		case gk::Store::Durability::None:
+			return GK_SYMBOL_OPTION_DURABILITY_NONE;
+		case gk::Store::Durability::Async:
+			return GK_SYMBOL_OPTION_DURABILITY_ASYNC;
+		case gk::Store::Durability::Strict:
+			return GK_SYMBOL_OPTION_DURABILITY_STRICT;
+		default:
+			return GK_SYMBOL_OPTION_DURABILITY_GROUP;
+	}
+}
+
+// selects which Bonds and Actions become Topology edges
+static gk::Topology::Options topologyOptions(v8::Isolate* isolate, v8::Local<v8::Object> options) {
+	gk::Topology::Options o;
+	o.bonds = optionBoolean(isolate, options, GK_SYMBOL_OPERATION_BONDS, o.bonds);
+	o.actions = optionBoolean(isolate, options, GK_SYMBOL_OPERATION_ACTIONS, o.actions);
+	o.directed = optionBoolean(isolate, options, GK_SYMBOL_OPTION_DIRECTED, o.directed);
+	o.bondType = optionString(isolate, options, GK_SYMBOL_OPTION_BOND_TYPE);
+	o.actionType = optionString(isolate, options, GK_SYMBOL_OPTION_ACTION_TYPE);
+	return o;
+}
+
+// reads the similarity metric option, jaccard by default
+static bool similarityMetric(v8::Isolate* isolate, v8::Local<v8::Object> options, gk::Similarity::Metric& metric) {
+	auto m = optionString(isolate, options, GK_SYMBOL_OPTION_METRIC);
+	if (m.empty() || GK_SYMBOL_OPTION_METRIC_JACCARD == m) {
+		metric = gk::Similarity::Metric::Jaccard;
+		return true;
+	}
+	if (GK_SYMBOL_OPTION_METRIC_COSINE == m) {
+		metric = gk::Similarity::Metric::Cosine;
+		return true;
+	}
+	return false;
+}
+
+// maps the vertex ids of a Topology back to the Entities
+static v8::Local<v8::Array> topologyVertices(v8::Isolate* isolate, const gk::Topology& topology) {
+	auto vertices = v8::Array::New(isolate, topology.vertices());
+	for (auto v = topology.vertices() - 1; 0 <= v; --v) {
+		vertices->Set(v, topology.node(v)->handle());
+	}
+	return vertices;
+}
+
+// streams the walk rows to disk as raw int32 values
+static bool writeWalks(gk::RandomWalk& walker, const std::vector<gk::Topology::Vertex>& starts, const std::string& file, int length, const gk::Scheduler::Monitor& monitor) {
+	uv_fs_t open_req;
+	uv_fs_open(uv_default_loop(), &open_req, file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR, NULL);
+	auto fd = open_req.result;
+	uv_fs_req_cleanup(&open_req);
+	if (0 > fd) {
+		return false;
+	}
+	// short writes are resumed, the first failed one stops the workers through the monitor
+	std::atomic<bool> failed{false};
+	walker.run(starts, [&](long long row, const gk::Topology::Vertex* data, long long n) {
+		auto p = reinterpret_cast<const char*>(data);
+		std::size_t size = n * length * sizeof(gk::Topology::Vertex);
+		int64_t offset = row * length * sizeof(gk::Topology::Vertex);
+		while (0 < size && !failed) {
+			uv_buf_t iov = uv_buf_init(const_cast<char*>(p), size);
+			uv_fs_t write_req;
+			uv_fs_write(uv_default_loop(), &write_req, fd, &iov, 1, offset, NULL);
+			auto written = write_req.result;
+			uv_fs_req_cleanup(&write_req);
+			if (0 >= written) {
+				failed = true;
+				break;
+			}
+			p += written;
+			size -= written;
+			offset += written;
+		}
+	}, [&](double fraction) {
+		return !failed && (!monitor || monitor(fraction));
+	});
+	uv_fs_t close_req;
+	uv_fs_close(uv_default_loop(), &close_req, fd, NULL);
+	auto closed = close_req.result;
+	uv_fs_req_cleanup(&close_req);
+	return !failed && 0 == closed;
+}
+
+// the result of a walk, walks is undefined when the rows were written to a file
+static v8::Local<v8::Object> walkResult(v8::Isolate* isolate, v8::Local<v8::Value> walks, long long rows, int length, v8::Local<v8::Array> vertices) {
+	auto result = v8::Object::New(isolate);
+	if (!walks->IsUndefined()) {
+		result->Set(GK_STRING(GK_SYMBOL_OPTION_WALKS), walks);
+	}
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_ROWS), GK_NUMBER(rows));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_LENGTH), GK_INTEGER(length));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_VERTICES), vertices);
+	return result;
+}
+
+// the result of an all pairs similarity join, as typed arrays
+static v8::Local<v8::Object> pairsResult(v8::Isolate* isolate, const std::vector<gk::Similarity::Match<gk::Topology::Vertex>>& matches, v8::Local<v8::Array> vertices) {
+	auto pairs = v8::ArrayBuffer::New(isolate, 2 * matches.size() * sizeof(gk::Topology::Vertex));
+	auto scores = v8::ArrayBuffer::New(isolate, matches.size() * sizeof(double));
+	auto p = static_cast<gk::Topology::Vertex*>(pairs->GetContents().Data());
+	auto s = static_cast<double*>(scores->GetContents().Data());
+	for (std::size_t i = 0; i < matches.size(); ++i) {
+		p[2 * i] = matches[i].subject;
+		p[2 * i + 1] = matches[i].object;
+		s[i] = matches[i].score;
+	}
+	auto result = v8::Object::New(isolate);
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_ROWS), GK_NUMBER(matches.size()));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_PAIRS), v8::Int32Array::New(pairs, 0, 2 * matches.size()));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_SCORES), v8::Float64Array::New(scores, 0, matches.size()));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_VERTICES), vertices);
+	return result;
+}
 
 GK_CONSTRUCTOR(gk::Graph::constructor_);
 
@@ -33,6 +301,10 @@ gk::Graph::Graph() noexcept
 	: gk::Export{},
 	  coordinator_{nullptr} {}
 
+gk::Graph::Graph(const std::string& path) noexcept
+	: gk::Export{},
+	  coordinator_{std::make_shared<gk::Coordinator>(path)} {}
+
 gk::Graph::~Graph() {
 	if (0 < coordinator_.use_count()) {
 		coordinator_.reset();
@@ -82,6 +354,23 @@ GK_INIT(gk::Graph::Init) {
 	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_CREATE_ACTION, CreateAction);
 	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_CREATE_BOND, CreateBond);
 	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_GROUP, Group);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_WALK, Walk);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_SIMILAR, Similar);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_SIMILAR_PAIRS, SimilarPairs);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_FEATURES, Features);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_REORDER, Reorder);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_FLUSH, Flush);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_CHECKPOINT, Checkpoint);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_SAVE_SNAPSHOT, SaveSnapshot);
+	t->Set(GK_STRING(GK_SYMBOL_OPERATION_OPEN), v8::FunctionTemplate::New(isolate, Open));
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_BATCH, Batch);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_INSERT_MANY, InsertMany);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_CREATE_ENTITIES, CreateEntities);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_STATS, Stats);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_DROP_TYPE, DropType);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_DROP_CLUSTER, DropCluster);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_EXPORT_LOG, ExportLog);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_CLOSE, Close);
 
 	constructor_.Reset(isolate, t->GetFunction());
 	exports->Set(GK_STRING(symbol), t->GetFunction());
@@ -90,14 +379,71 @@ GK_INIT(gk::Graph::Init) {
 GK_METHOD(gk::Graph::New) {
 	GK_SCOPE();
 
+	if (!args[0]->IsUndefined() && !args[0]->IsObject()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an options Object.]");
+	}
+
 	if (args.IsConstructCall()) {
-		auto obj = new gk::Graph{};
+		// every option is checked before anything is opened or installed
+		auto options = args[0]->IsObject() ? args[0]->ToObject() : v8::Object::New(isolate);
+		auto path = optionString(isolate, options, GK_SYMBOL_OPTION_PATH);
+		if (!options->Get(GK_STRING(GK_SYMBOL_OPTION_PATH))->IsUndefined() && path.empty()) {
+			GK_EXCEPTION("[GraphKit Error: Please specify a correct path value.]");
+		}
+		auto snapshot = optionString(isolate, options, GK_SYMBOL_OPTION_SNAPSHOT);
+		gk::Store::Options o;
+		auto error = storeOptions(isolate, options, o);
+		if (nullptr != error) {
+			GK_EXCEPTION(error);
+		}
+
+		// bytes of Node bodies kept in memory, the Pool is shared by every Graph of the process
+		auto memory = optionNumber(isolate, options, GK_SYMBOL_OPTION_MEMORY, -1);
+		if (options->Get(GK_STRING(GK_SYMBOL_OPTION_MEMORY))->IsNumber() && (!std::isfinite(memory) || 0 > memory)) {
+			GK_EXCEPTION("[GraphKit Error: Please specify a correct memory value.]");
+		}
+		if (0 <= memory && gk::Pool::enabled() && static_cast<std::size_t>(memory) != gk::Pool::instance().capacity()) {
+			GK_EXCEPTION("[GraphKit Error: The memory value can only be set once per process.]");
+		}
+
+		// Graphs of different data directories are independent, those of the same one are shared
+		auto obj = path.empty() ? new gk::Graph{} : new gk::Graph{path};
+		auto store = obj->coordinator()->store();
+		if (obj->coordinator()->synched()) {
+			// the options belong to the data directory, a later Graph may only restate them
+			auto current = store->options();
+			auto requested = current;
+			storeOptions(isolate, options, requested);
+			if (!snapshot.empty()) {
+				delete obj;
+				GK_EXCEPTION("[GraphKit Error: A snapshot can only be opened before the Graph is loaded.]");
+			}
+			if (!storeOptionsEqual(current, requested)) {
+				delete obj;
+				GK_EXCEPTION("[GraphKit Error: The data directory is already open with different options.]");
+			}
+		} else {
+			if (!snapshot.empty()) {
+				// installed as the newest checkpoint, so the sync below maps it
+				auto error = store->install(snapshot);
+				if (!error.empty()) {
+					delete obj;
+					GK_EXCEPTION(error.c_str());
+				}
+			}
+			store->options(o);
+		}
+
+		// set before loading so large Graphs page while they load
+		if (0 <= memory) {
+			gk::Pool::instance().capacity(static_cast<std::size_t>(memory));
+		}
 		obj->coordinator()->sync(isolate);
 		obj->Wrap(args.This());
 		GK_RETURN(args.This());
 	} else {
-		const int argc = 0;
-		v8::Local<v8::Value> argv[argc] = {};
+		const int argc = 1;
+		v8::Local<v8::Value> argv[argc] = {args[0]};
 		auto ctor = GK_FUNCTION(constructor_);
 		GK_RETURN(ctor->NewInstance(argc, argv));
 	}
@@ -253,7 +599,23 @@ GK_PROPERTY_GETTER(gk::Graph::PropertyGetter) {
 	if (0 != strcmp(*p, GK_SYMBOL_OPERATION_INSERT) &&
 		0 != strcmp(*p, GK_SYMBOL_OPERATION_REMOVE) &&
 		0 != strcmp(*p, GK_SYMBOL_OPERATION_CLEAR) &&
-		0 != strcmp(*p, GK_SYMBOL_OPERATION_FIND)) {
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_FIND) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_WALK) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_SIMILAR) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_SIMILAR_PAIRS) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_FEATURES) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_REORDER) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_FLUSH) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_CHECKPOINT) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_SAVE_SNAPSHOT) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_BATCH) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_INSERT_MANY) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_CREATE_ENTITIES) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_STATS) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_DROP_TYPE) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_DROP_CLUSTER) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_EXPORT_LOG) &&
+		0 != strcmp(*p, GK_SYMBOL_OPERATION_CLOSE)) {
 			auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
 			auto cluster = graph->coordinator()->nodeGraph()->findByKey(gk::NodeClassFromString(*p));
 			if (cluster) {
@@ -323,4 +685,539 @@ GK_METHOD(gk::Graph::Group) {
 	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
 	auto set = graph->coordinator()->groupGraph()->findByKey(*group);
 	GK_RETURN(set->handle());
-}
\ No newline at end of file
+}
+
+GK_METHOD(gk::Graph::Walk) {
+	GK_SCOPE();
+	if (!args[0]->IsUndefined() && !args[0]->IsObject()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an options Object.]");
+	}
+	auto options = args[0]->IsObject() ? args[0]->ToObject() : v8::Object::New(isolate);
+
+	gk::RandomWalk::Options o;
+	o.length = optionNumber(isolate, options, GK_SYMBOL_OPTION_LENGTH, o.length);
+	o.walks = optionNumber(isolate, options, GK_SYMBOL_OPTION_WALKS, o.walks);
+	o.p = optionNumber(isolate, options, GK_SYMBOL_OPTION_P, o.p);
+	o.q = optionNumber(isolate, options, GK_SYMBOL_OPTION_Q, o.q);
+	if (!optionThreads(isolate, options, GK_SYMBOL_OPTION_THREADS, o.threads)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct threads value.]");
+	}
+	o.seed = optionNumber(isolate, options, GK_SYMBOL_OPTION_SEED, uv_hrtime());
+	if (1 > o.length || 1 > o.walks) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct length and walks value.]");
+	}
+	if (!(0 < o.p) || !(0 < o.q)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct p and q value.]");
+	}
+	auto t = topologyOptions(isolate, options);
+	if (!topologyOrdering(isolate, options, GK_SYMBOL_OPTION_ORDER, t.ordering)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct order value.]");
+	}
+
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto topology = std::make_shared<gk::Topology>();
+	topology->build(isolate, graph->coordinator()->nodeGraph().get(), t);
+
+	// start vertices, optionally restricted to a single Entity type
+	auto type = optionString(isolate, options, GK_SYMBOL_OPERATION_TYPE);
+	auto starts = std::make_shared<std::vector<gk::Topology::Vertex>>();
+	for (auto v = 0; v < topology->vertices(); ++v) {
+		if (type.empty() || type == topology->node(v)->type()) {
+			starts->push_back(v);
+		}
+	}
+
+	auto walker = std::make_shared<gk::RandomWalk>(*topology, o);
+	auto rows = walker->rows(*starts);
+	auto length = o.length;
+	auto file = optionString(isolate, options, GK_SYMBOL_OPTION_FILE);
+	auto vertices = topologyVertices(isolate, *topology);
+	v8::Local<v8::ArrayBuffer> buffer;
+	gk::Topology::Vertex* data = nullptr;
+	if (file.empty()) {
+		buffer = v8::ArrayBuffer::New(isolate, rows * length * sizeof(gk::Topology::Vertex));
+		data = static_cast<gk::Topology::Vertex*>(buffer->GetContents().Data());
+	}
+
+	// an empty buffer has no contents, so the file decides where the walks go
+	if (!optionBoolean(isolate, options, GK_SYMBOL_OPTION_ASYNC, false)) {
+		if (file.empty()) {
+			walker->run(*starts, data);
+			GK_RETURN(walkResult(isolate, v8::Int32Array::New(buffer, 0, rows * length), rows, length, vertices));
+		}
+		if (!writeWalks(*walker, *starts, file, length, nullptr)) {
+			GK_EXCEPTION(("[GraphKit Error: Cannot write file " + file + ".]").c_str());
+		}
+		GK_RETURN(walkResult(isolate, GK_UNDEFINED(), rows, length, vertices));
+	}
+
+	// generated on the Scheduler, the Job keeps the buffer and vertices alive
+	auto job = gk::Job::Instance(isolate);
+	auto context = job->context(isolate);
+	context->Set(GK_STRING(GK_SYMBOL_OPTION_VERTICES), vertices);
+	if (file.empty()) {
+		context->Set(GK_STRING(GK_SYMBOL_OPTION_WALKS), buffer);
+	}
+	job->start(isolate, [topology, starts, walker, data, file, length](gk::Job& job) {
+		if (file.empty()) {
+			walker->run(*starts, data, job.monitor());
+		} else if (!writeWalks(*walker, *starts, file, length, job.monitor())) {
+			job.fail("[GraphKit Error: Cannot write file " + file + ".]");
+		}
+	}, [rows, length](v8::Isolate* isolate, gk::Job& job) -> v8::Local<v8::Value> {
+		auto context = job.context(isolate);
+		auto walks = context->Get(GK_STRING(GK_SYMBOL_OPTION_WALKS));
+		auto vertices = v8::Local<v8::Array>::Cast(context->Get(GK_STRING(GK_SYMBOL_OPTION_VERTICES)));
+		if (!walks->IsArrayBuffer()) {
+			return walkResult(isolate, GK_UNDEFINED(), rows, length, vertices);
+		}
+		return walkResult(isolate, v8::Int32Array::New(v8::Local<v8::ArrayBuffer>::Cast(walks), 0, rows * length), rows, length, vertices);
+	}, options->Get(GK_STRING(GK_SYMBOL_OPTION_PROGRESS)));
+	GK_RETURN(job->handle());
+}
+
+GK_METHOD(gk::Graph::Similar) {
+	GK_SCOPE();
+	if (!args[0]->IsObject()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an Entity instance.]");
+	}
+	auto entity = dynamic_cast<gk::Entity*>(node::ObjectWrap::Unwrap<gk::Node>(args[0]->ToObject()));
+	if (!entity) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an Entity instance.]");
+	}
+	if (!args[1]->IsUndefined() && !args[1]->IsObject()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 1 must be an options Object.]");
+	}
+	auto options = args[1]->IsObject() ? args[1]->ToObject() : v8::Object::New(isolate);
+
+	gk::Similarity::Metric metric;
+	if (!similarityMetric(isolate, options, metric)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct metric value.]");
+	}
+	auto topK = optionNumber(isolate, options, GK_SYMBOL_OPTION_TOP_K, 10);
+	if (!(0 <= topK) || !std::isfinite(topK) || std::floor(topK) != topK) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct topK value.]");
+	}
+	// every candidate shares an object, so without a threshold each one matches
+	auto threshold = optionNumber(isolate, options, GK_SYMBOL_OPTION_THRESHOLD, 0);
+	if (options->Get(GK_STRING(GK_SYMBOL_OPTION_THRESHOLD))->IsNumber() && (!(0 < threshold) || 1 < threshold)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a threshold value in (0, 1].]");
+	}
+
+	// a topK past any number of candidates keeps every match
+	auto k = static_cast<std::size_t>(std::min<double>(topK, std::numeric_limits<uint32_t>::max()));
+	auto matches = gk::Similarity::similar(isolate, entity, optionString(isolate, options, GK_SYMBOL_OPTION_ACTION_TYPE), metric, k, threshold);
+	v8::Handle<v8::Array> array = v8::Array::New(isolate, matches.size());
+	for (auto i = matches.size(); 0 < i--;) {
+		auto match = v8::Object::New(isolate);
+		match->Set(GK_STRING(GK_SYMBOL_OPTION_ENTITY), matches[i].object->handle());
+		match->Set(GK_STRING(GK_SYMBOL_OPTION_SCORE), GK_NUMBER(matches[i].score));
+		array->Set(i, match);
+	}
+	GK_RETURN(array);
+}
+
+GK_METHOD(gk::Graph::SimilarPairs) {
+	GK_SCOPE();
+	if (!args[0]->IsUndefined() && !args[0]->IsObject()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an options Object.]");
+	}
+	auto options = args[0]->IsObject() ? args[0]->ToObject() : v8::Object::New(isolate);
+
+	gk::Similarity::Metric metric;
+	if (!similarityMetric(isolate, options, metric)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct metric value.]");
+	}
+	auto threshold = optionNumber(isolate, options, GK_SYMBOL_OPTION_THRESHOLD, 0.5);
+	if (!(0 < threshold) || 1 < threshold) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a threshold value in (0, 1].]");
+	}
+	unsigned threads;
+	if (!optionThreads(isolate, options, GK_SYMBOL_OPTION_THREADS, threads)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct threads value.]");
+	}
+
+	// subject -> object edges of the matching Actions only
+	gk::Topology::Options o;
+	o.bonds = false;
+	o.directed = true;
+	o.actionType = optionString(isolate, options, GK_SYMBOL_OPTION_ACTION_TYPE);
+	if (!topologyOrdering(isolate, options, GK_SYMBOL_OPTION_ORDER, o.ordering)) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct order value.]");
+	}
+
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto topology = std::make_shared<gk::Topology>();
+	topology->build(isolate, graph->coordinator()->nodeGraph().get(), o);
+	auto vertices = topologyVertices(isolate, *topology);
+
+	if (!optionBoolean(isolate, options, GK_SYMBOL_OPTION_ASYNC, false)) {
+		gk::Similarity similarity{*topology, metric};
+		GK_RETURN(pairsResult(isolate, similarity.pairs(threshold, threads), vertices));
+	}
+
+	// joined on the Scheduler, the Job keeps the vertices alive
+	auto job = gk::Job::Instance(isolate);
+	auto matches = std::make_shared<std::vector<gk::Similarity::Match<gk::Topology::Vertex>>>();
+	job->context(isolate)->Set(GK_STRING(GK_SYMBOL_OPTION_VERTICES), vertices);
+	job->start(isolate, [topology, matches, metric, threshold, threads](gk::Job& job) {
+		gk::Similarity similarity{*topology, metric};
+		*matches = similarity.pairs(threshold, threads, job.monitor());
+	}, [matches](v8::Isolate* isolate, gk::Job& job) -> v8::Local<v8::Value> {
+		auto vertices = v8::Local<v8::Array>::Cast(job.context(isolate)->Get(GK_STRING(GK_SYMBOL_OPTION_VERTICES)));
+		return pairsResult(isolate, *matches, vertices);
+	}, options->Get(GK_STRING(GK_SYMBOL_OPTION_PROGRESS)));
+	GK_RETURN(job->handle());
+}
+
+GK_METHOD(gk::Graph::Features) {
+	GK_SCOPE();
+	if (!args[0]->IsObject()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an options Object.]");
+	}
+	auto options = args[0]->ToObject();
+
+	auto nodeClass = optionNumber(isolate, options, GK_SYMBOL_OPERATION_NODE_CLASS, GK_SYMBOL_NODE_CLASS_ENTITY_CONSTANT);
+	if (GK_SYMBOL_NODE_CLASS_ENTITY_CONSTANT > nodeClass || GK_SYMBOL_NODE_CLASS_BOND_CONSTANT < nodeClass) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct NodeClass value.]");
+	}
+	auto type = optionString(isolate, options, GK_SYMBOL_OPERATION_TYPE);
+	if (type.empty()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a Type value.]");
+	}
+
+	gk::Features::Options o;
+	o.properties = optionStrings(isolate, options, GK_SYMBOL_OPTION_PROPERTIES);
+	o.groups = optionStrings(isolate, options, GK_SYMBOL_OPTION_GROUPS);
+	o.degrees = optionBoolean(isolate, options, GK_SYMBOL_OPTION_DEGREES, o.degrees);
+	gk::Features features{o};
+
+	// the matrix is written straight into the ArrayBuffer memory
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto cluster = graph->coordinator()->nodeGraph()->findByKey(gk::NodeClassFromInt(nodeClass));
+	auto index = cluster ? cluster->findByKey(type) : nullptr;
+	long long rows = index ? index->count() : 0;
+	auto buffer = v8::ArrayBuffer::New(isolate, rows * features.width() * sizeof(float));
+	if (index) {
+		features.write(isolate, index, static_cast<float*>(buffer->GetContents().Data()));
+	}
+
+	auto columns = features.columns();
+	v8::Handle<v8::Array> names = v8::Array::New(isolate, columns.size());
+	for (auto i = columns.size(); 0 < i--;) {
+		names->Set(i, GK_STRING(columns[i].c_str()));
+	}
+	auto matrix = v8::Float32Array::New(buffer, 0, rows * features.width());
+	matrix->Set(GK_STRING(GK_SYMBOL_OPTION_ROWS), GK_NUMBER(rows));
+	matrix->Set(GK_STRING(GK_SYMBOL_OPTION_COLUMNS), names);
+	GK_RETURN(matrix);
+}
+
+GK_METHOD(gk::Graph::Reorder) {
+	GK_SCOPE();
+	if (!args[0]->IsUndefined() && !args[0]->IsObject()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an options Object.]");
+	}
+	auto options = args[0]->IsObject() ? args[0]->ToObject() : v8::Object::New(isolate);
+
+	gk::Topology::Ordering ordering;
+	if (!topologyOrdering(isolate, options, GK_SYMBOL_OPTION_METHOD, ordering) || gk::Topology::Ordering::Rank == ordering) {
+		if (!optionString(isolate, options, GK_SYMBOL_OPTION_METHOD).empty()) {
+			GK_EXCEPTION("[GraphKit Error: Please specify a correct method value.]");
+		}
+		ordering = gk::Topology::Ordering::RCM;
+	}
+
+	// the ranks are computed over the undirected graph, starting from the current ranks
+	auto t = topologyOptions(isolate, options);
+	t.directed = false;
+	t.ordering = gk::Topology::Ordering::Rank;
+
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	gk::Topology topology;
+	topology.build(isolate, graph->coordinator()->nodeGraph().get(), t);
+	auto previous = topology.bandwidth();
+	topology.reorder(ordering);
+
+	// store the new ranks, only Entities that moved are persisted
+	for (auto v = topology.vertices() - 1; 0 <= v; --v) {
+		auto node = topology.node(v);
+		if (v != node->rank()) {
+			auto prior = std::to_string(node->rank());
+			node->rank(v);
+			node->record(gk::Mutation::Rank, "", std::to_string(v), &prior);
+		}
+	}
+
+	auto result = v8::Object::New(isolate);
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_VERTICES), GK_INTEGER(topology.vertices()));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_BANDWIDTH), GK_INTEGER(topology.bandwidth()));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_PREVIOUS), GK_INTEGER(previous));
+	GK_RETURN(result);
+}
+
+GK_METHOD(gk::Graph::Flush) {
+	GK_SCOPE();
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto resolver = v8::Promise::Resolver::New(isolate);
+	graph->coordinator()->store()->flush(isolate, resolver);
+	GK_RETURN(resolver->GetPromise());
+}
+
+GK_METHOD(gk::Graph::Checkpoint) {
+	GK_SCOPE();
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto resolver = v8::Promise::Resolver::New(isolate);
+	graph->coordinator()->store()->checkpoint(isolate, resolver);
+	GK_RETURN(resolver->GetPromise());
+}
+
+GK_METHOD(gk::Graph::SaveSnapshot) {
+	GK_SCOPE();
+	if (!args[0]->IsString()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a file name.]");
+	}
+	v8::String::Utf8Value f(args[0]->ToString());
+	std::string file (*f);
+
+	// copied on the v8 thread, only the write runs on the Scheduler
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto snapshot = std::make_shared<gk::Snapshot>();
+	auto clusters = graph->coordinator()->nodeGraph();
+	for (auto i = 1; i <= clusters->count(); ++i) {
+		auto cluster = clusters->select(i);
+		for (auto j = 1; j <= cluster->count(); ++j) {
+			auto index = cluster->select(j);
+			for (auto k = 1; k <= index->count(); ++k) {
+				snapshot->add(isolate, index->select(k));
+			}
+		}
+	}
+	snapshot->seal();
+
+	auto compress = graph->coordinator()->store()->options().compress;
+	auto job = gk::Job::Instance(isolate);
+	job->start(isolate, [snapshot, file, compress](gk::Job& job) {
+		auto error = snapshot->write(file, compress);
+		if (!error.empty()) {
+			job.fail(error);
+		}
+	}, [snapshot](v8::Isolate* isolate, gk::Job& job) -> v8::Local<v8::Value> {
+		return GK_NUMBER(snapshot->count());
+	}, GK_UNDEFINED());
+	GK_RETURN(job->handle());
+}
+
+GK_METHOD(gk::Graph::Open) {
+	GK_SCOPE();
+	if (!args[0]->IsObject() || optionString(isolate, args[0]->ToObject(), GK_SYMBOL_OPTION_SNAPSHOT).empty()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a snapshot file.]");
+	}
+	auto path = optionString(isolate, args[0]->ToObject(), GK_SYMBOL_OPTION_PATH);
+	if ((path.empty() ? gk::Coordinator{} : gk::Coordinator{path}).synched()) {
+		GK_EXCEPTION("[GraphKit Error: A snapshot can only be opened before the Graph is loaded.]");
+	}
+	const int argc = 1;
+	v8::Local<v8::Value> argv[argc] = {args[0]};
+	auto ctor = GK_FUNCTION(constructor_);
+	GK_RETURN(ctor->NewInstance(argc, argv));
+}
+
+GK_METHOD(gk::Graph::Batch) {
+	GK_SCOPE();
+	if (!args[0]->IsFunction()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a batch function.]");
+	}
+
+	// the changes are written together once the function returns, undone if it throws
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto store = graph->coordinator()->store();
+	auto fn = v8::Local<v8::Function>::Cast(args[0]);
+	v8::TryCatch tryCatch(isolate);
+	store->begin();
+	auto result = fn->Call(args.Holder(), 0, nullptr);
+	if (tryCatch.HasCaught()) {
+		store->rollback();
+		tryCatch.ReThrow();
+		return;
+	}
+	store->commit();
+	GK_RETURN(result);
+}
+
+GK_METHOD(gk::Graph::InsertMany) {
+	GK_SCOPE();
+	if (!args[0]->IsArray()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an Array of NodeClass Objects.]");
+	}
+	auto array = v8::Local<v8::Array>::Cast(args[0]);
+	auto length = array->Length();
+	for (uint32_t i = 0; i < length; ++i) {
+		if (!array->Get(i)->IsObject()) {
+			GK_EXCEPTION("[GraphKit Error: Argument at position 0 must be an Array of NodeClass Objects.]");
+		}
+	}
+
+	std::vector<gk::Node*> nodes;
+	nodes.reserve(length);
+	for (uint32_t i = 0; i < length; ++i) {
+		nodes.push_back(node::ObjectWrap::Unwrap<gk::Node>(array->Get(i)->ToObject()));
+	}
+
+	// the inserts are written as a single record
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto store = graph->coordinator()->store();
+	store->begin();
+	auto result = graph->coordinator()->insertNodes(isolate, nodes);
+	store->commit();
+	GK_RETURN(GK_NUMBER(result));
+}
+
+GK_METHOD(gk::Graph::CreateEntities) {
+	GK_SCOPE();
+	if (!args[0]->IsString()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a Type value.]");
+	}
+	if (!args[1]->IsNumber()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a count.]");
+	}
+	// checked before the cast and the allocations it sizes
+	auto n = args[1]->NumberValue();
+	if (!(0 <= n && GK_GRAPH_MAX_CREATE >= n) || std::floor(n) != n) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct count value.]");
+	}
+	if (!args[2]->IsUndefined() && !args[2]->IsArray()) {
+		GK_EXCEPTION("[GraphKit Error: Argument at position 2 must be an Array of property Objects.]");
+	}
+	v8::String::Utf8Value type(args[0]->ToString());
+	auto count = static_cast<uint32_t>(n);
+
+	// the properties are checked before anything is created
+	std::vector<std::vector<std::pair<std::string, std::string>>> properties;
+	if (args[2]->IsArray()) {
+		auto array = v8::Local<v8::Array>::Cast(args[2]);
+		auto length = std::min(array->Length(), count);
+		properties.resize(length);
+		for (uint32_t i = 0; i < length; ++i) {
+			auto item = array->Get(i);
+			if (item->IsUndefined() || item->IsNull()) {
+				continue;
+			}
+			if (!item->IsObject()) {
+				GK_EXCEPTION("[GraphKit Error: Argument at position 2 must be an Array of property Objects.]");
+			}
+			auto object = item->ToObject();
+			auto keys = object->GetOwnPropertyNames();
+			for (uint32_t j = 0, n = keys->Length(); j < n; ++j) {
+				v8::String::Utf8Value k(keys->Get(j));
+				if (0 == strcmp(*k, GK_SYMBOL_OPERATION_NODE_CLASS) ||
+					0 == strcmp(*k, GK_SYMBOL_OPERATION_TYPE) ||
+					0 == strcmp(*k, GK_SYMBOL_OPERATION_ID) ||
+					0 == strcmp(*k, GK_SYMBOL_OPERATION_HASH) ||
+					0 == strcmp(*k, GK_SYMBOL_OPERATION_INDEXED) ||
+					0 == strcmp(*k, GK_SYMBOL_OPERATION_BONDS) ||
+					0 == strcmp(*k, GK_SYMBOL_OPERATION_ACTIONS)) {
+					GK_EXCEPTION(("[GraphKit Error: Cannot set " + std::string{*k} + " property.]").c_str());
+				}
+				v8::String::Utf8Value v(object->Get(keys->Get(j)));
+				properties[i].emplace_back(*k, *v);
+			}
+		}
+	}
+
+	std::vector<gk::Node*> nodes;
+	nodes.reserve(count);
+	auto result = v8::Array::New(isolate, count);
+	for (uint32_t i = 0; i < count; ++i) {
+		auto node = gk::Entity::Instance(isolate, *type);
+		if (i < properties.size()) {
+			for (auto& property : properties[i]) {
+				node->properties()->insert(property.first, new std::string{property.second});
+			}
+		}
+		nodes.push_back(node);
+		result->Set(i, node->handle());
+	}
+
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto store = graph->coordinator()->store();
+	store->begin();
+	graph->coordinator()->insertNodes(isolate, nodes);
+	store->commit();
+	GK_RETURN(result);
+}
+
+GK_METHOD(gk::Graph::Stats) {
+	GK_SCOPE();
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	auto stats = graph->coordinator()->store()->stats();
+	auto& pool = gk::Pool::instance();
+	auto result = v8::Object::New(isolate);
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_PATH), GK_STRING(graph->coordinator()->path().c_str()));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_DURABILITY), GK_STRING(storeDurabilityToString(stats.durability)));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_RING), GK_BOOLEAN(stats.ring));
+	result->Set(GK_STRING(GK_SYMBOL_OPTION_COMPRESS), GK_BOOLEAN(graph->coordinator()->store()->options().compress));
+	result->Set(GK_STRING(GK_SYMBOL_STAT_BUFFERED), GK_NUMBER(stats.buffered));
+	result->Set(GK_STRING(GK_SYMBOL_STAT_QUEUED), GK_NUMBER(stats.queued));
+	result->Set(GK_STRING(GK_SYMBOL_STAT_WRITTEN), GK_NUMBER(stats.written));
+	result->Set(GK_STRING(GK_SYMBOL_STAT_LOGGED), GK_NUMBER(stats.logged));
+	result->Set(GK_STRING(GK_SYMBOL_STAT_SEGMENT), GK_NUMBER(stats.segment));
+	result->Set(GK_STRING(GK_SYMBOL_STAT_RESIDENT), GK_NUMBER(pool.resident()));
+	result->Set(GK_STRING(GK_SYMBOL_STAT_PAGED), GK_NUMBER(pool.paged()));
+	GK_RETURN(result);
+}
+
+GK_METHOD(gk::Graph::DropType) {
+	GK_SCOPE();
+	if (GK_SYMBOL_NODE_CLASS_ENTITY_CONSTANT > args[0]->IntegerValue() || GK_SYMBOL_NODE_CLASS_BOND_CONSTANT < args[0]->IntegerValue()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct NodeClass value.]");
+	}
+	if (!args[1]->IsString()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a Type value.]");
+	}
+
+	// a drop cannot be undone, so it stays out of batches
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	if (graph->coordinator()->store()->batching()) {
+		GK_EXCEPTION("[GraphKit Error: A type cannot be dropped inside a batch.]");
+	}
+	v8::String::Utf8Value type(args[1]->ToString());
+	GK_RETURN(GK_BOOLEAN(graph->coordinator()->dropType(gk::NodeClassFromInt(args[0]->IntegerValue()), *type)));
+}
+
+GK_METHOD(gk::Graph::DropCluster) {
+	GK_SCOPE();
+	if (GK_SYMBOL_NODE_CLASS_ENTITY_CONSTANT > args[0]->IntegerValue() || GK_SYMBOL_NODE_CLASS_BOND_CONSTANT < args[0]->IntegerValue()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct NodeClass value.]");
+	}
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	if (graph->coordinator()->store()->batching()) {
+		GK_EXCEPTION("[GraphKit Error: A Cluster cannot be dropped inside a batch.]");
+	}
+	GK_RETURN(GK_BOOLEAN(graph->coordinator()->dropCluster(gk::NodeClassFromInt(args[0]->IntegerValue()))));
+}
+
+GK_METHOD(gk::Graph::ExportLog) {
+	GK_SCOPE();
+
+	// the written segments rendered as JSON lines, for debugging, buffered records are not included
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	gk::Loader loader;
+	for (auto& segment : graph->coordinator()->store()->segments()) {
+		loader.segment(segment);
+	}
+	loader.parse();
+	GK_RETURN(GK_STRING(loader.json().c_str()));
+}
+
+GK_METHOD(gk::Graph::Close) {
+	GK_SCOPE();
+
+	// every Graph of the data directory is closed, a new one loads it again
+	auto graph = node::ObjectWrap::Unwrap<gk::Graph>(args.Holder());
+	if (graph->coordinator()->store()->batching()) {
+		GK_EXCEPTION("[GraphKit Error: A Graph cannot be closed inside a batch.]");
+	}
+	graph->coordinator()->close();
+	GK_RETURN(GK_UNDEFINED());
+}
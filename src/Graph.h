@@ -27,6 +27,7 @@ namespace gk {
 	class Graph : public gk::Export {
 	public:
 		Graph() noexcept;
+		explicit Graph(const std::string& path) noexcept;
 		virtual ~Graph();
 		Graph(const Graph&) = default;
 		Graph& operator= (const Graph&) = default;
@@ -51,6 +52,23 @@ namespace gk {
 		static GK_METHOD(CreateAction);
 		static GK_METHOD(CreateBond);
 		static GK_METHOD(Group);
+		static GK_METHOD(Walk);
+		static GK_METHOD(Similar);
+		static GK_METHOD(SimilarPairs);
+		static GK_METHOD(Features);
+		static GK_METHOD(Reorder);
+		static GK_METHOD(Flush);
+		static GK_METHOD(Checkpoint);
+		static GK_METHOD(SaveSnapshot);
+		static GK_METHOD(Open);
+		static GK_METHOD(Batch);
+		static GK_METHOD(InsertMany);
+		static GK_METHOD(CreateEntities);
+		static GK_METHOD(Stats);
+		static GK_METHOD(DropType);
+		static GK_METHOD(DropCluster);
+		static GK_METHOD(ExportLog);
+		static GK_METHOD(Close);
 		static GK_INDEX_GETTER(IndexGetter);
 		static GK_INDEX_SETTER(IndexSetter);
 		static GK_INDEX_QUERY(IndexQuery);
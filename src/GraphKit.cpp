@@ -28,6 +28,7 @@
 #include "Set.h"
 #include "Multiset.h"
 #include "Hub.h"
+#include "Job.h"
 
 GK_EXPORT(GraphKit) {
 	// classes
@@ -40,6 +41,7 @@ GK_EXPORT(GraphKit) {
 	gk::Set::Init(exports, GK_SYMBOL_SET);
 	gk::Multiset::Init(exports, GK_SYMBOL_MULTISET);
 	gk::Hub::Init(exports, GK_SYMBOL_HUB);
+	gk::Job::Init(exports, GK_SYMBOL_JOB);
 
 	// constants
 	GK_SCOPE();
@@ -18,26 +18,46 @@
 
 #include <utility>
 #include <cassert>
+#include <cstring>
 #include "Index.h"
 #include "symbols.h"
 
 GK_CONSTRUCTOR(gk::Index::constructor_);
 
-gk::Index::Index(const gk::NodeClass& nodeClass, const std::string& type) noexcept
+gk::Index::Index(const gk::NodeClass& nodeClass, const std::string& type, const std::string& dir) noexcept
 	: gk::Export{},
 	  gk::RedBlackTree<gk::Node, true>{},
 	  nodeClass_{std::move(nodeClass)},
 	  type_{std::move(type)},
-	  fs_idx_{"./" + std::string(GK_FS_DB_DIR)+ "/" + std::to_string(gk::NodeClassToInt(nodeClass_)) + type_ + ".idx"},
-	  fs_iov_(uv_buf_init(fs_buf_, sizeof(fs_buf_))) {
+	  fs_idx_{dir + "/" + GK_FS_INDEX_DIR + "/" + std::to_string(gk::NodeClassToInt(nodeClass_)) + "/" + type_ + GK_FS_INDEX_EXT},
+	  fs_iov_(uv_buf_init(fs_buf_, sizeof(fs_buf_))),
+	  open_req_{},
+	  read_req_{},
+	  write_req_{},
+	  unlink_req_{} {
+
+	// the ID files are kept in a directory per NodeClass, away from the log
+	for (auto& d : {dir, dir + "/" + GK_FS_INDEX_DIR, dir + "/" + GK_FS_INDEX_DIR + "/" + std::to_string(gk::NodeClassToInt(nodeClass_))}) {
+		uv_fs_t mkdir_req;
+		uv_fs_mkdir(uv_default_loop(), &mkdir_req, d.c_str(), S_IRWXU, NULL);
+		uv_fs_req_cleanup(&mkdir_req);
+	}
+
+	// an ID file of the older flat layout is moved into place
+	uv_fs_t rename_req;
+	uv_fs_rename(uv_default_loop(), &rename_req, (dir + "/" + std::to_string(gk::NodeClassToInt(nodeClass_)) + type_ + GK_FS_INDEX_EXT).c_str(), fs_idx_.c_str(), NULL);
+	uv_fs_req_cleanup(&rename_req);
 
 	// file writing
 	uv_fs_open(uv_default_loop(), &open_req_, fs_idx_.c_str(), O_CREAT | O_RDWR, S_IRWXU, NULL);
+	// a new file reads nothing, the buffer must not hold garbage
+	memset(fs_buf_, 0, sizeof(fs_buf_));
 	uv_fs_read(uv_default_loop(), &read_req_, open_req_.result, &fs_iov_, 1, -1, NULL);
-	ids_ = atol(fs_iov_.base);
+	ids_ = atoll(fs_iov_.base);
 	if (!ids_) {
 		ids_ = 0;
 	}
+	leased_ = ids_;
 };
 
 gk::Index::~Index() {
@@ -62,26 +82,69 @@ const std::string& gk::Index::type() const noexcept {
 	return type_;
 }
 
+// takes hold of an inserted Node
+static void admit(gk::Node* n) {
+	n->Ref();
+
+	// Persist the Node, this test is for when the Graph initially loads the persisted data
+	// so it doesn't persist it again.
+	if (!n->indexed()) {
+		n->indexed(true);
+		n->persist();
+	}
+}
+
 long long gk::Index::incrementID() noexcept {
-	snprintf(fs_buf_, GK_INDEX_BUF_SIZE, "%lld", ++ids_);
-	uv_fs_write(uv_default_loop(), &write_req_, open_req_.result, &fs_iov_, 1, 0, NULL);
-	return ids_;
+	return reserveIDs(1);
+}
+
+long long gk::Index::reserveIDs(long long count) noexcept {
+	auto first = ids_ + 1;
+	ids_ += count;
+	if (ids_ > leased_) {
+		leased_ = ids_ + GK_INDEX_LEASE - ids_ % GK_INDEX_LEASE;
+		memset(fs_buf_, 0, sizeof(fs_buf_));
+		snprintf(fs_buf_, GK_INDEX_BUF_SIZE, "%lld", leased_);
+		uv_fs_write(uv_default_loop(), &write_req_, open_req_.result, &fs_iov_, 1, 0, NULL);
+	}
+	return first;
 }
 
 bool gk::Index::insert(gk::Node* node) noexcept {
 	if (0 == node->id()) {
 		node->id(incrementID());
+	} else if (node->id() > ids_) {
+		// IDs loaded from the log past a lost lease are never handed out again
+		ids_ = node->id();
+	}
+	return gk::RedBlackTree<gk::Node, true>::insert(node->id(), node, admit);
+}
+
+std::size_t gk::Index::insert(const std::vector<gk::Node*>& nodes) noexcept {
+	long long fresh = 0;
+	for (auto node : nodes) {
+		if (0 == node->id() && !node->indexed()) {
+			++fresh;
+		}
 	}
-	return gk::RedBlackTree<gk::Node, true>::insert(node->id(), node, [](gk::Node* n) {
-		n->Ref();
-
-		// Persist the Node, this test is for when the Graph initially loads the persisted data
-		// so it doesn't persist it again.
-		if (!n->indexed()) {
-			n->indexed(true);
-			n->persist();
+
+	// Nodes that already have an ID, such as removed ones, are inserted one by one
+	std::size_t inserted = 0;
+	std::vector<std::pair<long long, gk::Node*>> sorted;
+	sorted.reserve(fresh);
+	auto id = 0 < fresh ? reserveIDs(fresh) : 0;
+	for (auto node : nodes) {
+		if (node->indexed()) {
+			continue;
 		}
-	});
+		if (0 == node->id()) {
+			node->id(id++);
+			sorted.emplace_back(node->id(), node);
+		} else if (insert(node)) {
+			++inserted;
+		}
+	}
+	return inserted + append(sorted, admit);
 }
 
 bool gk::Index::remove(gk::Node* node) noexcept {
@@ -103,6 +166,20 @@ bool gk::Index::remove(const int k) noexcept {
 	});
 }
 
+std::size_t gk::Index::release(std::size_t count, const std::function<void(gk::Node*)>& callback) noexcept {
+	std::size_t released = 0;
+	for (; released < count && 0 < this->count(); ++released) {
+		// taken from the back, so the tree rebalances the least
+		auto node = this->back();
+		callback(node);
+		gk::RedBlackTree<gk::Node, true>::remove(node->id(), [](gk::Node* node) {
+			node->indexed(false);
+			node->Unref();
+		});
+	}
+	return released;
+}
+
 void gk::Index::cleanUp() noexcept {
 	for (auto i = this->count(); 0 < i; --i) {
 		remove(this->select(i));
@@ -115,9 +192,9 @@ GK_METHOD(gk::Index::NodeClassToString) {
 	GK_RETURN(GK_STRING(gk::NodeClassToString(index->nodeClass())));
 }
 
-gk::Index* gk::Index::Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass, std::string& type) noexcept {
-	const int argc = 2;
-	v8::Local<v8::Value> argv[argc] = {GK_INTEGER(gk::NodeClassToInt(nodeClass)), GK_STRING(type.c_str())};
+gk::Index* gk::Index::Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass, std::string& type, const std::string& dir) noexcept {
+	const int argc = 3;
+	v8::Local<v8::Value> argv[argc] = {GK_INTEGER(gk::NodeClassToInt(nodeClass)), GK_STRING(type.c_str()), GK_STRING(dir.c_str())};
 	auto ctor = GK_FUNCTION(constructor_);
 	return node::ObjectWrap::Unwrap<gk::Index>(ctor->NewInstance(argc, argv));
 }
@@ -152,15 +229,19 @@ GK_METHOD(gk::Index::New) {
 		GK_EXCEPTION("[GraphKit Error: Please specify a Type value.]");
 	}
 
+	if (!args[2]->IsUndefined() && !args[2]->IsString()) {
+		GK_EXCEPTION("[GraphKit Error: Please specify a correct path value.]");
+	}
+
 	if (args.IsConstructCall()) {
 		auto nodeClass = gk::NodeClassFromInt(args[0]->IntegerValue());
 		v8::String::Utf8Value type(args[1]->ToString());
-		auto obj = new gk::Index{nodeClass, *type};
+		auto obj = args[2]->IsString() ? new gk::Index{nodeClass, *type, *v8::String::Utf8Value(args[2]->ToString())} : new gk::Index{nodeClass, *type};
 		obj->Wrap(args.This());
 		GK_RETURN(args.This());
 	} else {
-		const int argc = 2;
-		v8::Local<v8::Value> argv[argc] = {args[0], args[1]};
+		const int argc = 3;
+		v8::Local<v8::Value> argv[argc] = {args[0], args[1], args[2]};
 		auto ctor = GK_FUNCTION(constructor_);
 		GK_RETURN(ctor->NewInstance(argc, argv));
 	}
@@ -23,6 +23,8 @@
 #ifndef GRAPHKIT_SRC_INDEX_H
 #define GRAPHKIT_SRC_INDEX_H
 
+#include <functional>
+#include <vector>
 #include <uv.h>
 #include "exports.h"
 #include "Export.h"
@@ -34,6 +36,9 @@ namespace gk {
 
 	static const int GK_INDEX_BUF_SIZE = 64;
 
+	// the IDs leased with each write of the ID file
+	static const long long GK_INDEX_LEASE = 4096;
+
 	class Index : public gk::Export,
 				  public gk::RedBlackTree<gk::Node, true> {
 	public:
@@ -43,8 +48,9 @@ namespace gk {
 		* Constructor.
 		* @param		const gk::NodeClass& nodeClass
 		* @param		cons std::string& type
+		* @param		const std::string& dir, the data directory of the ID file
 		*/
-		Index(const gk::NodeClass& nodeClass, const std::string& type) noexcept;
+		Index(const gk::NodeClass& nodeClass, const std::string& type, const std::string& dir = "./" GK_FS_DB_DIR) noexcept;
 
 		/**
 		* ~Index
@@ -73,11 +79,30 @@ namespace gk {
 		const std::string& type() const noexcept;
 
 		bool insert(gk::Node* node) noexcept;
+
+		/**
+		* insert
+		* Inserts many Nodes, the new ones take a block of IDs and are
+		* appended in one pass.
+		* @param		const std::vector<gk::Node*>& nodes
+		* @return		std::size_t, the number of Nodes inserted
+		*/
+		std::size_t insert(const std::vector<gk::Node*>& nodes) noexcept;
 		bool remove(gk::Node* node) noexcept;
 		bool remove(const int k) noexcept;
+
+		/**
+		* release
+		* Releases up to count Nodes of a dropped Index without recording
+		* their removal, the callback runs before each is released.
+		* @param		std::size_t count
+		* @param		const std::function<void(gk::Node*)>& callback
+		* @return		std::size_t, the number of Nodes released
+		*/
+		std::size_t release(std::size_t count, const std::function<void(gk::Node*)>& callback) noexcept;
 		void cleanUp() noexcept;
 
-		static gk::Index* Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass, std::string& type) noexcept;
+		static gk::Index* Instance(v8::Isolate* isolate, gk::NodeClass& nodeClass, std::string& type, const std::string& dir = "./" GK_FS_DB_DIR) noexcept;
 		static GK_INIT(Init);
 
 	private:
@@ -85,6 +110,7 @@ namespace gk {
 		const std::string type_;
 		std::string fs_idx_;
 		long long ids_;
+		long long leased_;
 
 		char fs_buf_[GK_INDEX_BUF_SIZE + 1];
 		uv_buf_t fs_iov_;
@@ -100,6 +126,16 @@ namespace gk {
 		*/
 		long long incrementID() noexcept;
 
+		/**
+		* reserveIDs
+		* Takes a block of IDs for the Nodes to be managed. Only the end of
+		* the lease is written, so the ID file is touched once per
+		* GK_INDEX_LEASE IDs and a restart resumes above the last lease.
+		* @param		long long count
+		* @return		The first ID of the block.
+		*/
+		long long reserveIDs(long long count) noexcept;
+
 		static GK_CONSTRUCTOR(constructor_);
 		static GK_METHOD(New);
 		static GK_METHOD(Insert);
@@ -0,0 +1,257 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Job.h"
+#include "symbols.h"
+
+GK_CONSTRUCTOR(gk::Job::constructor_);
+
+// the Scheduler is sized to at most this many threads per hardware thread
+static const unsigned GK_JOB_THREADS_PER_CORE = 4;
+
+// the Jobs whose work returned, settled through a handle that is never closed nor destroyed
+static auto& finishedMutex = *new std::mutex;
+static auto& finished = *new std::vector<gk::Job*>;
+static uv_async_t* finisher = nullptr;
+
+gk::Job::Job() noexcept
+	: gk::Export{},
+	  progress_{0},
+	  reported_{0},
+	  cancelled_{false},
+	  done_{false},
+	  reporting_{false},
+	  error_{},
+	  complete_{nullptr},
+	  async_{} {}
+
+gk::Job::~Job() {
+	resolver_.Reset();
+	callback_.Reset();
+	context_.Reset();
+}
+
+void gk::Job::start(v8::Isolate* isolate, Work work, Complete complete, v8::Local<v8::Value> progress) noexcept {
+	// held until the async handle is closed
+	Ref();
+	complete_ = complete;
+	resolver_.Reset(isolate, v8::Promise::Resolver::New(isolate));
+	if (progress->IsFunction()) {
+		callback_.Reset(isolate, v8::Local<v8::Function>::Cast(progress));
+		reporting_ = true;
+	}
+	if (nullptr == finisher) {
+		finisher = new uv_async_t;
+		uv_async_init(uv_default_loop(), finisher, finish);
+		uv_unref(reinterpret_cast<uv_handle_t*>(finisher));
+	}
+	uv_async_init(uv_default_loop(), &async_, notify);
+	async_.data = this;
+
+	gk::Scheduler::instance().submit([this, work]() {
+		if (!cancelled()) {
+			work(*this);
+		}
+		// every send to the Job's own handle came before this, so it may be closed once queued
+		done_ = true;
+		{
+			std::lock_guard<std::mutex> lock(finishedMutex);
+			finished.push_back(this);
+		}
+		uv_async_send(finisher);
+	});
+}
+
+gk::Scheduler::Monitor gk::Job::monitor() noexcept {
+	return [this](double fraction) {
+		progress(fraction);
+		return !cancelled();
+	};
+}
+
+double gk::Job::progress() const noexcept {
+	return progress_;
+}
+
+void gk::Job::progress(double fraction) noexcept {
+	progress_ = fraction;
+	if (reporting_) {
+		uv_async_send(&async_);
+	}
+}
+
+bool gk::Job::cancelled() const noexcept {
+	return cancelled_;
+}
+
+void gk::Job::cancel() noexcept {
+	cancelled_ = true;
+}
+
+void gk::Job::fail(const std::string& message) noexcept {
+	error_ = message;
+}
+
+v8::Local<v8::Object> gk::Job::context(v8::Isolate* isolate) noexcept {
+	if (context_.IsEmpty()) {
+		context_.Reset(isolate, v8::Object::New(isolate));
+	}
+	return v8::Local<v8::Object>::New(isolate, context_);
+}
+
+void gk::Job::notify(uv_async_t* handle) noexcept {
+	GK_SCOPE();
+	static_cast<gk::Job*>(handle->data)->report(isolate);
+}
+
+void gk::Job::report(v8::Isolate* isolate) noexcept {
+	auto fraction = progress();
+	if (!callback_.IsEmpty() && fraction != reported_) {
+		reported_ = fraction;
+		const int argc = 1;
+		v8::Local<v8::Value> argv[argc] = {GK_NUMBER(fraction)};
+		GK_FUNCTION(callback_)->Call(handle(), argc, argv);
+	}
+}
+
+void gk::Job::finish(uv_async_t* handle) noexcept {
+	GK_SCOPE();
+	std::vector<gk::Job*> jobs;
+	{
+		std::lock_guard<std::mutex> lock(finishedMutex);
+		jobs.swap(finished);
+	}
+	for (auto job : jobs) {
+		// a progress send still pending is dropped by the close, so the last fraction is reported here
+		job->report(isolate);
+		auto resolver = v8::Local<v8::Promise::Resolver>::New(isolate, job->resolver_);
+		if (job->cancelled()) {
+			resolver->Reject(v8::Exception::Error(GK_STRING("[GraphKit Error: Job cancelled.]")));
+		} else if (!job->error_.empty()) {
+			resolver->Reject(v8::Exception::Error(GK_STRING(job->error_.c_str())));
+		} else {
+			resolver->Resolve(job->complete_(isolate, *job));
+		}
+		job->complete_ = nullptr;
+		job->callback_.Reset();
+		job->context_.Reset();
+		uv_close(reinterpret_cast<uv_handle_t*>(&job->async_), [](uv_handle_t* handle) {
+			static_cast<gk::Job*>(handle->data)->Unref();
+		});
+	}
+	if (!jobs.empty()) {
+		isolate->RunMicrotasks();
+	}
+}
+
+gk::Job* gk::Job::Instance(v8::Isolate* isolate) noexcept {
+	const int argc = 0;
+	v8::Local<v8::Value> argv[argc] = {};
+	auto ctor = GK_FUNCTION(constructor_);
+	return node::ObjectWrap::Unwrap<gk::Job>(ctor->NewInstance(argc, argv));
+}
+
+GK_INIT(gk::Job::Init) {
+	GK_SCOPE();
+
+	auto t = GK_TEMPLATE(New);
+	t->SetClassName(GK_STRING(symbol));
+	t->InstanceTemplate()->SetInternalFieldCount(1);
+	t->InstanceTemplate()->SetNamedPropertyHandler(PropertyGetter);
+
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_CANCEL, Cancel);
+	NODE_SET_PROTOTYPE_METHOD(t, GK_SYMBOL_OPERATION_THEN, Then);
+	t->Set(GK_STRING(GK_SYMBOL_OPTION_THREADS), v8::FunctionTemplate::New(isolate, Threads));
+
+	constructor_.Reset(isolate, t->GetFunction());
+	exports->Set(GK_STRING(symbol), t->GetFunction());
+}
+
+GK_METHOD(gk::Job::New) {
+	GK_SCOPE();
+
+	if (args.IsConstructCall()) {
+		auto obj = new gk::Job{};
+		obj->Wrap(args.This());
+		GK_RETURN(args.This());
+	} else {
+		const int argc = 0;
+		v8::Local<v8::Value> argv[argc] = {};
+		auto ctor = GK_FUNCTION(constructor_);
+		GK_RETURN(ctor->NewInstance(argc, argv));
+	}
+}
+
+GK_METHOD(gk::Job::Cancel) {
+	GK_SCOPE();
+	auto job = node::ObjectWrap::Unwrap<gk::Job>(args.Holder());
+	job->cancel();
+	GK_RETURN(GK_UNDEFINED());
+}
+
+GK_METHOD(gk::Job::Then) {
+	GK_SCOPE();
+	auto job = node::ObjectWrap::Unwrap<gk::Job>(args.Holder());
+	if (job->resolver_.IsEmpty()) {
+		GK_EXCEPTION("[GraphKit Error: Job has not been started.]");
+	}
+	// forwards to the Promise so a Job can be awaited
+	auto promise = v8::Local<v8::Promise::Resolver>::New(isolate, job->resolver_)->GetPromise();
+	auto then = v8::Local<v8::Function>::Cast(promise->Get(GK_STRING(GK_SYMBOL_OPERATION_THEN)));
+	const int argc = 2;
+	v8::Local<v8::Value> argv[argc] = {args[0], args[1]};
+	GK_RETURN(then->Call(promise, argc, argv));
+}
+
+GK_METHOD(gk::Job::Threads) {
+	GK_SCOPE();
+	auto& scheduler = gk::Scheduler::instance();
+	if (args[0]->IsNumber()) {
+		auto v = args[0]->NumberValue();
+		if (!(0 <= v) || std::isinf(v) || std::floor(v) != v) {
+			GK_EXCEPTION("[GraphKit Error: Please specify a correct threads value.]");
+		}
+		// resizing joins every worker, so this blocks until the running Jobs drain
+		auto limit = GK_JOB_THREADS_PER_CORE * std::max(1u, std::thread::hardware_concurrency());
+		scheduler.threads(static_cast<unsigned>(std::min(v, static_cast<double>(limit))));
+	}
+	GK_RETURN(GK_INTEGER(scheduler.threads()));
+}
+
+GK_PROPERTY_GETTER(gk::Job::PropertyGetter) {
+	GK_SCOPE();
+	v8::String::Utf8Value p(property);
+	auto job = node::ObjectWrap::Unwrap<gk::Job>(args.Holder());
+	if (0 == strcmp(*p, GK_SYMBOL_OPTION_PROMISE)) {
+		if (!job->resolver_.IsEmpty()) {
+			GK_RETURN(v8::Local<v8::Promise::Resolver>::New(isolate, job->resolver_)->GetPromise());
+		}
+	} else if (0 == strcmp(*p, GK_SYMBOL_OPTION_PROGRESS)) {
+		GK_RETURN(GK_NUMBER(job->progress()));
+	} else if (0 == strcmp(*p, GK_SYMBOL_OPTION_CANCELLED)) {
+		GK_RETURN(GK_BOOLEAN(job->cancelled()));
+	} else if (0 == strcmp(*p, GK_SYMBOL_OPTION_DONE)) {
+		GK_RETURN(GK_BOOLEAN(job->done_));
+	}
+}
@@ -0,0 +1,170 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Job.h
+*
+* A handle to a native operation running on the Scheduler. The Job settles a
+* Promise on the v8 thread once the work is done, reports progress through an
+* optional callback and can be cancelled from JavaScript.
+*/
+
+#ifndef GRAPHKIT_SRC_JOB_H
+#define GRAPHKIT_SRC_JOB_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <uv.h>
+#include "exports.h"
+#include "Export.h"
+#include "Scheduler.h"
+
+namespace gk {
+	class Job : public gk::Export {
+	public:
+
+		// aliases
+		using Work = std::function<void(gk::Job& job)>;
+		using Complete = std::function<v8::Local<v8::Value>(v8::Isolate* isolate, gk::Job& job)>;
+
+		/**
+		* Job
+		* Constructor.
+		*/
+		Job() noexcept;
+
+		/**
+		* ~Job
+		* Destructor.
+		*/
+		virtual ~Job();
+
+		// defaults
+		Job(const Job&) = delete;
+		Job& operator= (const Job&) = delete;
+		Job(Job&&) = delete;
+		Job& operator= (Job&&) = delete;
+
+		/**
+		* start
+		* Runs work on the Scheduler, then resolves the Promise with the value
+		* returned by complete on the v8 thread. The Job is kept alive until
+		* it has settled.
+		* @param		v8::Isolate* isolate
+		* @param		Work work
+		* @param		Complete complete
+		* @param		v8::Local<v8::Value> progress, an optional callback Function
+		*/
+		void start(v8::Isolate* isolate, Work work, Complete complete, v8::Local<v8::Value> progress) noexcept;
+
+		/**
+		* monitor
+		* A Monitor that reports progress and stops the work once cancelled.
+		* @return		gk::Scheduler::Monitor
+		*/
+		gk::Scheduler::Monitor monitor() noexcept;
+
+		/**
+		* progress
+		* The completed fraction of the work.
+		* @return		double
+		*/
+		double progress() const noexcept;
+
+		/**
+		* progress
+		* Records the completed fraction, may be called from any thread.
+		* @param		double fraction
+		*/
+		void progress(double fraction) noexcept;
+
+		/**
+		* cancelled
+		* Whether the Job has been cancelled.
+		* @return		bool
+		*/
+		bool cancelled() const noexcept;
+
+		/**
+		* cancel
+		* Asks the work to stop, the Promise is rejected.
+		*/
+		void cancel() noexcept;
+
+		/**
+		* fail
+		* Rejects the Promise with a message, called from the work.
+		* @param		const std::string& message
+		*/
+		void fail(const std::string& message) noexcept;
+
+		/**
+		* context
+		* An Object holding the values the work needs kept alive.
+		* @param		v8::Isolate* isolate
+		* @return		v8::Local<v8::Object>
+		*/
+		v8::Local<v8::Object> context(v8::Isolate* isolate) noexcept;
+
+		static gk::Job* Instance(v8::Isolate* isolate) noexcept;
+		static GK_INIT(Init);
+
+	private:
+		std::atomic<double> progress_;
+		double reported_;
+		std::atomic<bool> cancelled_;
+		std::atomic<bool> done_;
+		std::atomic<bool> reporting_;
+		std::string error_;
+		Complete complete_;
+		uv_async_t async_;
+		v8::Persistent<v8::Promise::Resolver> resolver_;
+		v8::Persistent<v8::Function> callback_;
+		v8::Persistent<v8::Object> context_;
+
+		/**
+		* report
+		* Calls the progress callback if the progress changed.
+		* @param		v8::Isolate* isolate
+		*/
+		void report(v8::Isolate* isolate) noexcept;
+
+		/**
+		* notify
+		* Delivers progress on the v8 thread.
+		* @param		uv_async_t* handle
+		*/
+		static void notify(uv_async_t* handle) noexcept;
+
+		/**
+		* finish
+		* Settles the Promises of the Jobs whose work returned and closes
+		* their handles, on the v8 thread.
+		* @param		uv_async_t* handle
+		*/
+		static void finish(uv_async_t* handle) noexcept;
+
+		static GK_CONSTRUCTOR(constructor_);
+		static GK_METHOD(New);
+		static GK_METHOD(Cancel);
+		static GK_METHOD(Then);
+		static GK_METHOD(Threads);
+		static GK_PROPERTY_GETTER(PropertyGetter);
+	};
+}
+
+#endif
@@ -0,0 +1,1170 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <uv.h>
+#include "Loader.h"
+#include "symbols.h"
+#include "Coordinator.h"
+#include "Entity.h"
+#include "Action.h"
+#include "Bond.h"
+#include "Scheduler.h"
+#include "Ring.h"
+#include "Codec.h"
+#include "Encoder.h"
+
+// records parsed per chunk of work
+static const std::size_t GK_LOADER_CHUNK = 256;
+
+// reads a whole file with a single read sized from fstat, on any thread
+static bool contents(const std::string& file, std::string& data) {
+	uv_fs_t open_req;
+	uv_fs_open(uv_default_loop(), &open_req, file.c_str(), O_RDONLY, 0, NULL);
+	auto fd = open_req.result;
+	uv_fs_req_cleanup(&open_req);
+	if (0 > fd) {
+		return false;
+	}
+	uv_fs_t stat_req;
+	uv_fs_fstat(uv_default_loop(), &stat_req, fd, NULL);
+	std::size_t size = 0 == stat_req.result ? stat_req.statbuf.st_size : 0;
+	uv_fs_req_cleanup(&stat_req);
+	data.resize(size);
+	std::size_t offset = 0;
+	auto ring = gk::Ring::local();
+	while (offset < size) {
+		long long n;
+		if (ring) {
+			n = ring->read(fd, &data[offset], size - offset, offset);
+		} else {
+			uv_buf_t iov = uv_buf_init(&data[offset], size - offset);
+			uv_fs_t read_req;
+			uv_fs_read(uv_default_loop(), &read_req, fd, &iov, 1, offset, NULL);
+			n = read_req.result;
+			uv_fs_req_cleanup(&read_req);
+		}
+		if (0 >= n) {
+			break;
+		}
+		offset += n;
+	}
+	data.resize(offset);
+	uv_fs_t close_req;
+	uv_fs_close(uv_default_loop(), &close_req, fd, NULL);
+	uv_fs_req_cleanup(&close_req);
+	return true;
+}
+
+// a forward only JSON reader that decodes straight into records, without a document
+class Cursor {
+public:
+	Cursor(const char* data, std::size_t size)
+		: p_{data},
+		  end_{data + size} {}
+
+	bool done() {
+		space();
+		return p_ == end_;
+	}
+
+	bool peek(char c) {
+		space();
+		return p_ < end_ && c == *p_;
+	}
+
+	bool eat(char c) {
+		if (!peek(c)) {
+			return false;
+		}
+		++p_;
+		return true;
+	}
+
+	bool literal(const char* word) {
+		space();
+		auto n = strlen(word);
+		if (static_cast<std::size_t>(end_ - p_) < n || 0 != memcmp(p_, word, n)) {
+			return false;
+		}
+		p_ += n;
+		return true;
+	}
+
+	bool number(long long& out) {
+		space();
+		auto negative = p_ < end_ && '-' == *p_;
+		if (negative) {
+			++p_;
+		}
+		if (p_ == end_ || '0' > *p_ || '9' < *p_) {
+			return false;
+		}
+		unsigned long long v = 0;
+		for (; p_ < end_ && '0' <= *p_ && '9' >= *p_; ++p_) {
+			v = v * 10 + (*p_ - '0');
+		}
+		out = negative ? -static_cast<long long>(v) : static_cast<long long>(v);
+		return true;
+	}
+
+	bool string(std::string& out) {
+		out.clear();
+		if (!eat('"')) {
+			return false;
+		}
+		while (p_ < end_) {
+			auto q = p_;
+			while (q < end_ && '"' != *q && '\\' != *q) {
+				++q;
+			}
+			out.append(p_, q);
+			p_ = q;
+			if (p_ == end_) {
+				return false;
+			}
+			if ('"' == *p_++) {
+				return true;
+			}
+			if (p_ == end_) {
+				return false;
+			}
+			switch (*p_++) {
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/': out += '/'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u': {
+					unsigned long c;
+					if (!hex(c)) {
+						return false;
+					}
+					// a surrogate pair encodes a code point above the basic plane
+					if (0xd800 <= c && 0xdbff >= c && 2 <= end_ - p_ && '\\' == p_[0] && 'u' == p_[1]) {
+						p_ += 2;
+						unsigned long low;
+						if (!hex(low)) {
+							return false;
+						}
+						c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+					}
+					utf8(c, out);
+					break;
+				}
+				default:
+					return false;
+			}
+		}
+		return false;
+	}
+
+	// skips any value
+	bool skip() {
+		space();
+		if (p_ == end_) {
+			return false;
+		}
+		std::string s;
+		switch (*p_) {
+			case '"':
+				return string(s);
+			case '{':
+				++p_;
+				if (eat('}')) {
+					return true;
+				}
+				do {
+					if (!string(s) || !eat(':') || !skip()) {
+						return false;
+					}
+				} while (eat(','));
+				return eat('}');
+			case '[':
+				++p_;
+				if (eat(']')) {
+					return true;
+				}
+				do {
+					if (!skip()) {
+						return false;
+					}
+				} while (eat(','));
+				return eat(']');
+			case 't':
+				return literal("true");
+			case 'f':
+				return literal("false");
+			case 'n':
+				return literal("null");
+			default: {
+				auto q = p_;
+				while (p_ < end_ && (('0' <= *p_ && '9' >= *p_) || '-' == *p_ || '+' == *p_ || '.' == *p_ || 'e' == *p_ || 'E' == *p_)) {
+					++p_;
+				}
+				return q != p_;
+			}
+		}
+	}
+
+	// reads the members of an object, field is called with each key
+	template <typename F>
+	bool object(F field) {
+		if (!eat('{')) {
+			return false;
+		}
+		if (eat('}')) {
+			return true;
+		}
+		std::string key;
+		do {
+			if (!string(key) || !eat(':') || !field(key)) {
+				return false;
+			}
+		} while (eat(','));
+		return eat('}');
+	}
+
+	// reads the elements of an array, element is called for each
+	template <typename F>
+	bool array(F element) {
+		if (!eat('[')) {
+			return false;
+		}
+		if (eat(']')) {
+			return true;
+		}
+		do {
+			if (!element()) {
+				return false;
+			}
+		} while (eat(','));
+		return eat(']');
+	}
+
+private:
+	const char* p_;
+	const char* end_;
+
+	void space() {
+		while (p_ < end_ && (' ' == *p_ || '\n' == *p_ || '\r' == *p_ || '\t' == *p_ || '\0' == *p_)) {
+			++p_;
+		}
+	}
+
+	bool hex(unsigned long& out) {
+		if (4 > end_ - p_) {
+			return false;
+		}
+		out = 0;
+		for (auto i = 0; i < 4; ++i, ++p_) {
+			auto c = *p_;
+			out <<= 4;
+			if ('0' <= c && '9' >= c) {
+				out |= c - '0';
+			} else if ('a' <= c && 'f' >= c) {
+				out |= c - 'a' + 10;
+			} else if ('A' <= c && 'F' >= c) {
+				out |= c - 'A' + 10;
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void utf8(unsigned long c, std::string& out) {
+		if (0x80 > c) {
+			out += static_cast<char>(c);
+		} else if (0x800 > c) {
+			out += static_cast<char>(0xc0 | (c >> 6));
+			out += static_cast<char>(0x80 | (c & 0x3f));
+		} else if (0x10000 > c) {
+			out += static_cast<char>(0xe0 | (c >> 12));
+			out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (c & 0x3f));
+		} else {
+			out += static_cast<char>(0xf0 | (c >> 18));
+			out += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+			out += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+			out += static_cast<char>(0x80 | (c & 0x3f));
+		}
+	}
+};
+
+// reads a Node reference, an object, a [nodeClass, type, id] array or null
+static bool reference(Cursor& cursor, gk::Loader::Reference& reference, bool& found) {
+	found = false;
+	if (cursor.literal("null")) {
+		return true;
+	}
+	if (cursor.peek('[')) {
+		long long nodeClass = 0;
+		found = cursor.eat('[') && cursor.number(nodeClass) && cursor.eat(',') &&
+			cursor.string(reference.type) && cursor.eat(',') && cursor.number(reference.id) && cursor.eat(']');
+		reference.nodeClass = static_cast<short>(nodeClass);
+		return found;
+	}
+	found = cursor.object([&](const std::string& key) {
+		long long v;
+		if ("id" == key) {
+			return cursor.number(reference.id);
+		}
+		if ("nodeClass" == key) {
+			if (!cursor.number(v)) {
+				return false;
+			}
+			reference.nodeClass = static_cast<short>(v);
+			return true;
+		}
+		if ("type" == key) {
+			return cursor.string(reference.type);
+		}
+		return cursor.skip();
+	});
+	return found;
+}
+
+// reads an array of references
+static bool references(Cursor& cursor, std::vector<gk::Loader::Reference>& out) {
+	return cursor.array([&]() {
+		gk::Loader::Reference r{};
+		bool found;
+		if (!reference(cursor, r, found)) {
+			return false;
+		}
+		if (found) {
+			out.push_back(r);
+		}
+		return true;
+	});
+}
+
+// reads an array of [key, value] properties
+static bool properties(Cursor& cursor, std::vector<std::pair<std::string, std::string>>& out) {
+	return cursor.array([&]() {
+		out.emplace_back();
+		auto& property = out.back();
+		return cursor.eat('[') && cursor.string(property.first) && cursor.eat(',') && cursor.string(property.second) && cursor.eat(']');
+	});
+}
+
+// reads an array of strings
+static bool strings(Cursor& cursor, std::vector<std::string>& out) {
+	return cursor.array([&]() {
+		out.emplace_back();
+		return cursor.string(out.back());
+	});
+}
+
+// reads the image of a Node into an insert record
+static bool image(Cursor& cursor, gk::Loader::Record& record) {
+	record.mutation = gk::Mutation::Insert;
+	return cursor.object([&](const std::string& key) {
+		long long v;
+		bool found;
+		gk::Loader::Reference r{};
+		if ("id" == key) {
+			return cursor.number(record.node.id);
+		}
+		if ("nodeClass" == key) {
+			if (!cursor.number(v)) {
+				return false;
+			}
+			record.node.nodeClass = static_cast<short>(v);
+			return true;
+		}
+		if ("type" == key) {
+			return cursor.string(record.node.type);
+		}
+		if ("rank" == key) {
+			if (cursor.number(record.rank)) {
+				record.ranked = true;
+				return true;
+			}
+			return cursor.skip();
+		}
+		if ("groups" == key) {
+			return strings(cursor, record.groups);
+		}
+		if ("properties" == key) {
+			return properties(cursor, record.properties);
+		}
+		if ("subjects" == key) {
+			return references(cursor, record.subjects);
+		}
+		if ("objects" == key) {
+			return references(cursor, record.objects);
+		}
+
+		// a Bond has a single subject and object
+		if ("subject" == key || "object" == key) {
+			if (!reference(cursor, r, found)) {
+				return false;
+			}
+			if (found) {
+				("subject" == key ? record.subjects : record.objects).push_back(r);
+			}
+			return true;
+		}
+		return cursor.skip();
+	});
+}
+
+// reads a log record, a batch reads the records it nests
+static bool entry(Cursor& cursor, gk::Loader::Record& record) {
+	record.mutation = gk::Mutation::Unknown;
+	record.ranked = false;
+	gk::Mutation mutation = gk::Mutation::Unknown;
+	bool node = false;
+	auto ok = cursor.object([&](const std::string& key) {
+		bool found;
+		if ("op" == key) {
+			std::string op;
+			if (!cursor.string(op)) {
+				return false;
+			}
+			mutation = gk::MutationFromString(op);
+			return true;
+		}
+		if ("node" == key) {
+			return reference(cursor, record.node, node);
+		}
+		if ("target" == key) {
+			return reference(cursor, record.target, found);
+		}
+		if ("key" == key) {
+			return cursor.string(record.key);
+		}
+		if ("value" == key) {
+			return cursor.string(record.value);
+		}
+		if ("data" == key) {
+			return ::image(cursor, record);
+		}
+
+		// an update carries the last change of each key
+		if ("properties" == key) {
+			return properties(cursor, record.properties);
+		}
+		if ("deleted" == key) {
+			return strings(cursor, record.deleted);
+		}
+
+		// a batch nests the records committed together
+		if ("records" == key) {
+			return cursor.array([&]() {
+				record.records.emplace_back();
+				return entry(cursor, record.records.back());
+			});
+		}
+		return cursor.skip();
+	});
+	record.mutation = ok && (node || gk::Mutation::Batch == mutation) ? mutation : gk::Mutation::Unknown;
+	return gk::Mutation::Unknown != record.mutation;
+}
+
+// reads a binary Node reference, class 0 is a null reference
+static bool reference(gk::Decoder& decoder, gk::Loader::Reference& reference, bool& found) {
+	uint64_t nodeClass;
+	found = false;
+	if (!decoder.count(nodeClass)) {
+		return false;
+	}
+	reference.nodeClass = static_cast<short>(nodeClass);
+	if (GK_SYMBOL_NODE_CLASS_NODE_CONSTANT == nodeClass) {
+		return true;
+	}
+	found = decoder.symbol(reference.type) && decoder.number(reference.id);
+	return found;
+}
+
+// reads a binary array of references
+static bool references(gk::Decoder& decoder, std::vector<gk::Loader::Reference>& out) {
+	uint64_t n;
+	if (!decoder.count(n)) {
+		return false;
+	}
+	for (; 0 < n; --n) {
+		gk::Loader::Reference r{};
+		bool found;
+		if (!reference(decoder, r, found)) {
+			return false;
+		}
+		if (found) {
+			out.push_back(std::move(r));
+		}
+	}
+	return true;
+}
+
+// reads the binary image of a Node into an insert record
+static bool image(gk::Decoder& decoder, gk::Loader::Record& record) {
+	uint64_t n;
+	if (!decoder.number(record.rank)) {
+		return false;
+	}
+	record.ranked = 0 <= record.rank;
+	if (!decoder.count(n)) {
+		return false;
+	}
+	for (; 0 < n; --n) {
+		record.properties.emplace_back();
+		if (!decoder.symbol(record.properties.back().first) || !decoder.string(record.properties.back().second)) {
+			return false;
+		}
+	}
+	if (!decoder.count(n)) {
+		return false;
+	}
+	for (; 0 < n; --n) {
+		record.groups.emplace_back();
+		if (!decoder.symbol(record.groups.back())) {
+			return false;
+		}
+	}
+	return references(decoder, record.subjects) && references(decoder, record.objects);
+}
+
+// reads a binary log record, a batch reads the records it nests
+static bool entry(gk::Decoder& decoder, gk::Loader::Record& record) {
+	record.mutation = gk::Mutation::Unknown;
+	record.ranked = false;
+	gk::Mutation mutation;
+	bool found;
+	uint64_t n;
+	if (!decoder.mutation(mutation)) {
+		return false;
+	}
+	if (gk::Mutation::Batch == mutation) {
+		while (!decoder.done()) {
+			gk::Decoder nested{nullptr, 0, nullptr};
+			record.records.emplace_back();
+			if (!decoder.record(nested) || !entry(nested, record.records.back())) {
+				return false;
+			}
+		}
+		record.mutation = mutation;
+		return true;
+	}
+	if (!reference(decoder, record.node, found) || !found) {
+		return false;
+	}
+	auto ok = true;
+	switch (mutation) {
+		case gk::Mutation::Insert:
+			ok = image(decoder, record);
+			break;
+		case gk::Mutation::Update:
+			ok = decoder.count(n);
+			for (; ok && 0 < n; --n) {
+				record.properties.emplace_back();
+				ok = decoder.symbol(record.properties.back().first) && decoder.string(record.properties.back().second);
+			}
+			ok = ok && decoder.count(n);
+			for (; ok && 0 < n; --n) {
+				record.deleted.emplace_back();
+				ok = decoder.symbol(record.deleted.back());
+			}
+			break;
+		case gk::Mutation::AddSubject:
+		case gk::Mutation::RemoveSubject:
+		case gk::Mutation::AddObject:
+		case gk::Mutation::RemoveObject:
+		case gk::Mutation::Subject:
+		case gk::Mutation::Object:
+			ok = reference(decoder, record.target, found);
+			break;
+		case gk::Mutation::Drop:
+			break;
+		default:
+			ok = decoder.symbol(record.key) && decoder.string(record.value);
+			break;
+	}
+	if (!ok || !decoder.done()) {
+		return false;
+	}
+	record.mutation = mutation;
+	return true;
+}
+
+// writes a reference as a [nodeClass, type, id] array or a {id, nodeClass, type} object
+static void reference(const gk::Loader::Reference& reference, bool object, std::string& out) {
+	if (object) {
+		out += "{\"id\":" + std::to_string(reference.id) + ",\"nodeClass\":" + std::to_string(reference.nodeClass) + ",\"type\":" + gk::Node::escape(reference.type) + "}";
+		return;
+	}
+	out += "[" + std::to_string(reference.nodeClass) + "," + gk::Node::escape(reference.type) + "," + std::to_string(reference.id) + "]";
+}
+
+// writes an array of [key, value] properties
+static void properties(const std::vector<std::pair<std::string, std::string>>& properties, std::string& out) {
+	out += '[';
+	for (auto& property : properties) {
+		out += (&property == &properties.front() ? "[" : ",[") + gk::Node::escape(property.first) + "," + gk::Node::escape(property.second) + "]";
+	}
+	out += ']';
+}
+
+// writes an array of strings
+static void strings(const std::vector<std::string>& strings, std::string& out) {
+	out += '[';
+	for (auto& s : strings) {
+		if (&s != &strings.front()) {
+			out += ',';
+		}
+		out += gk::Node::escape(s);
+	}
+	out += ']';
+}
+
+// writes the image of an insert record, as the Nodes write themselves
+static void image(const gk::Loader::Record& record, std::string& out) {
+	out += "{\"id\":" + std::to_string(record.node.id) + ",\"nodeClass\":" + std::to_string(record.node.nodeClass) + ",\"type\":" + gk::Node::escape(record.node.type);
+	if (record.ranked) {
+		out += ",\"rank\":" + std::to_string(record.rank);
+	}
+	out += ",\"properties\":";
+	properties(record.properties, out);
+	out += ",\"groups\":";
+	strings(record.groups, out);
+	if (GK_SYMBOL_NODE_CLASS_ACTION_CONSTANT == record.node.nodeClass) {
+		for (auto relationship : {std::make_pair(",\"subjects\":[", &record.subjects), std::make_pair(",\"objects\":[", &record.objects)}) {
+			out += relationship.first;
+			for (auto& r : *relationship.second) {
+				if (&r != &relationship.second->front()) {
+					out += ',';
+				}
+				reference(r, true, out);
+			}
+			out += ']';
+		}
+	} else if (GK_SYMBOL_NODE_CLASS_BOND_CONSTANT == record.node.nodeClass) {
+		for (auto relationship : {std::make_pair(",\"subject\":", &record.subjects), std::make_pair(",\"object\":", &record.objects)}) {
+			if (!relationship.second->empty()) {
+				out += relationship.first;
+				reference(relationship.second->front(), true, out);
+			}
+		}
+	}
+	out += '}';
+}
+
+static bool same(const gk::Loader::Reference& a, const gk::Loader::Reference& b) {
+	return a.id == b.id && a.nodeClass == b.nodeClass && a.type == b.type;
+}
+
+gk::Loader::Loader() noexcept
+	: sources_{},
+	  records_{},
+	  pending_{} {}
+
+gk::Loader::~Loader() {}
+
+void gk::Loader::file(const std::string& path) noexcept {
+	sources_.push_back({path, Source::Kind::File, nullptr});
+}
+
+void gk::Loader::segment(const std::string& path) noexcept {
+	sources_.push_back({path, Source::Kind::Segment, nullptr});
+}
+
+void gk::Loader::record(const std::string& line) noexcept {
+	sources_.push_back({line, Source::Kind::Record, nullptr});
+}
+
+std::size_t gk::Loader::count() const noexcept {
+	return sources_.size();
+}
+
+bool gk::Loader::parse(const std::string& text, bool image, Record& record) noexcept {
+	record.mutation = gk::Mutation::Unknown;
+	record.node = Reference{};
+	record.target = Reference{};
+	record.ranked = false;
+	Cursor cursor{text.data(), text.size()};
+	if (image) {
+		if (!::image(cursor, record) || !cursor.done()) {
+			record.mutation = gk::Mutation::Unknown;
+			return false;
+		}
+		return true;
+	}
+
+	if (!entry(cursor, record) || !cursor.done()) {
+		record.mutation = gk::Mutation::Unknown;
+		return false;
+	}
+	return true;
+}
+
+bool gk::Loader::decode(const std::string& payload, const std::vector<std::string>* symbols, Record& record) noexcept {
+	record.node = Reference{};
+	record.target = Reference{};
+	gk::Decoder decoder{payload.data(), payload.size(), symbols};
+	if (!entry(decoder, record)) {
+		record.mutation = gk::Mutation::Unknown;
+		return false;
+	}
+	return true;
+}
+
+void gk::Loader::json(const Record& record, std::string& out) noexcept {
+	out += "{\"op\":\"" + std::string(gk::MutationToString(record.mutation)) + "\"";
+	if (gk::Mutation::Batch == record.mutation) {
+		out += ",\"records\":[";
+		for (auto& r : record.records) {
+			if (&r != &record.records.front()) {
+				out += ',';
+			}
+			json(r, out);
+		}
+		out += "]}";
+		return;
+	}
+	out += ",\"node\":";
+	reference(record.node, false, out);
+	switch (record.mutation) {
+		case gk::Mutation::Insert:
+			out += ",\"data\":";
+			image(record, out);
+			break;
+		case gk::Mutation::Update:
+			out += ",\"properties\":";
+			properties(record.properties, out);
+			out += ",\"deleted\":";
+			strings(record.deleted, out);
+			break;
+		case gk::Mutation::AddSubject:
+		case gk::Mutation::RemoveSubject:
+		case gk::Mutation::AddObject:
+		case gk::Mutation::RemoveObject:
+		case gk::Mutation::Subject:
+		case gk::Mutation::Object:
+			out += ",\"target\":";
+			reference(record.target, false, out);
+			break;
+		case gk::Mutation::Drop:
+			break;
+		default:
+			if (!record.key.empty()) {
+				out += ",\"key\":" + gk::Node::escape(record.key);
+			}
+			if (gk::Mutation::Set == record.mutation || !record.value.empty()) {
+				out += ",\"value\":" + gk::Node::escape(record.value);
+			}
+			break;
+	}
+	out += '}';
+}
+
+std::string gk::Loader::json() const noexcept {
+	std::string out;
+	for (auto& record : records_) {
+		if (gk::Mutation::Unknown != record.mutation) {
+			json(record, out);
+			out += '\n';
+		}
+	}
+	return out;
+}
+
+std::size_t gk::Loader::split(const char* data, std::size_t size, std::shared_ptr<const std::vector<std::string>>& symbols, std::vector<Source>& out) noexcept {
+	std::size_t first = 0;
+	while (first < size && !gk::Codec::framed(data + first, size - first)) {
+		if (gk::Decoder::marked(data + first, size - first)) {
+			const char* payload;
+			std::size_t length;
+			std::size_t used;
+			if (!gk::Decoder::record(data + first, size - first, payload, length, used)) {
+				break;
+			}
+			first += used;
+
+			// the records that follow a table resolve their symbols in it
+			if (gk::Mutation::Symbols == static_cast<gk::Mutation>(*payload)) {
+				auto table = std::make_shared<std::vector<std::string>>();
+				symbols = gk::Decoder::table(payload, length, *table) ? table : nullptr;
+			} else {
+				out.push_back({std::string{payload, length}, Source::Kind::Binary, symbols});
+			}
+			continue;
+		}
+		auto end = static_cast<const char*>(memchr(data + first, '\n', size - first));
+		if (nullptr == end) {
+			break;
+		}
+		std::size_t last = end - data;
+		if (first < last) {
+			out.push_back({std::string{data + first, last - first}, Source::Kind::Record, nullptr});
+		}
+		first = last + 1;
+	}
+	return first;
+}
+
+void gk::Loader::expand(unsigned threads) noexcept {
+	std::vector<std::size_t> segments;
+	for (std::size_t i = 0; i < sources_.size(); ++i) {
+		if (Source::Kind::Segment == sources_[i].kind) {
+			segments.push_back(i);
+		}
+	}
+	if (segments.empty()) {
+		return;
+	}
+
+	std::vector<std::vector<Source>> lines(segments.size());
+	std::atomic<std::size_t> next{0};
+	gk::Scheduler::instance().parallel(threads, [&]() {
+		std::string data;
+		std::string block;
+		for (auto s = next++; s < segments.size(); s = next++) {
+			data.clear();
+			if (!contents(sources_[segments[s]].text, data)) {
+				continue;
+			}
+
+			// a segment is read in order, each batch starts with its symbol table
+			std::shared_ptr<const std::vector<std::string>> symbols;
+			std::size_t first = 0;
+			while (first < data.length()) {
+				// a compressed batch is a framed block of records, torn or corrupt it ends the segment
+				if (gk::Codec::framed(data.data() + first, data.length() - first)) {
+					std::size_t used;
+					if (!gk::Codec::unframe(data.data() + first, data.length() - first, block, used)) {
+						break;
+					}
+					split(block.data(), block.length(), symbols, lines[s]);
+					first += used;
+					continue;
+				}
+				auto used = split(data.data() + first, data.length() - first, symbols, lines[s]);
+				if (0 == used) {
+					break;
+				}
+				first += used;
+			}
+		}
+	});
+
+	std::vector<Source> sources;
+	std::size_t s = 0;
+	for (auto& source : sources_) {
+		if (Source::Kind::Segment != source.kind) {
+			sources.push_back(std::move(source));
+			continue;
+		}
+		for (auto& line : lines[s]) {
+			sources.push_back(std::move(line));
+		}
+		std::vector<Source>{}.swap(lines[s++]);
+	}
+	sources_.swap(sources);
+}
+
+void gk::Loader::parse(unsigned threads) noexcept {
+	expand(threads);
+	records_.clear();
+	records_.resize(sources_.size());
+	std::atomic<std::size_t> next{0};
+	gk::Scheduler::instance().parallel(threads, [&]() {
+		std::string data;
+		for (auto c = next.fetch_add(GK_LOADER_CHUNK); c < sources_.size(); c = next.fetch_add(GK_LOADER_CHUNK)) {
+			auto last = std::min(sources_.size(), c + GK_LOADER_CHUNK);
+			for (auto i = c; i < last; ++i) {
+				auto& source = sources_[i];
+				if (Source::Kind::Record == source.kind) {
+					parse(source.text, false, records_[i]);
+					continue;
+				}
+				if (Source::Kind::Binary == source.kind) {
+					decode(source.text, source.symbols.get(), records_[i]);
+					continue;
+				}
+				data.clear();
+				if (!contents(source.text, data)) {
+					records_[i].mutation = gk::Mutation::Unknown;
+				} else if (data.empty()) {
+					uv_fs_t unlink_req;
+					uv_fs_unlink(uv_default_loop(), &unlink_req, source.text.c_str(), NULL);
+					uv_fs_req_cleanup(&unlink_req);
+					records_[i].mutation = gk::Mutation::Unknown;
+				} else {
+					parse(data, true, records_[i]);
+				}
+			}
+		}
+	});
+	sources_.clear();
+	sources_.shrink_to_fit();
+}
+
+void gk::Loader::apply(v8::Isolate* isolate, gk::Coordinator* coordinator) noexcept {
+	for (auto& record : records_) {
+		v8::HandleScope scope(isolate);
+		apply(isolate, coordinator, record);
+	}
+	records_.clear();
+	records_.shrink_to_fit();
+	resolve(isolate, coordinator);
+}
+
+gk::Node* gk::Loader::find(gk::Coordinator* coordinator, const Reference& reference) noexcept {
+	if (GK_SYMBOL_NODE_CLASS_NODE_CONSTANT == reference.nodeClass) {
+		return nullptr;
+	}
+	auto cluster = coordinator->nodeGraph()->findByKey(gk::NodeClassFromInt(reference.nodeClass));
+	if (cluster && 0 < cluster->count()) {
+		auto index = cluster->findByKey(reference.type);
+		if (index && 0 < index->count()) {
+			return index->findByKey(reference.id);
+		}
+	}
+	return nullptr;
+}
+
+void gk::Loader::insert(v8::Isolate* isolate, gk::Coordinator* coordinator, const Record& record) noexcept {
+	gk::Node* node = nullptr;
+	auto nodeClass = gk::NodeClassFromInt(record.node.nodeClass);
+	if (nodeClass == gk::NodeClass::Entity) {
+		node = gk::Entity::Instance(isolate, record.node.type.c_str());
+	} else if (nodeClass == gk::NodeClass::Action) {
+		node = gk::Action<gk::Entity>::Instance(isolate, record.node.type.c_str());
+	} else if (nodeClass == gk::NodeClass::Bond) {
+		node = gk::Bond<gk::Entity>::Instance(isolate, record.node.type.c_str());
+	} else {
+		return;
+	}
+
+	auto id = record.node.id;
+	node->id(std::move(id));
+	node->indexed(true);
+	if (record.ranked) {
+		node->rank(record.rank);
+	}
+	coordinator->insertNode(isolate, node);
+
+	for (auto& name : record.groups) {
+		std::string* v = new std::string(name);
+		node->groups()->insert(*v, v);
+		coordinator->insertGroup(isolate, *v, node);
+	}
+
+	for (auto& property : record.properties) {
+		node->properties()->insert(property.first, new std::string(property.second));
+	}
+	node->modified();
+
+	// linked once every Node exists
+	auto action = nodeClass == gk::NodeClass::Action;
+	for (auto& subject : record.subjects) {
+		pending_[node].push_back({action ? gk::Mutation::AddSubject : gk::Mutation::Subject, subject});
+	}
+	for (auto& object : record.objects) {
+		pending_[node].push_back({action ? gk::Mutation::AddObject : gk::Mutation::Object, object});
+	}
+}
+
+void gk::Loader::settle(gk::Node* node, gk::Mutation mutation, const Reference* target) noexcept {
+	if (pending_.empty()) {
+		return;
+	}
+	auto it = pending_.find(node);
+	if (pending_.end() == it) {
+		return;
+	}
+	auto& edges = it->second;
+	edges.erase(std::remove_if(edges.begin(), edges.end(), [&](const Edge& edge) {
+		return mutation == edge.mutation && (!target || same(*target, edge.target));
+	}), edges.end());
+}
+
+void gk::Loader::resolve(v8::Isolate* isolate, gk::Coordinator* coordinator) noexcept {
+	for (auto& pending : pending_) {
+		v8::HandleScope scope(isolate);
+		auto action = dynamic_cast<gk::Action<gk::Entity>*>(pending.first);
+		auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(pending.first);
+		for (auto& edge : pending.second) {
+			auto target = dynamic_cast<gk::Entity*>(find(coordinator, edge.target));
+			if (!target) {
+				continue;
+			}
+			if (action && gk::Mutation::AddSubject == edge.mutation) {
+				action->addSubject(isolate, target);
+			} else if (action && gk::Mutation::AddObject == edge.mutation) {
+				action->addObject(isolate, target);
+			} else if (bond && gk::Mutation::Subject == edge.mutation) {
+				bond->subject(isolate, target);
+			} else if (bond && gk::Mutation::Object == edge.mutation) {
+				bond->object(isolate, target);
+			}
+		}
+	}
+	pending_.clear();
+}
+
+void gk::Loader::apply(v8::Isolate* isolate, gk::Coordinator* coordinator, const Record& record) noexcept {
+	if (gk::Mutation::Unknown == record.mutation) {
+		return;
+	}
+	if (gk::Mutation::Batch == record.mutation) {
+		for (auto& r : record.records) {
+			apply(isolate, coordinator, r);
+		}
+		return;
+	}
+	if (gk::Mutation::Drop == record.mutation) {
+		// the relationships pending on the dropped Nodes go with them
+		for (auto it = pending_.begin(); pending_.end() != it;) {
+			if (record.node.nodeClass == gk::NodeClassToInt(it->first->nodeClass()) && record.node.type == it->first->type()) {
+				it = pending_.erase(it);
+			} else {
+				++it;
+			}
+		}
+		coordinator->dropType(gk::NodeClassFromInt(record.node.nodeClass), record.node.type);
+		return;
+	}
+	auto node = find(coordinator, record.node);
+	if (gk::Mutation::Insert == record.mutation) {
+		if (!node) {
+			insert(isolate, coordinator, record);
+		}
+		return;
+	}
+	if (!node) {
+		return;
+	}
+
+	auto& key = record.key;
+	auto& value = record.value;
+	auto target = dynamic_cast<gk::Entity*>(find(coordinator, record.target));
+	auto action = dynamic_cast<gk::Action<gk::Entity>*>(node);
+	auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(node);
+
+	switch (record.mutation) {
+		case gk::Mutation::Remove:
+			pending_.erase(node);
+			if (coordinator->removeNode(node->nodeClass(), node->type(), node->id())) {
+				auto groups = node->groups();
+				for (auto i = groups->count(); 0 < i; --i) {
+					coordinator->removeGroup(*groups->select(i), node->hash());
+				}
+			}
+			break;
+		case gk::Mutation::Set:
+			node->properties()->remove(key, [](std::string* v) {
+				delete v;
+			});
+			node->properties()->insert(key, new std::string{value});
+			break;
+		case gk::Mutation::Delete:
+			node->properties()->remove(key, [](std::string* v) {
+				delete v;
+			});
+			break;
+		case gk::Mutation::Update:
+			for (auto& k : record.deleted) {
+				node->properties()->remove(k, [](std::string* v) {
+					delete v;
+				});
+			}
+			for (auto& property : record.properties) {
+				node->properties()->remove(property.first, [](std::string* v) {
+					delete v;
+				});
+				node->properties()->insert(property.first, new std::string{property.second});
+			}
+			break;
+		case gk::Mutation::AddGroup: {
+			std::string* v = new std::string{key};
+			if (node->groups()->insert(*v, v)) {
+				coordinator->insertGroup(isolate, *v, node);
+			} else {
+				delete v;
+			}
+			break;
+		}
+		case gk::Mutation::RemoveGroup:
+			node->groups()->remove(key, [&](std::string* v) {
+				coordinator->removeGroup(*v, node->hash());
+				delete v;
+			});
+			break;
+		case gk::Mutation::AddSubject:
+			settle(node, gk::Mutation::AddSubject, &record.target);
+			if (action && target) {
+				action->addSubject(isolate, target);
+			}
+			break;
+		case gk::Mutation::RemoveSubject:
+			if (action) {
+				settle(node, gk::Mutation::AddSubject, &record.target);
+				if (target) {
+					action->removeSubject(isolate, target);
+				}
+			} else if (bond) {
+				settle(node, gk::Mutation::Subject, nullptr);
+				bond->removeSubject();
+			}
+			break;
+		case gk::Mutation::AddObject:
+			settle(node, gk::Mutation::AddObject, &record.target);
+			if (action && target) {
+				action->addObject(isolate, target);
+			}
+			break;
+		case gk::Mutation::RemoveObject:
+			if (action) {
+				settle(node, gk::Mutation::AddObject, &record.target);
+				if (target) {
+					action->removeObject(isolate, target);
+				}
+			} else if (bond) {
+				settle(node, gk::Mutation::Object, nullptr);
+				bond->removeObject();
+			}
+			break;
+		case gk::Mutation::Subject:
+			settle(node, gk::Mutation::Subject, nullptr);
+			if (bond && target) {
+				bond->subject(isolate, target);
+			}
+			break;
+		case gk::Mutation::Object:
+			settle(node, gk::Mutation::Object, nullptr);
+			if (bond && target) {
+				bond->object(isolate, target);
+			}
+			break;
+		case gk::Mutation::Rank:
+			node->rank(atoll(value.c_str()));
+			return;
+		default:
+			return;
+	}
+	node->modified();
+}
@@ -0,0 +1,275 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Loader.h
+*
+* Loads Node files, log segments and records in two phases. The first
+* reads and parses every source into plain records on the Scheduler, the
+* segments read concurrently and their records kept in order, the second
+* applies them in order on the v8 thread. Relationships of inserted Nodes
+* are resolved in a single pass at the end, so they are complete whatever
+* order the Nodes were found in.
+*
+* Binary records are decoded with the symbol table of their batch, which
+* the segment is read in order for, JSON records of older segments are
+* parsed as before. The parsed records can be rendered back as JSON lines
+* for debugging.
+*/
+
+#ifndef GRAPHKIT_SRC_LOADER_H
+#define GRAPHKIT_SRC_LOADER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "exports.h"
+#include "Mutation.h"
+#include "Node.h"
+
+namespace gk {
+	class Coordinator;
+
+	class Loader {
+	public:
+
+		/**
+		* Reference
+		* Identifies a Node by its class, type and id.
+		*/
+		struct Reference {
+			short nodeClass;
+			std::string type;
+			long long id;
+		};
+
+		/**
+		* Record
+		* A parsed log record. Inserts carry the image of the Node, updates
+		* the last change of each property and batches the records they
+		* commit together.
+		*/
+		struct Record {
+			gk::Mutation mutation;
+			Reference node;
+			Reference target;
+			std::string key;
+			std::string value;
+			long long rank;
+			bool ranked;
+			std::vector<std::string> groups;
+			std::vector<std::pair<std::string, std::string>> properties;
+			std::vector<std::string> deleted;
+			std::vector<Record> records;
+			std::vector<Reference> subjects;
+			std::vector<Reference> objects;
+		};
+
+		/**
+		* Loader
+		* Constructor.
+		*/
+		Loader() noexcept;
+
+		/**
+		* ~Loader
+		* Destructor.
+		*/
+		virtual ~Loader();
+
+		// defaults
+		Loader(const Loader&) = default;
+		Loader& operator= (const Loader&) = default;
+		Loader(Loader&&) = default;
+		Loader& operator= (Loader&&) = default;
+
+		/**
+		* file
+		* Queues a Node file of the older one file per Node format, read in
+		* the first phase. Empty files are deleted.
+		* @param		const std::string& path
+		*/
+		void file(const std::string& path) noexcept;
+
+		/**
+		* segment
+		* Queues a log segment, read in the first phase concurrently with the
+		* others. Every binary or newline terminated record takes the place
+		* of the segment, a torn record at its end is skipped.
+		* @param		const std::string& path
+		*/
+		void segment(const std::string& path) noexcept;
+
+		/**
+		* record
+		* Queues a log record.
+		* @param		const std::string& line
+		*/
+		void record(const std::string& line) noexcept;
+
+		/**
+		* count
+		* The number of queued sources.
+		* @return		std::size_t
+		*/
+		std::size_t count() const noexcept;
+
+		/**
+		* parse
+		* The first phase, reads and parses every queued source in parallel.
+		* @param		unsigned threads, 0 uses every Scheduler thread
+		*/
+		void parse(unsigned threads = 0) noexcept;
+
+		/**
+		* apply
+		* The second phase, applies the parsed records in order and then
+		* resolves the relationships of the inserted Nodes. Must be called
+		* on the v8 thread.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Coordinator* coordinator
+		*/
+		void apply(v8::Isolate* isolate, gk::Coordinator* coordinator) noexcept;
+
+		/**
+		* parse
+		* Parses a log record, or a Node image when image is set, on any thread.
+		* @param		const std::string& text
+		* @param		bool image
+		* @param		Record& record
+		* @return		bool, false if the text is not a valid record
+		*/
+		static bool parse(const std::string& text, bool image, Record& record) noexcept;
+
+		/**
+		* decode
+		* Decodes the payload of a binary log record, on any thread.
+		* @param		const std::string& payload
+		* @param		const std::vector<std::string>* symbols, the table of its batch
+		* @param		Record& record
+		* @return		bool, false if the payload is not a valid record
+		*/
+		static bool decode(const std::string& payload, const std::vector<std::string>* symbols, Record& record) noexcept;
+
+		/**
+		* json
+		* Renders the parsed records as JSON lines, in the format older
+		* segments were written in.
+		* @return		std::string
+		*/
+		std::string json() const noexcept;
+
+		/**
+		* find
+		* Finds an indexed Node by its reference.
+		* @param		gk::Coordinator* coordinator
+		* @param		const Reference& reference
+		* @return		gk::Node*, nullptr if not found
+		*/
+		static gk::Node* find(gk::Coordinator* coordinator, const Reference& reference) noexcept;
+
+	protected:
+		struct Source {
+			enum class Kind {
+				Record,
+				Binary,
+				File,
+				Segment
+			};
+
+			std::string text;
+			Kind kind;
+			std::shared_ptr<const std::vector<std::string>> symbols;
+		};
+
+		struct Edge {
+			gk::Mutation mutation;
+			Reference target;
+		};
+
+		std::vector<Source> sources_;
+		std::vector<Record> records_;
+		std::unordered_map<gk::Node*, std::vector<Edge>> pending_;
+
+		/**
+		* split
+		* Appends the records of plain data up to a framed block or a torn
+		* record, a symbol table replaces the current one.
+		* @param		const char* data
+		* @param		std::size_t size
+		* @param		std::shared_ptr<const std::vector<std::string>>& symbols
+		* @param		std::vector<Source>& out
+		* @return		std::size_t, the bytes read
+		*/
+		static std::size_t split(const char* data, std::size_t size, std::shared_ptr<const std::vector<std::string>>& symbols, std::vector<Source>& out) noexcept;
+
+		/**
+		* json
+		* Appends a record as JSON.
+		* @param		const Record& record
+		* @param		std::string& out
+		*/
+		static void json(const Record& record, std::string& out) noexcept;
+
+		/**
+		* expand
+		* Reads the queued segments concurrently and replaces each with the
+		* records it holds.
+		* @param		unsigned threads
+		*/
+		void expand(unsigned threads) noexcept;
+
+		/**
+		* apply
+		* Applies a single record.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Coordinator* coordinator
+		* @param		const Record& record
+		*/
+		void apply(v8::Isolate* isolate, gk::Coordinator* coordinator, const Record& record) noexcept;
+
+		/**
+		* insert
+		* Creates a Node from its image, its relationships are left pending.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Coordinator* coordinator
+		* @param		const Record& record
+		*/
+		void insert(v8::Isolate* isolate, gk::Coordinator* coordinator, const Record& record) noexcept;
+
+		/**
+		* settle
+		* Drops the pending relationships of a Node that a later record
+		* replaces, a null target drops every one of the mutation.
+		* @param		gk::Node* node
+		* @param		gk::Mutation mutation
+		* @param		const Reference* target
+		*/
+		void settle(gk::Node* node, gk::Mutation mutation, const Reference* target) noexcept;
+
+		/**
+		* resolve
+		* Links the pending relationships once every Node exists.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Coordinator* coordinator
+		*/
+		void resolve(v8::Isolate* isolate, gk::Coordinator* coordinator) noexcept;
+	};
+}
+
+#endif
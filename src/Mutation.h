@@ -0,0 +1,103 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Mutation.h
+*
+* The kinds of records written to the log, one per change of a Node.
+*/
+
+#ifndef GRAPHKIT_SRC_MUTATION_H
+#define GRAPHKIT_SRC_MUTATION_H
+
+#include <cstring>
+#include <string>
+#include "symbols.h"
+
+namespace gk {
+	enum class Mutation {
+		Unknown,
+		Insert,
+		Remove,
+		Set,
+		Delete,
+		AddGroup,
+		RemoveGroup,
+		AddSubject,
+		RemoveSubject,
+		AddObject,
+		RemoveObject,
+		Subject,
+		Object,
+		Rank,
+		Update,
+		Drop,
+		Batch,
+		Symbols
+	};
+
+	inline const char* MutationToString(const Mutation& mutation) noexcept {
+		switch (mutation) {
+			case Mutation::Insert:
+				return GK_SYMBOL_RECORD_INSERT;
+			case Mutation::Remove:
+				return GK_SYMBOL_RECORD_REMOVE;
+			case Mutation::Set:
+				return GK_SYMBOL_RECORD_SET;
+			case Mutation::Delete:
+				return GK_SYMBOL_RECORD_DELETE;
+			case Mutation::AddGroup:
+				return GK_SYMBOL_RECORD_ADD_GROUP;
+			case Mutation::RemoveGroup:
+				return GK_SYMBOL_RECORD_REMOVE_GROUP;
+			case Mutation::AddSubject:
+				return GK_SYMBOL_RECORD_ADD_SUBJECT;
+			case Mutation::RemoveSubject:
+				return GK_SYMBOL_RECORD_REMOVE_SUBJECT;
+			case Mutation::AddObject:
+				return GK_SYMBOL_RECORD_ADD_OBJECT;
+			case Mutation::RemoveObject:
+				return GK_SYMBOL_RECORD_REMOVE_OBJECT;
+			case Mutation::Subject:
+				return GK_SYMBOL_RECORD_SUBJECT;
+			case Mutation::Object:
+				return GK_SYMBOL_RECORD_OBJECT;
+			case Mutation::Rank:
+				return GK_SYMBOL_RECORD_RANK;
+			case Mutation::Update:
+				return GK_SYMBOL_RECORD_UPDATE;
+			case Mutation::Drop:
+				return GK_SYMBOL_RECORD_DROP;
+			case Mutation::Batch:
+				return GK_SYMBOL_RECORD_BATCH;
+			case Mutation::Symbols:
+				return GK_SYMBOL_RECORD_SYMBOLS;
+			default:
+				return "";
+		};
+	}
+
+	inline gk::Mutation MutationFromString(const std::string& mutation) noexcept {
+		for (auto m = static_cast<int>(Mutation::Insert); m <= static_cast<int>(Mutation::Batch); ++m) {
+			if (0 == mutation.compare(MutationToString(static_cast<Mutation>(m)))) {
+				return static_cast<Mutation>(m);
+			}
+		}
+		return Mutation::Unknown;
+	}
+}
+
+#endif
@@ -16,10 +16,18 @@
 * in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
 #include <utility>
 #include <uv.h>
 #include "Node.h"
 #include "Coordinator.h"
+#include "Entity.h"
+#include "Action.h"
+#include "Bond.h"
+#include "Pool.h"
+#include "Encoder.h"
 
 gk::Node::Node(const gk::NodeClass& nodeClass, const std::string&& type) noexcept
 	: gk::Export{},
@@ -27,12 +35,17 @@ gk::Node::Node(const gk::NodeClass& nodeClass, const std::string&& type) noexcep
 	  type_{std::move(type)},
 	  id_{},
 	  indexed_{false},
+	  dirty_{false},
+	  rank_{-1},
 	  groups_{nullptr},
 	  properties_{nullptr},
 	  hash_{},
 	  coordinator_{nullptr} {}
 
 gk::Node::~Node() {
+	if (gk::Pool::enabled()) {
+		gk::Pool::instance().forget(this);
+	}
 	if (nullptr != groups_) {
 		groups_->clear([](std::string* v) {
 			delete v;
@@ -75,7 +88,26 @@ void gk::Node::indexed(bool indexed) noexcept {
 	indexed_ = indexed;
 }
 
+bool gk::Node::dirty() const noexcept {
+	return dirty_;
+}
+
+void gk::Node::dirty(bool dirty) noexcept {
+	dirty_ = dirty;
+}
+
+long long gk::Node::rank() const noexcept {
+	return rank_;
+}
+
+void gk::Node::rank(long long rank) noexcept {
+	rank_ = rank;
+}
+
 gk::RedBlackTree<std::string, true, std::string>* gk::Node::groups() noexcept {
+	if (gk::Pool::enabled()) {
+		gk::Pool::instance().touch(this);
+	}
 	if (nullptr == groups_) {
 		groups_ = new gk::RedBlackTree<std::string, true, std::string>{};
 	}
@@ -83,6 +115,9 @@ gk::RedBlackTree<std::string, true, std::string>* gk::Node::groups() noexcept {
 }
 
 gk::RedBlackTree<std::string, true, std::string>* gk::Node::properties() noexcept {
+	if (gk::Pool::enabled()) {
+		gk::Pool::instance().touch(this);
+	}
 	if (nullptr == properties_) {
 		properties_ = new gk::RedBlackTree<std::string, true, std::string>{};
 	}
@@ -96,26 +131,273 @@ const std::string& gk::Node::hash() noexcept {
 	return hash_;
 }
 
+std::string gk::Node::escape(const std::string& value) noexcept {
+	// quotes and backslashes are written as code points, json.h keeps their short escapes
+	std::string s{"\""};
+	for (auto c : value) {
+		switch (c) {
+			case '"':
+				s += "\\u0022";
+				break;
+			case '\\':
+				s += "\\u005c";
+				break;
+			case '\n':
+				s += "\\n";
+				break;
+			case '\r':
+				s += "\\r";
+				break;
+			case '\t':
+				s += "\\t";
+				break;
+			default:
+				if (0 <= c && 0x20 > c) {
+					char u[8];
+					snprintf(u, sizeof(u), "\\u%04x", c);
+					s += u;
+				} else {
+					s += c;
+				}
+		}
+	}
+	return s + "\"";
+}
+
 std::string gk::Node::toJSON() noexcept {
 	return "";
 }
 
-void gk::Node::persist() noexcept {}
+void gk::Node::encode(gk::Encoder& encoder, std::string& out) noexcept {
+	image(encoder, out);
+	encoder.count(out, 0);
+	encoder.count(out, 0);
+}
+
+void gk::Node::image(gk::Encoder& encoder, std::string& out) noexcept {
+	encoder.number(out, rank());
+	auto properties = this->properties();
+	encoder.count(out, properties->count());
+	properties->each([&](const std::string& key, std::string* value) {
+		encoder.symbol(out, key);
+		encoder.string(out, *value);
+	});
+	auto groups = this->groups();
+	encoder.count(out, groups->count());
+	groups->each([&](const std::string& key, std::string*) {
+		encoder.symbol(out, key);
+	});
+}
+
+void gk::Node::persist() noexcept {
+	record(gk::Mutation::Insert);
+}
 
 void gk::Node::unlink() noexcept {
-	// delete the file
-	uv_fs_t unlink_req;
-	std::string dir (GK_FS_DB_DIR);
-	uv_fs_unlink(uv_default_loop(), &unlink_req, (dir + "/" + hash() + ".gk").c_str(), NULL);
+	record(gk::Mutation::Remove);
+}
+
+void gk::Node::record(gk::Mutation mutation, const std::string& key, const std::string& value, const std::string* prior) noexcept {
+	modified();
+	auto store = coordinator()->store();
+	if (store->batching()) {
+		journal(mutation, key, prior);
+	}
+	store->record(mutation, this, key, value);
+}
+
+void gk::Node::record(gk::Mutation mutation, gk::Node* target, gk::Node* prior) noexcept {
+	auto store = coordinator()->store();
+	if (store->batching()) {
+		journal(mutation, target, prior);
+	}
+	store->record(mutation, this, target);
+}
+
+void gk::Node::journal(gk::Mutation mutation, const std::string& key, const std::string* prior) noexcept {
+	// the inverse changes are recorded like any other, the Store drops them when nothing was written
+	auto node = this;
+	auto had = nullptr != prior;
+	auto value = had ? *prior : std::string{};
+	std::function<void()> revert;
+	switch (mutation) {
+		case gk::Mutation::Insert:
+			revert = [node]() {
+				auto coordinator = node->coordinator();
+				if (coordinator->removeNode(node->nodeClass(), node->type(), node->id())) {
+					auto groups = node->groups();
+					for (auto i = groups->count(); 0 < i; --i) {
+						coordinator->removeGroup(*groups->select(i), node->hash());
+					}
+				}
+			};
+			break;
+		case gk::Mutation::Remove:
+			revert = [node]() {
+				auto isolate = v8::Isolate::GetCurrent();
+				auto coordinator = node->coordinator();
+				if (coordinator->insertNode(isolate, node)) {
+					auto groups = node->groups();
+					for (auto i = groups->count(); 0 < i; --i) {
+						coordinator->insertGroup(isolate, *groups->select(i), node);
+					}
+				}
+			};
+			break;
+		case gk::Mutation::Set:
+			revert = [node, key, had, value]() {
+				node->properties()->remove(key, [](std::string* v) {
+					delete v;
+				});
+				if (had) {
+					node->properties()->insert(key, new std::string{value});
+					node->record(gk::Mutation::Set, key, value);
+				} else {
+					node->record(gk::Mutation::Delete, key);
+				}
+			};
+			break;
+		case gk::Mutation::Delete:
+			if (!had) {
+				return;
+			}
+			revert = [node, key, value]() {
+				node->properties()->insert(key, new std::string{value});
+				node->record(gk::Mutation::Set, key, value);
+			};
+			break;
+		case gk::Mutation::AddGroup:
+			revert = [node, key]() {
+				node->groups()->remove(key, [&](std::string* v) {
+					if (node->indexed()) {
+						node->coordinator()->removeGroup(*v, node->hash());
+					}
+					node->record(gk::Mutation::RemoveGroup, *v);
+					delete v;
+				});
+			};
+			break;
+		case gk::Mutation::RemoveGroup:
+			revert = [node, key]() {
+				std::string* v = new std::string{key};
+				if (!node->groups()->insert(*v, v)) {
+					delete v;
+					return;
+				}
+				if (node->indexed()) {
+					node->coordinator()->insertGroup(v8::Isolate::GetCurrent(), *v, node);
+				}
+				node->record(gk::Mutation::AddGroup, *v);
+			};
+			break;
+		case gk::Mutation::Rank:
+			if (!had) {
+				return;
+			}
+			revert = [node, value]() {
+				node->rank(atoll(value.c_str()));
+				node->record(gk::Mutation::Rank, "", value);
+			};
+			break;
+		default:
+			return;
+	}
+	coordinator()->store()->journal(this, nullptr, std::move(revert));
+}
+
+void gk::Node::journal(gk::Mutation mutation, gk::Node* target, gk::Node* prior) noexcept {
+	auto action = dynamic_cast<gk::Action<gk::Entity>*>(this);
+	auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(this);
+	auto entity = dynamic_cast<gk::Entity*>(target);
+	auto previous = dynamic_cast<gk::Entity*>(prior);
+	if (!entity) {
+		return;
+	}
+	std::function<void()> revert;
+	switch (mutation) {
+		case gk::Mutation::AddSubject:
+			if (action) {
+				revert = [action, entity]() {
+					action->removeSubject(v8::Isolate::GetCurrent(), entity);
+				};
+			}
+			break;
+		case gk::Mutation::RemoveSubject:
+			if (action) {
+				revert = [action, entity]() {
+					action->addSubject(v8::Isolate::GetCurrent(), entity);
+				};
+			} else if (bond) {
+				revert = [bond, entity]() {
+					bond->subject(v8::Isolate::GetCurrent(), entity);
+				};
+			}
+			break;
+		case gk::Mutation::AddObject:
+			if (action) {
+				revert = [action, entity]() {
+					action->removeObject(v8::Isolate::GetCurrent(), entity);
+				};
+			}
+			break;
+		case gk::Mutation::RemoveObject:
+			if (action) {
+				revert = [action, entity]() {
+					action->addObject(v8::Isolate::GetCurrent(), entity);
+				};
+			} else if (bond) {
+				revert = [bond, entity]() {
+					bond->object(v8::Isolate::GetCurrent(), entity);
+				};
+			}
+			break;
+		case gk::Mutation::Subject:
+			if (bond) {
+				revert = [bond, entity, previous]() {
+					if (previous) {
+						bond->subject(v8::Isolate::GetCurrent(), previous);
+					} else if (bond->removeSubject()) {
+						bond->record(gk::Mutation::RemoveSubject, entity);
+					}
+				};
+			}
+			break;
+		case gk::Mutation::Object:
+			if (bond) {
+				revert = [bond, entity, previous]() {
+					if (previous) {
+						bond->object(v8::Isolate::GetCurrent(), previous);
+					} else if (bond->removeObject()) {
+						bond->record(gk::Mutation::RemoveObject, entity);
+					}
+				};
+			}
+			break;
+		default:
+			break;
+	}
+	if (revert) {
+		coordinator()->store()->journal(this, nullptr != previous ? previous : entity, std::move(revert));
+	}
+}
+
+void gk::Node::modified() noexcept {
+	if (gk::Pool::enabled()) {
+		gk::Pool::instance().modified(this);
+	}
 }
 
 std::shared_ptr<gk::Coordinator> gk::Node::coordinator() noexcept {
 	if (nullptr == coordinator_) {
-		coordinator_ = std::make_shared<gk::Coordinator>();
+		coordinator_ = gk::Coordinator{}.shared();
 	}
 	return coordinator_;
 }
 
+void gk::Node::coordinator(const std::shared_ptr<gk::Coordinator>& coordinator) noexcept {
+	coordinator_ = coordinator;
+}
+
 GK_METHOD(gk::Node::AddGroup) {
 	GK_SCOPE();
 	if (!args[0]->IsString()) {
@@ -129,7 +411,7 @@ GK_METHOD(gk::Node::AddGroup) {
 		if (node->indexed()) {
 			node->coordinator()->insertGroup(isolate, *v, node);
 		}
-		node->persist();
+		node->record(gk::Mutation::AddGroup, *v);
 	}
 	GK_RETURN(GK_BOOLEAN(result));
 }
@@ -155,8 +437,8 @@ GK_METHOD(gk::Node::RemoveGroup) {
 		if (node->indexed()) {
 			node->coordinator()->removeGroup(*v, node->hash());
 		}
+		node->record(gk::Mutation::RemoveGroup, *v);
 		delete v;
-		node->persist();
 	})));
 }
 
@@ -23,11 +23,14 @@
 #include <string>
 #include "exports.h"
 #include "NodeClass.h"
+#include "Mutation.h"
 #include "Export.h"
 #include "RedBlackTree.h"
 
 namespace gk {
 	class Coordinator;
+	class Encoder;
+	class Pool;
 	class Node : public gk::Export {
 	public:
 		Node(const gk::NodeClass& nodeClass, const std::string&& type) noexcept;
@@ -41,32 +44,54 @@ namespace gk {
 		const std::string& type() const noexcept;
 		long long id() const noexcept;
 		bool indexed() const noexcept;
+		bool dirty() const noexcept;
+		long long rank() const noexcept;
 
 		gk::RedBlackTree<std::string, true, std::string>* groups() noexcept;
 		gk::RedBlackTree<std::string, true, std::string>* properties() noexcept;
 
 		void id(long long&& id) noexcept;
 		void indexed(bool indexed) noexcept;
+		void dirty(bool dirty) noexcept;
+		void rank(long long rank) noexcept;
 
 		const std::string& hash() noexcept;
 
+		static std::string escape(const std::string& value) noexcept;
 		virtual std::string toJSON() noexcept;
+		virtual void encode(gk::Encoder& encoder, std::string& out) noexcept;
 		virtual void persist() noexcept;
 
 		void unlink() noexcept;
+		void record(gk::Mutation mutation, const std::string& key = "", const std::string& value = "", const std::string* prior = nullptr) noexcept;
+		void record(gk::Mutation mutation, gk::Node* target, gk::Node* prior = nullptr) noexcept;
+		void modified() noexcept;
 
 		std::shared_ptr<Coordinator> coordinator() noexcept;
 
+		// binds the Node to the Graph it is inserted into
+		void coordinator(const std::shared_ptr<Coordinator>& coordinator) noexcept;
+
 	protected:
 		const gk::NodeClass nodeClass_;
 		const std::string type_;
 		long long id_;
 		bool indexed_;
+		bool dirty_;
+		long long rank_;
 		gk::RedBlackTree<std::string, true, std::string>* groups_;
 		gk::RedBlackTree<std::string, true, std::string>* properties_;
 		std::string hash_;
 		std::shared_ptr<Coordinator> coordinator_;
 
+		friend class gk::Pool;
+
+		// the rank, properties and groups of an encoded image
+		void image(gk::Encoder& encoder, std::string& out) noexcept;
+
+		void journal(gk::Mutation mutation, const std::string& key, const std::string* prior) noexcept;
+		void journal(gk::Mutation mutation, gk::Node* target, gk::Node* prior) noexcept;
+
 		static GK_METHOD(New);
 		static GK_METHOD(AddGroup);
 		static GK_METHOD(HasGroup);
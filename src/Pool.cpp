@@ -0,0 +1,323 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include "Pool.h"
+#include "Node.h"
+#include "Ring.h"
+#include "symbols.h"
+
+// the estimated cost of a tree node and its string, beyond the characters
+static const std::size_t GK_POOL_OVERHEAD = 64;
+
+using Tree = gk::RedBlackTree<std::string, true, std::string>;
+
+static void put(std::string& out, const std::string& s) {
+	uint32_t n = static_cast<uint32_t>(s.size());
+	out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+	out.append(s);
+}
+
+static bool get(const char*& p, const char* end, std::string& s) {
+	uint32_t n;
+	if (static_cast<std::size_t>(end - p) < sizeof(n)) {
+		return false;
+	}
+	memcpy(&n, p, sizeof(n));
+	p += sizeof(n);
+	if (static_cast<std::size_t>(end - p) < n) {
+		return false;
+	}
+	s.assign(p, n);
+	p += n;
+	return true;
+}
+
+static void release(Tree*& tree) {
+	if (nullptr != tree) {
+		tree->clear([](std::string* v) {
+			delete v;
+		});
+		delete tree;
+		tree = nullptr;
+	}
+}
+
+bool gk::Pool::enabled_ = false;
+
+gk::Pool::Pool() noexcept
+	: entries_{},
+	  frames_{},
+	  hand_{0},
+	  capacity_{0},
+	  resident_{0},
+	  paged_{0},
+	  end_{0},
+	  fd_{-1} {}
+
+gk::Pool::~Pool() {
+	if (0 <= fd_) {
+		uv_fs_t close_req;
+		uv_fs_close(uv_default_loop(), &close_req, fd_, NULL);
+		uv_fs_req_cleanup(&close_req);
+	}
+}
+
+gk::Pool& gk::Pool::instance() noexcept {
+	// never destroyed, Nodes may still be released while exiting
+	static auto pool = new gk::Pool{};
+	return *pool;
+}
+
+bool gk::Pool::enabled() noexcept {
+	return enabled_;
+}
+
+std::size_t gk::Pool::capacity() const noexcept {
+	return capacity_;
+}
+
+void gk::Pool::capacity(std::size_t bytes) noexcept {
+	capacity_ = bytes;
+	if (0 < bytes) {
+		enabled_ = true;
+	}
+	balance(nullptr);
+}
+
+std::size_t gk::Pool::resident() const noexcept {
+	return resident_;
+}
+
+std::size_t gk::Pool::paged() const noexcept {
+	return paged_;
+}
+
+void gk::Pool::touch(gk::Node* node) noexcept {
+	auto it = entries_.find(node);
+	if (entries_.end() == it) {
+		// only indexed Nodes are admitted, the others belong to JavaScript
+		if (!node->indexed()) {
+			return;
+		}
+		auto& entry = entries_[node];
+		entry.offset = -1;
+		entry.length = 0;
+		entry.dirty = true;
+		entry.resident = true;
+		entry.bytes = measure(node);
+		frame(node, entry);
+	} else if (!it->second.resident) {
+		fault(node, it->second);
+	} else {
+		it->second.referenced = true;
+		return;
+	}
+	balance(node);
+}
+
+void gk::Pool::modified(gk::Node* node) noexcept {
+	auto it = entries_.find(node);
+	if (entries_.end() == it || !it->second.resident) {
+		return;
+	}
+	auto& entry = it->second;
+	entry.dirty = true;
+	entry.referenced = true;
+	resident_ -= entry.bytes;
+	entry.bytes = measure(node);
+	resident_ += entry.bytes;
+	balance(node);
+}
+
+void gk::Pool::forget(gk::Node* node) noexcept {
+	auto it = entries_.find(node);
+	if (entries_.end() == it) {
+		return;
+	}
+	if (it->second.resident) {
+		resident_ -= it->second.bytes;
+		unframe(it->second);
+	} else {
+		--paged_;
+	}
+	entries_.erase(it);
+}
+
+void gk::Pool::balance(gk::Node* keep) noexcept {
+	if (0 == capacity_) {
+		return;
+	}
+	// two sweeps clear every reference bit, more means nothing can be evicted
+	for (auto steps = 2 * frames_.size() + 1; capacity_ < resident_ && 0 < steps && !frames_.empty(); --steps) {
+		if (hand_ >= frames_.size()) {
+			hand_ = 0;
+		}
+		auto node = frames_[hand_];
+		auto& entry = entries_[node];
+		if (node == keep || entry.referenced || !evict(node, entry)) {
+			entry.referenced = false;
+			++hand_;
+		}
+	}
+}
+
+bool gk::Pool::evict(gk::Node* node, Entry& entry) noexcept {
+	if (entry.dirty) {
+		std::string data;
+		uint32_t n = nullptr == node->properties_ ? 0 : static_cast<uint32_t>(node->properties_->count());
+		data.append(reinterpret_cast<const char*>(&n), sizeof(n));
+		for (uint32_t i = 1; i <= n; ++i) {
+			auto q = node->properties_->node(i);
+			put(data, q->key());
+			put(data, *q->data());
+		}
+		n = nullptr == node->groups_ ? 0 : static_cast<uint32_t>(node->groups_->count());
+		data.append(reinterpret_cast<const char*>(&n), sizeof(n));
+		for (uint32_t i = 1; i <= n; ++i) {
+			put(data, *node->groups_->select(i));
+		}
+
+		if (0 > fd_) {
+			// unlinked at once, the space is returned when the process exits
+			auto file = "./" + std::string(GK_FS_DB_DIR) + "/" + GK_FS_POOL_FILE;
+			uv_fs_t mkdir_req;
+			uv_fs_mkdir(uv_default_loop(), &mkdir_req, ("./" + std::string(GK_FS_DB_DIR)).c_str(), S_IRWXU, NULL);
+			uv_fs_req_cleanup(&mkdir_req);
+			uv_fs_t open_req;
+			uv_fs_open(uv_default_loop(), &open_req, file.c_str(), O_CREAT | O_TRUNC | O_RDWR, S_IRUSR | S_IWUSR, NULL);
+			fd_ = open_req.result;
+			uv_fs_req_cleanup(&open_req);
+			if (0 > fd_) {
+				return false;
+			}
+			uv_fs_t unlink_req;
+			uv_fs_unlink(uv_default_loop(), &unlink_req, file.c_str(), NULL);
+			uv_fs_req_cleanup(&unlink_req);
+		}
+
+		// a body that shrank reuses its slot
+		auto offset = 0 <= entry.offset && data.size() <= entry.length ? entry.offset : end_;
+		long long written;
+		if (auto ring = gk::Ring::local()) {
+			written = ring->write(fd_, data.data(), data.size(), offset);
+		} else {
+			uv_buf_t iov = uv_buf_init(&data[0], data.size());
+			uv_fs_t write_req;
+			uv_fs_write(uv_default_loop(), &write_req, fd_, &iov, 1, offset, NULL);
+			written = write_req.result;
+			uv_fs_req_cleanup(&write_req);
+		}
+		if (written != static_cast<long long>(data.size())) {
+			return false;
+		}
+		if (offset == end_) {
+			end_ += data.size();
+			entry.length = data.size();
+		}
+		entry.offset = offset;
+		entry.dirty = false;
+	}
+
+	release(node->properties_);
+	release(node->groups_);
+	resident_ -= entry.bytes;
+	unframe(entry);
+	entry.resident = false;
+	++paged_;
+	return true;
+}
+
+void gk::Pool::fault(gk::Node* node, Entry& entry) noexcept {
+	std::string data(entry.length, '\0');
+	long long n;
+	if (auto ring = gk::Ring::local()) {
+		n = ring->read(fd_, &data[0], data.size(), entry.offset);
+	} else {
+		uv_buf_t iov = uv_buf_init(&data[0], data.size());
+		uv_fs_t read_req;
+		uv_fs_read(uv_default_loop(), &read_req, fd_, &iov, 1, entry.offset, NULL);
+		n = read_req.result;
+		uv_fs_req_cleanup(&read_req);
+	}
+	data.resize(0 > n ? 0 : n);
+
+	// the trees are rebuilt from the image, a short read leaves what was decoded
+	node->properties_ = new Tree{};
+	node->groups_ = new Tree{};
+	const char* p = data.data();
+	const char* end = p + data.size();
+	uint32_t count = 0;
+	if (sizeof(count) <= data.size()) {
+		memcpy(&count, p, sizeof(count));
+		p += sizeof(count);
+	}
+	std::string key;
+	std::string value;
+	for (uint32_t i = 0; i < count && get(p, end, key) && get(p, end, value); ++i) {
+		node->properties_->insert(key, new std::string{value});
+	}
+	count = 0;
+	if (static_cast<std::size_t>(end - p) >= sizeof(count)) {
+		memcpy(&count, p, sizeof(count));
+		p += sizeof(count);
+	}
+	for (uint32_t i = 0; i < count && get(p, end, value); ++i) {
+		auto v = new std::string{value};
+		node->groups_->insert(*v, v);
+	}
+
+	--paged_;
+	entry.resident = true;
+	entry.dirty = false;
+	entry.bytes = measure(node);
+	frame(node, entry);
+}
+
+void gk::Pool::frame(gk::Node* node, Entry& entry) noexcept {
+	entry.frame = frames_.size();
+	entry.referenced = true;
+	frames_.push_back(node);
+	resident_ += entry.bytes;
+}
+
+void gk::Pool::unframe(Entry& entry) noexcept {
+	// the last frame takes the free slot
+	auto last = frames_.back();
+	frames_[entry.frame] = last;
+	entries_[last].frame = entry.frame;
+	frames_.pop_back();
+}
+
+std::size_t gk::Pool::measure(gk::Node* node) noexcept {
+	std::size_t bytes = GK_POOL_OVERHEAD;
+	if (nullptr != node->properties_) {
+		for (auto i = node->properties_->count(); 0 < i; --i) {
+			auto q = node->properties_->node(i);
+			bytes += 2 * GK_POOL_OVERHEAD + q->key().size() + q->data()->size();
+		}
+	}
+	if (nullptr != node->groups_) {
+		for (auto i = node->groups_->count(); 0 < i; --i) {
+			bytes += 2 * GK_POOL_OVERHEAD + node->groups_->select(i)->size();
+		}
+	}
+	return bytes;
+}
@@ -0,0 +1,194 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Pool.h
+*
+* A bounded buffer pool for the bodies of indexed Nodes, their properties
+* and groups. Bodies are admitted on first access and evicted with the
+* CLOCK algorithm once the resident bytes pass the capacity. Dirty bodies
+* are written to a scratch file, which is unlinked as soon as it is opened,
+* and faulted back in when Node::properties or Node::groups is called. The
+* log and checkpoints remain the durable copy. Must be used on the v8 thread.
+*/
+
+#ifndef GRAPHKIT_SRC_POOL_H
+#define GRAPHKIT_SRC_POOL_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <uv.h>
+
+namespace gk {
+	class Node;
+
+	class Pool {
+	public:
+
+		/**
+		* Pool
+		* Constructor.
+		*/
+		Pool() noexcept;
+
+		/**
+		* ~Pool
+		* Destructor.
+		*/
+		virtual ~Pool();
+
+		// defaults
+		Pool(const Pool&) = delete;
+		Pool& operator= (const Pool&) = delete;
+		Pool(Pool&&) = delete;
+		Pool& operator= (Pool&&) = delete;
+
+		/**
+		* instance
+		* The shared Pool of the addon.
+		* @return		gk::Pool&
+		*/
+		static gk::Pool& instance() noexcept;
+
+		/**
+		* enabled
+		* Whether a capacity was ever set, until then Nodes bypass the Pool.
+		* @return		bool
+		*/
+		static bool enabled() noexcept;
+
+		/**
+		* capacity
+		* The resident bytes allowed before bodies are evicted.
+		* @return		std::size_t
+		*/
+		std::size_t capacity() const noexcept;
+
+		/**
+		* capacity
+		* Sets the resident bytes allowed, 0 never evicts.
+		* @param		std::size_t bytes
+		*/
+		void capacity(std::size_t bytes) noexcept;
+
+		/**
+		* resident
+		* The estimated bytes of the bodies in memory.
+		* @return		std::size_t
+		*/
+		std::size_t resident() const noexcept;
+
+		/**
+		* paged
+		* The number of bodies held only in the scratch file.
+		* @return		std::size_t
+		*/
+		std::size_t paged() const noexcept;
+
+		/**
+		* touch
+		* Marks a body as used, faulting it in or admitting it first.
+		* @param		gk::Node* node
+		*/
+		void touch(gk::Node* node) noexcept;
+
+		/**
+		* modified
+		* Marks a resident body as changed so it is written back on eviction.
+		* @param		gk::Node* node
+		*/
+		void modified(gk::Node* node) noexcept;
+
+		/**
+		* forget
+		* Drops a Node that is being destroyed.
+		* @param		gk::Node* node
+		*/
+		void forget(gk::Node* node) noexcept;
+
+	protected:
+		struct Entry {
+			std::size_t frame;
+			long long offset;
+			std::size_t length;
+			std::size_t bytes;
+			bool referenced;
+			bool dirty;
+			bool resident;
+		};
+
+		std::unordered_map<gk::Node*, Entry> entries_;
+		std::vector<gk::Node*> frames_;
+		std::size_t hand_;
+		std::size_t capacity_;
+		std::size_t resident_;
+		std::size_t paged_;
+		long long end_;
+		uv_file fd_;
+		static bool enabled_;
+
+		/**
+		* balance
+		* Evicts bodies until the resident bytes fit, never the kept Node.
+		* @param		gk::Node* keep
+		*/
+		void balance(gk::Node* keep) noexcept;
+
+		/**
+		* evict
+		* Writes a body back if dirty and frees it.
+		* @param		gk::Node* node
+		* @param		Entry& entry
+		* @return		bool, false if the body could not be written
+		*/
+		bool evict(gk::Node* node, Entry& entry) noexcept;
+
+		/**
+		* fault
+		* Reads a paged body back into its Node.
+		* @param		gk::Node* node
+		* @param		Entry& entry
+		*/
+		void fault(gk::Node* node, Entry& entry) noexcept;
+
+		/**
+		* frame
+		* Places a resident body under the clock.
+		* @param		gk::Node* node
+		* @param		Entry& entry
+		*/
+		void frame(gk::Node* node, Entry& entry) noexcept;
+
+		/**
+		* unframe
+		* Removes a body from the clock.
+		* @param		Entry& entry
+		*/
+		void unframe(Entry& entry) noexcept;
+
+		/**
+		* measure
+		* Estimates the bytes a body holds.
+		* @param		gk::Node* node
+		* @return		std::size_t
+		*/
+		static std::size_t measure(gk::Node* node) noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,164 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include "RandomWalk.h"
+
+// rows generated per chunk of work
+static const long long GK_WALK_CHUNK_ROWS = 256;
+
+// seeds a generator for a chunk so the output does not depend on the thread count
+static inline void seedChunk(std::mt19937_64& rng, unsigned long long seed, long long chunk) {
+	rng.seed(seed ^ (0x9E3779B97F4A7C15ULL * static_cast<unsigned long long>(chunk + 1)));
+}
+
+static inline gk::RandomWalk::Vertex pick(std::mt19937_64& rng, const gk::RandomWalk::Vertex* first, gk::RandomWalk::Vertex degree) {
+	return first[static_cast<unsigned long long>(rng() >> 11) % static_cast<unsigned long long>(degree)];
+}
+
+// a single walk, using rejection sampling for the second order node2vec bias
+static void walk(const gk::Topology& topology, std::mt19937_64& rng, double p, double q, gk::RandomWalk::Vertex start, gk::RandomWalk::Vertex* row, int length) {
+	std::uniform_real_distribution<double> unit{0, 1};
+	auto biased = 1 != p || 1 != q;
+	auto bound = std::max(1.0, std::max(1 / p, 1 / q));
+
+	row[0] = start;
+	for (auto k = 1; k < length; ++k) {
+		auto current = row[k - 1];
+		auto degree = topology.degree(current);
+		if (0 == degree) {
+			std::fill(row + k, row + length, -1);
+			return;
+		}
+		auto first = topology.neighbours(current);
+		if (!biased || 1 == k) {
+			row[k] = pick(rng, first, degree);
+			continue;
+		}
+		auto previous = row[k - 2];
+		for (;;) {
+			auto x = pick(rng, first, degree);
+			auto weight = x == previous ? 1 / p : (topology.adjacent(previous, x) ? 1.0 : 1 / q);
+			if (unit(rng) * bound < weight) {
+				row[k] = x;
+				break;
+			}
+		}
+	}
+}
+
+gk::RandomWalk::RandomWalk(const gk::Topology& topology, const Options& options) noexcept
+	: topology_(topology),
+	  options_(options) {}
+
+gk::RandomWalk::~RandomWalk() {}
+
+unsigned gk::RandomWalk::workers() const noexcept {
+	auto n = 0 < options_.threads ? options_.threads : gk::Scheduler::instance().threads();
+	return 0 < n ? n : 1;
+}
+
+long long gk::RandomWalk::rows(const std::vector<Vertex>& starts) const noexcept {
+	return static_cast<long long>(starts.size()) * options_.walks;
+}
+
+bool gk::RandomWalk::run(const std::vector<Vertex>& starts, Vertex* out, const gk::Scheduler::Monitor& monitor) noexcept {
+	auto total = rows(starts);
+	auto chunks = (total + GK_WALK_CHUNK_ROWS - 1) / GK_WALK_CHUNK_ROWS;
+	auto length = options_.length;
+	std::atomic<long long> next{0};
+	std::atomic<long long> done{0};
+	std::atomic<bool> stopped{false};
+
+	gk::Scheduler::instance().parallel(workers(), [&]() {
+		std::mt19937_64 rng;
+		for (auto c = next++; c < chunks && !stopped; c = next++) {
+			seedChunk(rng, options_.seed, c);
+			auto last = std::min(total, (c + 1) * GK_WALK_CHUNK_ROWS);
+			for (auto r = c * GK_WALK_CHUNK_ROWS; r < last; ++r) {
+				walk(topology_, rng, options_.p, options_.q, starts[r % starts.size()], out + r * length, length);
+			}
+			if (monitor && !monitor(static_cast<double>(++done) / chunks)) {
+				stopped = true;
+			}
+		}
+	});
+	return !stopped;
+}
+
+bool gk::RandomWalk::run(const std::vector<Vertex>& starts, const Sink& sink, const gk::Scheduler::Monitor& monitor) noexcept {
+	auto total = rows(starts);
+	auto chunks = (total + GK_WALK_CHUNK_ROWS - 1) / GK_WALK_CHUNK_ROWS;
+	auto length = options_.length;
+	auto n = workers();
+
+	// a wave holds 2 chunks per task, so memory stays proportional to the parallelism
+	long long span = 2 * n;
+	auto waves = (chunks + span - 1) / span;
+	std::vector<Vertex> buffers[2];
+	std::atomic<long long> cursors[2];
+	std::atomic<long long> done{0};
+	std::atomic<bool> stopped{false};
+
+	auto& scheduler = gk::Scheduler::instance();
+	auto produce = [&](long long wave, gk::Scheduler::Group& group) {
+		auto buffer = &buffers[wave & 1];
+		auto next = &cursors[wave & 1];
+		auto first = wave * span;
+		auto last = std::min(chunks, first + span);
+		buffer->resize((std::min(total, last * GK_WALK_CHUNK_ROWS) - first * GK_WALK_CHUNK_ROWS) * length);
+		*next = first;
+		for (auto i = n; 0 < i; --i) {
+			group.submit([&, buffer, next, first, last]() {
+				std::mt19937_64 rng;
+				for (auto c = (*next)++; c < last && !stopped; c = (*next)++) {
+					seedChunk(rng, options_.seed, c);
+					auto data = buffer->data() + (c - first) * GK_WALK_CHUNK_ROWS * length;
+					auto end = std::min(total, (c + 1) * GK_WALK_CHUNK_ROWS);
+					for (auto r = c * GK_WALK_CHUNK_ROWS; r < end; ++r) {
+						walk(topology_, rng, options_.p, options_.q, starts[r % starts.size()], data + (r - c * GK_WALK_CHUNK_ROWS) * length, length);
+					}
+					if (monitor && !monitor(static_cast<double>(++done) / chunks)) {
+						stopped = true;
+					}
+				}
+			});
+		}
+	};
+
+	if (0 < waves) {
+		gk::Scheduler::Group group{scheduler};
+		produce(0, group);
+		group.wait();
+	}
+
+	// the calling thread is the single writer, overlapping the next wave
+	for (long long wave = 0; wave < waves && !stopped; ++wave) {
+		gk::Scheduler::Group group{scheduler};
+		if (wave + 1 < waves) {
+			produce(wave + 1, group);
+		}
+		auto& buffer = buffers[wave & 1];
+		auto row = wave * span * GK_WALK_CHUNK_ROWS;
+		sink(row, buffer.data(), static_cast<long long>(buffer.size()) / length);
+		group.wait();
+	}
+	return !stopped;
+}
@@ -0,0 +1,120 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* RandomWalk.h
+*
+* Generates fixed length biased (node2vec) random walks over a Topology. Walks
+* are split into chunks of rows that are generated in parallel on the
+* Scheduler, each chunk seeding its own random number generator. A row is a walk of vertex ids,
+* padded with -1 when the walk reaches a vertex without neighbours.
+*/
+
+#ifndef GRAPHKIT_SRC_RANDOM_WALK_H
+#define GRAPHKIT_SRC_RANDOM_WALK_H
+
+#include <functional>
+#include <vector>
+#include "Topology.h"
+#include "Scheduler.h"
+
+namespace gk {
+	class RandomWalk {
+	public:
+
+		// aliases
+		using Vertex = gk::Topology::Vertex;
+		using Sink = std::function<void(long long row, const Vertex* data, long long rows)>;
+
+		/**
+		* Options
+		* length is the number of vertices per walk, walks the number of walks
+		* per start vertex, p the return and q the in-out parameters of node2vec.
+		* A threads value of 0 uses every Scheduler thread.
+		*/
+		struct Options {
+			int length = 80;
+			int walks = 10;
+			double p = 1;
+			double q = 1;
+			unsigned threads = 0;
+			unsigned long long seed = 0;
+		};
+
+		/**
+		* RandomWalk
+		* Constructor.
+		* @param		const gk::Topology& topology
+		* @param		const Options& options
+		*/
+		RandomWalk(const gk::Topology& topology, const Options& options) noexcept;
+
+		/**
+		* ~RandomWalk
+		* Destructor.
+		*/
+		virtual ~RandomWalk();
+
+		// defaults
+		RandomWalk(const RandomWalk&) = default;
+		RandomWalk& operator= (const RandomWalk&) = delete;
+		RandomWalk(RandomWalk&&) = default;
+		RandomWalk& operator= (RandomWalk&&) = delete;
+
+		/**
+		* rows
+		* The number of walks generated for a set of start vertices.
+		* @param		const std::vector<Vertex>& starts
+		* @return		long long
+		*/
+		long long rows(const std::vector<Vertex>& starts) const noexcept;
+
+		/**
+		* run
+		* Generates every walk directly into out, which must hold
+		* rows(starts) * length vertices. Row r starts at starts[r % starts.size()].
+		* @param		const std::vector<Vertex>& starts
+		* @param		Vertex* out
+		* @param		const gk::Scheduler::Monitor& monitor, optional
+		* @return		bool, false if the monitor stopped the walks
+		*/
+		bool run(const std::vector<Vertex>& starts, Vertex* out, const gk::Scheduler::Monitor& monitor = nullptr) noexcept;
+
+		/**
+		* run
+		* Generates the walks in waves of chunks, handing each wave to the sink
+		* on the calling thread in row order while the next wave is generated.
+		* @param		const std::vector<Vertex>& starts
+		* @param		const Sink& sink
+		* @param		const gk::Scheduler::Monitor& monitor, optional
+		* @return		bool, false if the monitor stopped the walks
+		*/
+		bool run(const std::vector<Vertex>& starts, const Sink& sink, const gk::Scheduler::Monitor& monitor = nullptr) noexcept;
+
+	protected:
+		const gk::Topology& topology_;
+		Options options_;
+
+		/**
+		* workers
+		* The number of tasks to run in parallel.
+		* @return		unsigned
+		*/
+		unsigned workers() const noexcept;
+	};
+}
+
+#endif
@@ -21,6 +21,8 @@
 
 #include <cassert>
 #include <functional>
+#include <utility>
+#include <vector>
 #include "RedBlackNode.h"
 
 namespace gk {
@@ -339,6 +341,21 @@ namespace gk {
 			return z;
 		}
 
+		inline RBNode* internalLink(std::vector<RBNode*>& nodes, O first, O last, RBNode* parent, O depth, O levels) noexcept {
+			if (first >= last) {
+				return nil_;
+			}
+			// halves differ by at most one, so only the last, partial level is red
+			auto middle = first + (last - first) / 2;
+			auto x = nodes[middle];
+			x->parent_ = parent;
+			x->left_ = internalLink(nodes, first, middle, x, depth + 1, levels);
+			x->right_ = internalLink(nodes, middle + 1, last, x, depth + 1, levels);
+			x->colour_ = depth == levels;
+			x->order_ = last - first;
+			return x;
+		}
+
 	public:
 		RedBlackTree() noexcept
 			: nil_{new RBNode{}}, root_{nil_}, count_{} {
@@ -396,6 +413,56 @@ namespace gk {
 			return true;
 		}
 
+		// inserts increasing keys greater than every held key, rebuilding the tree
+		// balanced in linear time unless it is larger than the batch
+		inline O append(const std::vector<std::pair<K, T*>>& sorted, const DataCallback& callback) noexcept {
+			assert(callback);
+			if (sorted.empty()) {
+				return 0;
+			}
+			O n = sorted.size();
+			if (n < count_ || (root_ != nil_ && !(maximum(root_)->key_ < sorted.front().first))) {
+				O inserted = 0;
+				for (auto& item : sorted) {
+					if (insert(item.first, item.second, callback)) {
+						++inserted;
+					}
+				}
+				return inserted;
+			}
+
+			// the held nodes in order, then the new ones
+			std::vector<RBNode*> nodes;
+			nodes.reserve(count_ + n);
+			std::vector<RBNode*> stack;
+			for (auto x = root_; x != nil_ || !stack.empty();) {
+				if (x != nil_) {
+					stack.push_back(x);
+					x = x->left_;
+				} else {
+					x = stack.back();
+					stack.pop_back();
+					nodes.push_back(x);
+					x = x->right_;
+				}
+			}
+			for (auto& item : sorted) {
+				nodes.push_back(new RBNode{nil_, nil_, item.first, item.second});
+			}
+
+			// every level above floor(log2(count + 1)) is full
+			count_ = nodes.size();
+			O levels = 0;
+			while ((static_cast<O>(2) << levels) - 1 <= count_) {
+				++levels;
+			}
+			root_ = internalLink(nodes, 0, count_, nil_, 0, levels);
+			for (auto& item : sorted) {
+				callback(item.second);
+			}
+			return n;
+		}
+
 		inline void clear() noexcept {
 			for (auto order = count_; 0 < order; --order) {
 				remove(node(order)->key_);
@@ -444,6 +511,25 @@ namespace gk {
 		inline bool has(const K& key) const noexcept {
 			return root_ != nil_ && nil_ != internalFindByKey(key);
 		}
+
+		// visits every key and its data in order, walking the parent links
+		// rather than selecting each order, so nothing is allocated
+		template <typename F>
+		inline void each(F&& visit) const noexcept {
+			for (auto x = minimum(root_); x != nil_;) {
+				visit(x->key_, x->data_);
+				if (x->right_ != nil_) {
+					x = minimum(x->right_);
+					continue;
+				}
+				auto y = x->parent_;
+				while (y != nil_ && x == y->right_) {
+					x = y;
+					y = y->parent_;
+				}
+				x = y;
+			}
+		}
 	};
 }
 
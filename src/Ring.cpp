@@ -0,0 +1,362 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "Ring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define GK_RING_URING
+#endif
+#endif
+
+#ifdef GK_RING_URING
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// the largest read submitted as a single request
+static const std::size_t GK_RING_CHUNK = 1 << 20;
+
+#ifdef GK_RING_URING
+static int enter(int fd, unsigned submit, unsigned wait) {
+	int r;
+	do {
+		r = syscall(__NR_io_uring_enter, fd, submit, wait, 0 < wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+	} while (0 > r && EINTR == errno);
+	return 0 > r ? -errno : r;
+}
+#endif
+
+gk::Ring::Ring(unsigned entries) noexcept
+	: fd_{-1},
+	  event_{-1},
+	  entries_{0},
+	  pending_{0},
+	  sq_{nullptr},
+	  sqSize_{0},
+	  cq_{nullptr},
+	  cqSize_{0},
+	  sqes_{nullptr},
+	  sqesSize_{0},
+	  sqHead_{nullptr},
+	  sqTail_{nullptr},
+	  sqMask_{nullptr},
+	  sqArray_{nullptr},
+	  cqHead_{nullptr},
+	  cqTail_{nullptr},
+	  cqMask_{nullptr},
+	  cqes_{nullptr} {
+#ifdef GK_RING_URING
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	auto fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+	if (0 > fd) {
+		return;
+	}
+
+	// reads and writes at an offset came with the current position feature
+	if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+		close(fd);
+		return;
+	}
+	sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+	}
+	sq_ = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (MAP_FAILED == sq_) {
+		sq_ = nullptr;
+		close(fd);
+		return;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		cq_ = sq_;
+	} else {
+		cq_ = mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (MAP_FAILED == cq_) {
+			cq_ = nullptr;
+			munmap(sq_, sqSize_);
+			sq_ = nullptr;
+			close(fd);
+			return;
+		}
+	}
+	sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+	sqes_ = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (MAP_FAILED == sqes_) {
+		sqes_ = nullptr;
+		if (cq_ != sq_) {
+			munmap(cq_, cqSize_);
+		}
+		munmap(sq_, sqSize_);
+		sq_ = cq_ = nullptr;
+		close(fd);
+		return;
+	}
+
+	auto sq = static_cast<char*>(sq_);
+	sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	sqMask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	auto cq = static_cast<char*>(cq_);
+	cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	cqMask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	cqes_ = cq + params.cq_off.cqes;
+	entries_ = params.sq_entries;
+	fd_ = fd;
+#else
+	(void)entries;
+#endif
+}
+
+gk::Ring::~Ring() {
+#ifdef GK_RING_URING
+	if (0 > fd_) {
+		return;
+	}
+	munmap(sqes_, sqesSize_);
+	if (cq_ != sq_) {
+		munmap(cq_, cqSize_);
+	}
+	munmap(sq_, sqSize_);
+	if (0 <= event_) {
+		close(event_);
+	}
+	close(fd_);
+#endif
+}
+
+bool gk::Ring::supported() noexcept {
+	static const bool supported = []() {
+		gk::Ring ring{2};
+		return ring.valid();
+	}();
+	return supported;
+}
+
+gk::Ring* gk::Ring::local() noexcept {
+	if (!supported()) {
+		return nullptr;
+	}
+	static thread_local std::unique_ptr<gk::Ring> ring;
+	if (!ring) {
+		ring.reset(new gk::Ring{});
+	}
+	return ring->valid() ? ring.get() : nullptr;
+}
+
+bool gk::Ring::valid() const noexcept {
+	return 0 <= fd_;
+}
+
+bool gk::Ring::prepare(Op op, int fd, void* buf, std::size_t length, long long offset, uint64_t data, bool link) noexcept {
+#ifdef GK_RING_URING
+	if (0 > fd_) {
+		return false;
+	}
+
+	// only this thread produces, the kernel moves the head
+	auto tail = *sqTail_;
+	if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= entries_) {
+		return false;
+	}
+	auto index = tail & *sqMask_;
+	auto sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+	memset(sqe, 0, sizeof(*sqe));
+	switch (op) {
+		case Op::Read:
+			sqe->opcode = IORING_OP_READ;
+			break;
+		case Op::Write:
+			sqe->opcode = IORING_OP_WRITE;
+			break;
+		case Op::Sync:
+			sqe->opcode = IORING_OP_FSYNC;
+			break;
+		case Op::DataSync:
+			sqe->opcode = IORING_OP_FSYNC;
+			sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+			break;
+		default:
+			sqe->opcode = IORING_OP_NOP;
+			break;
+	}
+	sqe->fd = Op::Nop == op ? -1 : fd;
+	sqe->addr = reinterpret_cast<uint64_t>(buf);
+	sqe->len = static_cast<unsigned>(length);
+	sqe->off = static_cast<uint64_t>(offset);
+	sqe->user_data = data;
+	sqe->flags = link ? IOSQE_IO_LINK : 0;
+	sqArray_[index] = index;
+	__atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+	++pending_;
+	return true;
+#else
+	(void)op; (void)fd; (void)buf; (void)length; (void)offset; (void)data; (void)link;
+	return false;
+#endif
+}
+
+int gk::Ring::submit(unsigned wait) noexcept {
+#ifdef GK_RING_URING
+	if (0 > fd_) {
+		return -EBADF;
+	}
+	auto r = enter(fd_, pending_, wait);
+	if (0 <= r) {
+		pending_ -= std::min(pending_, static_cast<unsigned>(r));
+	}
+	return r;
+#else
+	(void)wait;
+	return -ENOSYS;
+#endif
+}
+
+bool gk::Ring::complete(uint64_t& data, int& result) noexcept {
+#ifdef GK_RING_URING
+	if (0 > fd_) {
+		return false;
+	}
+	auto head = *cqHead_;
+	if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+		return false;
+	}
+	auto cqe = static_cast<io_uring_cqe*>(cqes_) + (head & *cqMask_);
+	data = cqe->user_data;
+	result = cqe->res;
+	__atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+	return true;
+#else
+	(void)data; (void)result;
+	return false;
+#endif
+}
+
+int gk::Ring::notifier() noexcept {
+#ifdef GK_RING_URING
+	if (0 > fd_ || 0 <= event_) {
+		return event_;
+	}
+	auto event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (0 > event) {
+		return -errno;
+	}
+	if (0 > syscall(__NR_io_uring_register, fd_, IORING_REGISTER_EVENTFD, &event, 1)) {
+		auto error = -errno;
+		close(event);
+		return error;
+	}
+	event_ = event;
+	return event_;
+#else
+	return -ENOSYS;
+#endif
+}
+
+void gk::Ring::acknowledge() noexcept {
+#ifdef GK_RING_URING
+	if (0 <= event_) {
+		eventfd_t value;
+		eventfd_read(event_, &value);
+	}
+#endif
+}
+
+long long gk::Ring::read(int fd, void* buf, std::size_t length, long long offset) noexcept {
+	long long total = 0;
+	auto p = static_cast<char*>(buf);
+	std::vector<int> results;
+	while (static_cast<std::size_t>(total) < length) {
+		// as many chunks as the ring holds go in one submission
+		unsigned count = 0;
+		for (auto at = static_cast<std::size_t>(total); at < length && count < entries_; at += GK_RING_CHUNK, ++count) {
+			if (!prepare(Op::Read, fd, p + at, std::min(GK_RING_CHUNK, length - at), offset + at, count)) {
+				break;
+			}
+		}
+		if (0 == count) {
+			return -EBUSY;
+		}
+		results.assign(count, 0);
+		unsigned done = 0;
+		uint64_t data;
+		int result;
+		auto r = submit(count);
+		while (done < count) {
+			if (0 > r) {
+				return r;
+			}
+			while (complete(data, result)) {
+				results[data] = result;
+				++done;
+			}
+			if (done < count) {
+				r = submit(count - done);
+			}
+		}
+
+		// stops at the first failed or short chunk
+		for (unsigned i = 0; i < count; ++i) {
+			auto expected = std::min(GK_RING_CHUNK, length - static_cast<std::size_t>(total));
+			if (0 > results[i]) {
+				return 0 < total ? total : results[i];
+			}
+			total += results[i];
+			if (static_cast<std::size_t>(results[i]) < expected) {
+				return total;
+			}
+		}
+	}
+	return total;
+}
+
+long long gk::Ring::write(int fd, const void* buf, std::size_t length, long long offset) noexcept {
+	long long total = 0;
+	auto p = static_cast<const char*>(buf);
+	while (static_cast<std::size_t>(total) < length) {
+		if (!prepare(Op::Write, fd, const_cast<char*>(p) + total, length - total, offset + total, 0)) {
+			return -EBUSY;
+		}
+		auto r = submit(1);
+		uint64_t data;
+		int result = 0;
+		while (0 <= r && !complete(data, result)) {
+			r = submit(1);
+		}
+		if (0 > r) {
+			return r;
+		}
+		if (0 >= result) {
+			return 0 < total ? total : (0 == result ? -EIO : result);
+		}
+		total += result;
+	}
+	return total;
+}
@@ -0,0 +1,179 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Ring.h
+*
+* A small io_uring submission ring driven through the raw system calls, so
+* no library is needed. Writes and syncs are queued and submitted together
+* and their completions are reaped later, an eventfd signals them to the
+* libuv loop without taking a thread pool slot. Reads may be split into
+* chunks submitted at once, which keeps deep queues on fast devices. On
+* other systems, or kernels without io_uring, no Ring is valid and callers
+* keep the libuv file system path.
+*/
+
+#ifndef GRAPHKIT_SRC_RING_H
+#define GRAPHKIT_SRC_RING_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gk {
+	class Ring {
+	public:
+
+		/**
+		* Op
+		* The operations a Ring submits.
+		*/
+		enum class Op {
+			Nop,
+			Read,
+			Write,
+			Sync,
+			DataSync
+		};
+
+		/**
+		* Ring
+		* Constructor, sets up a ring of entries submissions.
+		* @param		unsigned entries
+		*/
+		Ring(unsigned entries = 64) noexcept;
+
+		/**
+		* ~Ring
+		* Destructor.
+		*/
+		virtual ~Ring();
+
+		// defaults
+		Ring(const Ring&) = delete;
+		Ring& operator= (const Ring&) = delete;
+		Ring(Ring&&) = delete;
+		Ring& operator= (Ring&&) = delete;
+
+		/**
+		* supported
+		* Whether io_uring can be used, probed once.
+		* @return		bool
+		*/
+		static bool supported() noexcept;
+
+		/**
+		* local
+		* The Ring of the calling thread for synchronous requests.
+		* @return		gk::Ring*, nullptr if io_uring is not supported
+		*/
+		static gk::Ring* local() noexcept;
+
+		/**
+		* valid
+		* Whether the ring was set up.
+		* @return		bool
+		*/
+		bool valid() const noexcept;
+
+		/**
+		* prepare
+		* Queues a request, linked ones start once the previous one succeeded.
+		* @param		Op op
+		* @param		int fd
+		* @param		void* buf
+		* @param		std::size_t length
+		* @param		long long offset
+		* @param		uint64_t data, returned with the completion
+		* @param		bool link
+		* @return		bool, false if the submission queue is full
+		*/
+		bool prepare(Op op, int fd, void* buf, std::size_t length, long long offset, uint64_t data, bool link = false) noexcept;
+
+		/**
+		* submit
+		* Submits the queued requests, waiting for a number of completions.
+		* @param		unsigned wait
+		* @return		int, the number submitted or a negative errno
+		*/
+		int submit(unsigned wait = 0) noexcept;
+
+		/**
+		* complete
+		* Takes the next completion if any.
+		* @param		uint64_t& data
+		* @param		int& result, the bytes transferred or a negative errno
+		* @return		bool
+		*/
+		bool complete(uint64_t& data, int& result) noexcept;
+
+		/**
+		* notifier
+		* An eventfd signalled on every completion, created on first use.
+		* @return		int, negative if it could not be registered
+		*/
+		int notifier() noexcept;
+
+		/**
+		* acknowledge
+		* Resets the eventfd before the completions are taken.
+		*/
+		void acknowledge() noexcept;
+
+		/**
+		* read
+		* Reads length bytes at an offset, in chunks submitted together.
+		* @param		int fd
+		* @param		void* buf
+		* @param		std::size_t length
+		* @param		long long offset
+		* @return		long long, the bytes read up to the first short chunk or a negative errno
+		*/
+		long long read(int fd, void* buf, std::size_t length, long long offset) noexcept;
+
+		/**
+		* write
+		* Writes length bytes at an offset.
+		* @param		int fd
+		* @param		const void* buf
+		* @param		std::size_t length
+		* @param		long long offset
+		* @return		long long, the bytes written or a negative errno
+		*/
+		long long write(int fd, const void* buf, std::size_t length, long long offset) noexcept;
+
+	protected:
+		int fd_;
+		int event_;
+		unsigned entries_;
+		unsigned pending_;
+		void* sq_;
+		std::size_t sqSize_;
+		void* cq_;
+		std::size_t cqSize_;
+		void* sqes_;
+		std::size_t sqesSize_;
+		unsigned* sqHead_;
+		unsigned* sqTail_;
+		unsigned* sqMask_;
+		unsigned* sqArray_;
+		unsigned* cqHead_;
+		unsigned* cqTail_;
+		unsigned* cqMask_;
+		void* cqes_;
+	};
+}
+
+#endif
@@ -0,0 +1,208 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Scheduler.h"
+
+// the Scheduler and worker index of the current thread
+static thread_local gk::Scheduler* GK_SCHEDULER_OWNER = nullptr;
+static thread_local int GK_SCHEDULER_WORKER = -1;
+
+bool gk::Scheduler::Group::State::run() noexcept {
+	Task task;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (tasks.empty()) {
+			return false;
+		}
+		task = std::move(tasks.front());
+		tasks.pop_front();
+	}
+	task();
+	std::lock_guard<std::mutex> lock(mutex);
+	if (0 == --pending) {
+		done.notify_all();
+	}
+	return true;
+}
+
+gk::Scheduler::Group::Group(gk::Scheduler& scheduler) noexcept
+	: scheduler_(scheduler),
+	  state_{std::make_shared<State>()} {}
+
+gk::Scheduler::Group::~Group() {
+	wait();
+}
+
+void gk::Scheduler::Group::submit(Task task) noexcept {
+	{
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		state_->tasks.push_back(std::move(task));
+		++state_->pending;
+	}
+	// the worker runs whichever task of the Group is still waiting, if any
+	auto state = state_;
+	scheduler_.submit([state]() {
+		state->run();
+	});
+}
+
+void gk::Scheduler::Group::wait() noexcept {
+	while (state_->run()) {}
+	std::unique_lock<std::mutex> lock(state_->mutex);
+	state_->done.wait(lock, [&]() {
+		return 0 == state_->pending;
+	});
+}
+
+gk::Scheduler::Scheduler(unsigned threads) noexcept
+	: workers_{},
+	  threads_{},
+	  queued_{0},
+	  next_{0},
+	  mutex_{},
+	  wake_{},
+	  stopping_{false} {
+	start(threads);
+}
+
+gk::Scheduler::~Scheduler() {
+	stop();
+}
+
+gk::Scheduler& gk::Scheduler::instance() noexcept {
+	// never destroyed, so exiting does not wait on running jobs
+	static auto scheduler = new gk::Scheduler{};
+	return *scheduler;
+}
+
+unsigned gk::Scheduler::threads() const noexcept {
+	return static_cast<unsigned>(threads_.size());
+}
+
+void gk::Scheduler::threads(unsigned threads) noexcept {
+	auto n = 0 < threads ? threads : std::thread::hardware_concurrency();
+	if (n != this->threads()) {
+		stop();
+		start(n);
+	}
+}
+
+void gk::Scheduler::start(unsigned n) noexcept {
+	if (0 == n) {
+		n = std::thread::hardware_concurrency();
+	}
+	if (0 == n) {
+		n = 1;
+	}
+	stopping_ = false;
+	for (unsigned i = 0; i < n; ++i) {
+		workers_.emplace_back(new Worker{});
+	}
+	for (unsigned i = 0; i < n; ++i) {
+		threads_.emplace_back(&gk::Scheduler::loop, this, static_cast<int>(i));
+	}
+}
+
+void gk::Scheduler::stop() noexcept {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	wake_.notify_all();
+	for (auto& t : threads_) {
+		t.join();
+	}
+	threads_.clear();
+	workers_.clear();
+}
+
+void gk::Scheduler::submit(Task task) noexcept {
+	auto w = this == GK_SCHEDULER_OWNER ? GK_SCHEDULER_WORKER : static_cast<int>(next_++ % workers_.size());
+	{
+		std::lock_guard<std::mutex> lock(workers_[w]->mutex);
+		workers_[w]->tasks.push_back(std::move(task));
+	}
+	// sleeping workers check the count under the lock, so the wake up is never lost
+	std::lock_guard<std::mutex> lock(mutex_);
+	++queued_;
+	wake_.notify_one();
+}
+
+bool gk::Scheduler::take(int w, Task& task) noexcept {
+	int n = workers_.size();
+	if (0 <= w) {
+		std::lock_guard<std::mutex> lock(workers_[w]->mutex);
+		if (!workers_[w]->tasks.empty()) {
+			task = std::move(workers_[w]->tasks.back());
+			workers_[w]->tasks.pop_back();
+			--queued_;
+			return true;
+		}
+	}
+	// steal the oldest task of another worker
+	int first = 0 <= w ? w + 1 : static_cast<int>(next_ % n);
+	for (int k = 0; k < n; ++k) {
+		auto v = (first + k) % n;
+		if (v == w) {
+			continue;
+		}
+		std::lock_guard<std::mutex> lock(workers_[v]->mutex);
+		if (!workers_[v]->tasks.empty()) {
+			task = std::move(workers_[v]->tasks.front());
+			workers_[v]->tasks.pop_front();
+			--queued_;
+			return true;
+		}
+	}
+	return false;
+}
+
+void gk::Scheduler::parallel(unsigned n, const Task& body) noexcept {
+	if (0 == n) {
+		n = threads();
+	}
+	Group group{*this};
+	for (auto i = n; 1 < i; --i) {
+		group.submit(body);
+	}
+	body();
+	group.wait();
+}
+
+void gk::Scheduler::loop(int w) noexcept {
+	GK_SCHEDULER_OWNER = this;
+	GK_SCHEDULER_WORKER = w;
+	Task task;
+	for (;;) {
+		if (take(w, task)) {
+			task();
+			task = nullptr;
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (0 < queued_) {
+			continue;
+		}
+		if (stopping_) {
+			break;
+		}
+		wake_.wait(lock, [&]() {
+			return stopping_ || 0 < queued_;
+		});
+	}
+}
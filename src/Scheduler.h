@@ -0,0 +1,217 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Scheduler.h
+*
+* A work stealing thread pool for native analytics, separate from the libuv
+* thread pool so long running graph jobs do not starve file system and DNS
+* requests. Each worker owns a deque, popping its own tasks from the back and
+* stealing from the front of the other deques when it runs out of work.
+*/
+
+#ifndef GRAPHKIT_SRC_SCHEDULER_H
+#define GRAPHKIT_SRC_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gk {
+	class Scheduler {
+	public:
+
+		// aliases
+		using Task = std::function<void()>;
+
+		/**
+		* Monitor
+		* Receives the completed fraction of a long running operation from any
+		* thread, returning false to stop the operation early.
+		*/
+		using Monitor = std::function<bool(double fraction)>;
+
+		/**
+		* Group
+		* Tracks a set of submitted tasks so they can be waited on together.
+		*/
+		class Group {
+		public:
+
+			/**
+			* Group
+			* Constructor.
+			* @param		gk::Scheduler& scheduler
+			*/
+			explicit Group(gk::Scheduler& scheduler) noexcept;
+
+			/**
+			* ~Group
+			* Destructor, waits for the outstanding tasks.
+			*/
+			virtual ~Group();
+
+			// defaults
+			Group(const Group&) = delete;
+			Group& operator= (const Group&) = delete;
+			Group(Group&&) = delete;
+			Group& operator= (Group&&) = delete;
+
+			/**
+			* submit
+			* Schedules a task as part of the Group.
+			* @param		Task task
+			*/
+			void submit(Task task) noexcept;
+
+			/**
+			* wait
+			* Runs the tasks of the Group that have not started yet on the
+			* calling thread, then blocks until the others have finished. Only
+			* tasks of this Group are run, so waiting from a worker cannot
+			* deadlock and waiting from the v8 thread never picks up other jobs.
+			*/
+			void wait() noexcept;
+
+		protected:
+			struct State {
+				std::mutex mutex;
+				std::condition_variable done;
+				std::deque<Task> tasks;
+				long long pending = 0;
+
+				/**
+				* run
+				* Runs the oldest task that has not started yet.
+				* @return		bool, false if every task has started
+				*/
+				bool run() noexcept;
+			};
+
+			gk::Scheduler& scheduler_;
+			std::shared_ptr<State> state_;
+		};
+
+		/**
+		* Scheduler
+		* Constructor.
+		* @param		unsigned threads, 0 uses the hardware concurrency
+		*/
+		explicit Scheduler(unsigned threads = 0) noexcept;
+
+		/**
+		* ~Scheduler
+		* Destructor, finishes the queued tasks and joins the workers.
+		*/
+		virtual ~Scheduler();
+
+		// defaults
+		Scheduler(const Scheduler&) = delete;
+		Scheduler& operator= (const Scheduler&) = delete;
+		Scheduler(Scheduler&&) = delete;
+		Scheduler& operator= (Scheduler&&) = delete;
+
+		/**
+		* instance
+		* The shared Scheduler of the addon, started on first use.
+		* @return		gk::Scheduler&
+		*/
+		static gk::Scheduler& instance() noexcept;
+
+		/**
+		* threads
+		* The number of worker threads.
+		* @return		unsigned
+		*/
+		unsigned threads() const noexcept;
+
+		/**
+		* threads
+		* Resizes the pool. Every worker is joined first, so the calling
+		* thread blocks until the running and queued tasks drain, the v8
+		* thread included. Must not be called from a worker thread.
+		* @param		unsigned threads, 0 uses the hardware concurrency
+		*/
+		void threads(unsigned threads) noexcept;
+
+		/**
+		* submit
+		* Schedules a task. Tasks submitted from a worker go to its own deque.
+		* @param		Task task
+		*/
+		void submit(Task task) noexcept;
+
+		/**
+		* parallel
+		* Runs body concurrently on up to n threads, including the calling
+		* thread, and returns once every copy has finished. The body is
+		* expected to pull its work from a shared counter.
+		* @param		unsigned n, 0 uses every worker
+		* @param		const Task& body
+		*/
+		void parallel(unsigned n, const Task& body) noexcept;
+
+	protected:
+		struct Worker {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::unique_ptr<Worker>> workers_;
+		std::vector<std::thread> threads_;
+		std::atomic<long long> queued_;
+		std::atomic<unsigned> next_;
+		std::mutex mutex_;
+		std::condition_variable wake_;
+		bool stopping_;
+
+		/**
+		* start
+		* Starts n workers.
+		* @param		unsigned n
+		*/
+		void start(unsigned n) noexcept;
+
+		/**
+		* stop
+		* Joins the workers once every queued task has run.
+		*/
+		void stop() noexcept;
+
+		/**
+		* take
+		* Pops a task from the deque of worker w, or steals one from another.
+		* @param		int w, -1 for threads outside the pool
+		* @param		Task& task
+		* @return		bool
+		*/
+		bool take(int w, Task& task) noexcept;
+
+		/**
+		* loop
+		* The body of worker w.
+		* @param		int w
+		*/
+		void loop(int w) noexcept;
+	};
+}
+
+#endif
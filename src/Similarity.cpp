@@ -0,0 +1,280 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+#include "Similarity.h"
+#include "Entity.h"
+#include "Action.h"
+
+// vertices probed per chunk of work
+static const gk::Similarity::Vertex GK_SIMILARITY_CHUNK = 64;
+
+// the size of the intersection of two sorted lists
+template <typename V>
+static long long intersect(const V* a, long long m, const V* b, long long n) {
+	long long i = 0, j = 0, c = 0;
+	while (i < m && j < n) {
+		if (a[i] < b[j]) {
+			++i;
+		} else if (b[j] < a[i]) {
+			++j;
+		} else {
+			++c;
+			++i;
+			++j;
+		}
+	}
+	return c;
+}
+
+// the Entities an Entity has acted on as a subject, sorted by address
+static void objectsOf(v8::Isolate* isolate, gk::Entity* entity, const std::string& actionType, std::vector<gk::Node*>& out) {
+	out.clear();
+	auto actions = entity->actions(isolate);
+	for (auto i = actions->count(); 0 < i; --i) {
+		auto action = dynamic_cast<gk::Action<gk::Entity>*>(actions->select(i));
+		if (!action || (!actionType.empty() && actionType != action->type())) {
+			continue;
+		}
+		if (!action->subjects(isolate)->has(entity->hash())) {
+			continue;
+		}
+		auto objects = action->objects(isolate);
+		for (auto j = objects->count(); 0 < j; --j) {
+			out.push_back(objects->select(j));
+		}
+	}
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// the Entities that acted on an Entity as an object, sorted by address
+static void subjectsOf(v8::Isolate* isolate, gk::Entity* entity, const std::string& actionType, std::vector<gk::Node*>& out) {
+	out.clear();
+	auto actions = entity->actions(isolate);
+	for (auto i = actions->count(); 0 < i; --i) {
+		auto action = dynamic_cast<gk::Action<gk::Entity>*>(actions->select(i));
+		if (!action || (!actionType.empty() && actionType != action->type())) {
+			continue;
+		}
+		if (!action->objects(isolate)->has(entity->hash())) {
+			continue;
+		}
+		auto subjects = action->subjects(isolate);
+		for (auto j = subjects->count(); 0 < j; --j) {
+			out.push_back(subjects->select(j));
+		}
+	}
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+gk::Similarity::Similarity(const gk::Topology& topology, Metric metric) noexcept
+	: topology_(topology),
+	  metric_{metric} {}
+
+gk::Similarity::~Similarity() {}
+
+double gk::Similarity::score(Metric metric, long long overlap, long long a, long long b) noexcept {
+	if (0 == overlap) {
+		return 0;
+	}
+	if (Metric::Cosine == metric) {
+		return overlap / std::sqrt(static_cast<double>(a) * b);
+	}
+	return static_cast<double>(overlap) / (a + b - overlap);
+}
+
+long long gk::Similarity::overlap(long long size, double threshold) const noexcept {
+	// jaccard >= t implies an overlap of t|x|, cosine >= t an overlap of t^2|x|
+	auto t = Metric::Cosine == metric_ ? threshold * threshold : threshold;
+	auto o = static_cast<long long>(std::ceil(t * size - 1e-9));
+	return std::max(1LL, std::min(size, o));
+}
+
+std::vector<gk::Similarity::Match<gk::Similarity::Vertex>> gk::Similarity::pairs(double threshold, unsigned threads, const gk::Scheduler::Monitor& monitor) const noexcept {
+	auto n = topology_.vertices();
+
+	// rank objects by increasing frequency, rare objects make selective prefixes
+	std::vector<long long> frequency(n, 0);
+	for (Vertex u = 0; u < n; ++u) {
+		auto first = topology_.neighbours(u);
+		for (auto k = topology_.degree(u) - 1; 0 <= k; --k) {
+			++frequency[first[k]];
+		}
+	}
+	std::vector<Vertex> order(n);
+	for (Vertex v = 0; v < n; ++v) {
+		order[v] = v;
+	}
+	std::sort(order.begin(), order.end(), [&](Vertex a, Vertex b) {
+		return frequency[a] < frequency[b] || (frequency[a] == frequency[b] && a < b);
+	});
+	std::vector<Vertex> rank(n);
+	for (Vertex r = 0; r < n; ++r) {
+		rank[order[r]] = r;
+	}
+
+	// neighbour lists rewritten as sorted ranks
+	std::vector<long long> offsets(n + 1, 0);
+	std::vector<Vertex> tokens(topology_.edges());
+	for (Vertex u = 0; u < n; ++u) {
+		auto first = topology_.neighbours(u);
+		auto degree = topology_.degree(u);
+		for (auto k = 0; k < degree; ++k) {
+			tokens[offsets[u] + k] = rank[first[k]];
+		}
+		std::sort(tokens.begin() + offsets[u], tokens.begin() + offsets[u] + degree);
+		offsets[u + 1] = offsets[u] + degree;
+	}
+
+	// subjects processed in increasing size, a pair is reported by its larger side
+	std::vector<Vertex> sequence;
+	for (Vertex u = 0; u < n; ++u) {
+		if (0 < topology_.degree(u)) {
+			sequence.push_back(u);
+		}
+	}
+	std::sort(sequence.begin(), sequence.end(), [&](Vertex a, Vertex b) {
+		return topology_.degree(a) < topology_.degree(b) || (topology_.degree(a) == topology_.degree(b) && a < b);
+	});
+	std::vector<Vertex> position(n, -1);
+	for (Vertex i = 0; i < static_cast<Vertex>(sequence.size()); ++i) {
+		position[sequence[i]] = i;
+	}
+
+	// inverted index over the prefixes
+	auto prefix = [&](Vertex u) {
+		long long size = topology_.degree(u);
+		return size - overlap(size, threshold) + 1;
+	};
+	std::vector<long long> heads(n + 1, 0);
+	for (auto u : sequence) {
+		for (auto k = prefix(u) - 1; 0 <= k; --k) {
+			++heads[tokens[offsets[u] + k] + 1];
+		}
+	}
+	for (Vertex r = 0; r < n; ++r) {
+		heads[r + 1] += heads[r];
+	}
+	std::vector<Vertex> postings(heads[n]);
+	std::vector<long long> cursor(heads.begin(), heads.end() - 1);
+	for (auto u : sequence) {
+		for (auto k = prefix(u) - 1; 0 <= k; --k) {
+			postings[cursor[tokens[offsets[u] + k]]++] = u;
+		}
+	}
+
+	// probe every subject against the earlier, smaller subjects
+	std::vector<Match<Vertex>> matches;
+	std::mutex mutex;
+	std::atomic<Vertex> next{0};
+	std::atomic<Vertex> done{0};
+	std::atomic<bool> stopped{false};
+	auto count = static_cast<Vertex>(sequence.size());
+	auto bound = Metric::Cosine == metric_ ? threshold * threshold : threshold;
+
+	auto worker = [&]() {
+		std::vector<Vertex> stamp(n, -1);
+		std::vector<Vertex> candidates;
+		std::vector<Match<Vertex>> found;
+		for (auto c = next.fetch_add(GK_SIMILARITY_CHUNK); c < count && !stopped; c = next.fetch_add(GK_SIMILARITY_CHUNK)) {
+			auto last = std::min(count, c + GK_SIMILARITY_CHUNK);
+			for (auto i = c; i < last; ++i) {
+				auto x = sequence[i];
+				long long size = topology_.degree(x);
+				candidates.clear();
+				for (auto k = prefix(x) - 1; 0 <= k; --k) {
+					auto token = tokens[offsets[x] + k];
+					for (auto p = heads[token]; p < heads[token + 1]; ++p) {
+						auto y = postings[p];
+						if (position[y] >= i || stamp[y] == x || topology_.degree(y) < bound * size) {
+							continue;
+						}
+						stamp[y] = x;
+						candidates.push_back(y);
+					}
+				}
+				for (auto y : candidates) {
+					long long o = intersect(tokens.data() + offsets[x], size, tokens.data() + offsets[y], topology_.degree(y));
+					auto s = score(metric_, o, size, topology_.degree(y));
+					if (s >= threshold) {
+						found.push_back({std::min(x, y), std::max(x, y), s});
+					}
+				}
+			}
+			if (monitor && !monitor(static_cast<double>(done += last - c) / count)) {
+				stopped = true;
+			}
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		matches.insert(matches.end(), found.begin(), found.end());
+	};
+
+	gk::Scheduler::instance().parallel(threads, worker);
+	if (stopped) {
+		matches.clear();
+	}
+
+	std::sort(matches.begin(), matches.end(), [](const Match<Vertex>& a, const Match<Vertex>& b) {
+		return a.subject < b.subject || (a.subject == b.subject && a.object < b.object);
+	});
+	return matches;
+}
+
+std::vector<gk::Similarity::Match<gk::Node*>> gk::Similarity::similar(v8::Isolate* isolate, gk::Entity* entity, const std::string& actionType, Metric metric, std::size_t topK, double threshold) noexcept {
+	std::vector<gk::Node*> objects;
+	std::vector<gk::Node*> subjects;
+	std::vector<gk::Node*> others;
+	objectsOf(isolate, entity, actionType, objects);
+
+	// candidates share at least one object, the count is their overlap
+	std::unordered_map<gk::Node*, long long> overlaps;
+	for (auto object : objects) {
+		subjectsOf(isolate, dynamic_cast<gk::Entity*>(object), actionType, subjects);
+		for (auto subject : subjects) {
+			if (subject != entity) {
+				++overlaps[subject];
+			}
+		}
+	}
+
+	std::vector<Match<gk::Node*>> matches;
+	for (auto& candidate : overlaps) {
+		objectsOf(isolate, dynamic_cast<gk::Entity*>(candidate.first), actionType, others);
+		auto s = score(metric, candidate.second, objects.size(), others.size());
+		if (s >= threshold) {
+			matches.push_back({entity, candidate.first, s});
+		}
+	}
+
+	auto greater = [](const Match<gk::Node*>& a, const Match<gk::Node*>& b) {
+		return a.score > b.score || (a.score == b.score && a.object->hash() < b.object->hash());
+	};
+	if (0 < topK && topK < matches.size()) {
+		std::partial_sort(matches.begin(), matches.begin() + topK, matches.end(), greater);
+		matches.resize(topK);
+	} else {
+		std::sort(matches.begin(), matches.end(), greater);
+	}
+	return matches;
+}
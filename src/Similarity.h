@@ -0,0 +1,136 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Similarity.h
+*
+* Jaccard and cosine similarity between Entities, comparing the sets of
+* objects each Entity has acted on as a subject of an Action. Single Entity
+* queries walk the Action Sets around the Entity, all pairs queries run a
+* prefix filtered join over a directed Topology.
+*/
+
+#ifndef GRAPHKIT_SRC_SIMILARITY_H
+#define GRAPHKIT_SRC_SIMILARITY_H
+
+#include <string>
+#include <vector>
+#include "exports.h"
+#include "Node.h"
+#include "Topology.h"
+#include "Scheduler.h"
+
+namespace gk {
+	class Entity;
+
+	class Similarity {
+	public:
+
+		// aliases
+		using Vertex = gk::Topology::Vertex;
+
+		enum class Metric {
+			Jaccard,
+			Cosine
+		};
+
+		/**
+		* Match
+		* A scored pair of Entities, or vertices for all pairs queries.
+		*/
+		template <typename N>
+		struct Match {
+			N subject;
+			N object;
+			double score;
+		};
+
+		/**
+		* Similarity
+		* Constructor.
+		* @param		const gk::Topology& topology
+		* @param		Metric metric
+		*/
+		Similarity(const gk::Topology& topology, Metric metric) noexcept;
+
+		/**
+		* ~Similarity
+		* Destructor.
+		*/
+		virtual ~Similarity();
+
+		// defaults
+		Similarity(const Similarity&) = default;
+		Similarity& operator= (const Similarity&) = delete;
+		Similarity(Similarity&&) = default;
+		Similarity& operator= (Similarity&&) = delete;
+
+		/**
+		* pairs
+		* Finds every pair of vertices with a score of at least threshold.
+		* Objects are ranked by increasing frequency and only the prefix of
+		* each neighbour list that can still reach the threshold is indexed,
+		* so pairs that share only frequent objects are never compared.
+		* @param		double threshold, in (0, 1]
+		* @param		unsigned threads, 0 uses every Scheduler thread
+		* @param		const gk::Scheduler::Monitor& monitor, optional
+		* @return		std::vector<Match<Vertex>>, empty if the monitor stopped the join
+		*/
+		std::vector<Match<Vertex>> pairs(double threshold, unsigned threads, const gk::Scheduler::Monitor& monitor = nullptr) const noexcept;
+
+		/**
+		* score
+		* Computes the similarity from an overlap and the two set sizes.
+		* @param		Metric metric
+		* @param		long long overlap
+		* @param		long long a
+		* @param		long long b
+		* @return		double
+		*/
+		static double score(Metric metric, long long overlap, long long a, long long b) noexcept;
+
+		/**
+		* similar
+		* Finds the Entities most similar to an Entity. Candidates are only the
+		* subjects of Actions on the Entity's objects. Must be called on the
+		* v8 thread.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Entity* entity
+		* @param		const std::string& actionType, empty matches every type
+		* @param		Metric metric
+		* @param		std::size_t topK, 0 keeps every match
+		* @param		double threshold
+		* @return		std::vector<Match<gk::Node*>>
+		*/
+		static std::vector<Match<gk::Node*>> similar(v8::Isolate* isolate, gk::Entity* entity, const std::string& actionType, Metric metric, std::size_t topK, double threshold) noexcept;
+
+	protected:
+		const gk::Topology& topology_;
+		Metric metric_;
+
+		/**
+		* overlap
+		* The minimum overlap a set of a given size needs to reach the threshold
+		* with any other set.
+		* @param		long long size
+		* @param		double threshold
+		* @return		long long
+		*/
+		long long overlap(long long size, double threshold) const noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,386 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <uv.h>
+#include "Snapshot.h"
+#include "Codec.h"
+#include "Coordinator.h"
+#include "Entity.h"
+#include "Action.h"
+#include "Bond.h"
+
+static const char GK_SNAPSHOT_MAGIC[8] = {'G', 'K', 'S', 'N', 'A', 'P', '\0', '\0'};
+static const uint32_t GK_SNAPSHOT_VERSION = 1;
+static const uint32_t GK_SNAPSHOT_NONE = UINT32_MAX;
+
+// a packed image holds its size after the magic, then the framed blocks
+static const char GK_SNAPSHOT_PACKED[8] = {'G', 'K', 'S', 'N', 'A', 'P', 'Z', '\0'};
+static const std::size_t GK_SNAPSHOT_BLOCK = 1 << 20;
+
+// rounds a section offset up to 8 bytes
+static uint64_t align(uint64_t n) {
+	return (n + 7) & ~static_cast<uint64_t>(7);
+}
+
+// unpacks the blocks of a packed image, each must pass its checksum
+static bool unpack(const char* data, uint64_t size, std::string& image) {
+	uint64_t length;
+	memcpy(&length, data + sizeof(GK_SNAPSHOT_PACKED), sizeof(length));
+	if (size * 255 < length) {
+		return false;
+	}
+	image.clear();
+	image.reserve(length);
+	std::string block;
+	for (auto at = sizeof(GK_SNAPSHOT_PACKED) + sizeof(length); at < size;) {
+		std::size_t used;
+		if (!gk::Codec::unframe(data + at, size - at, block, used)) {
+			return false;
+		}
+		image += block;
+		at += used;
+	}
+	return image.size() == length;
+}
+
+gk::Snapshot::Snapshot() noexcept
+	: strings_{},
+	  ids_{},
+	  nodes_{},
+	  properties_{},
+	  groups_{},
+	  edges_{},
+	  targets_{},
+	  positions_{} {}
+
+gk::Snapshot::~Snapshot() {}
+
+uint32_t gk::Snapshot::intern(const std::string& s) noexcept {
+	auto it = ids_.find(s);
+	if (ids_.end() != it) {
+		return it->second;
+	}
+	auto id = static_cast<uint32_t>(strings_.size());
+	strings_.push_back(s);
+	ids_.insert({s, id});
+	return id;
+}
+
+std::size_t gk::Snapshot::count() const noexcept {
+	return nodes_.size();
+}
+
+void gk::Snapshot::add(v8::Isolate* isolate, gk::Node* node) noexcept {
+	Record r{};
+	r.id = node->id();
+	r.rank = node->rank();
+	r.type = intern(node->type());
+	r.nodeClass = gk::NodeClassToInt(node->nodeClass());
+
+	r.properties = properties_.size() / 2;
+	auto properties = node->properties();
+	for (auto i = properties->count(); 0 < i; --i) {
+		auto q = properties->node(i);
+		properties_.push_back(intern(q->key()));
+		properties_.push_back(intern(*q->data()));
+	}
+	r.propertyCount = static_cast<uint32_t>(properties->count());
+
+	r.groups = groups_.size();
+	auto groups = node->groups();
+	for (auto i = groups->count(); 0 < i; --i) {
+		groups_.push_back(intern(*groups->select(i)));
+	}
+	r.groupCount = static_cast<uint32_t>(groups->count());
+
+	// relationships are kept as Nodes until the positions are known
+	r.edges = edges_.size();
+	if (gk::NodeClass::Action == node->nodeClass()) {
+		auto action = dynamic_cast<gk::Action<gk::Entity>*>(node);
+		auto subjects = action->subjects(isolate);
+		for (auto i = subjects->count(); 0 < i; --i) {
+			edges_.push_back(subjects->select(i));
+		}
+		auto objects = action->objects(isolate);
+		for (auto i = objects->count(); 0 < i; --i) {
+			edges_.push_back(objects->select(i));
+		}
+		r.subjectCount = static_cast<uint32_t>(subjects->count());
+		r.objectCount = static_cast<uint32_t>(objects->count());
+	} else if (gk::NodeClass::Bond == node->nodeClass()) {
+		auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(node);
+		if (bond->subject()) {
+			edges_.push_back(bond->subject());
+			r.subjectCount = 1;
+		}
+		if (bond->object()) {
+			edges_.push_back(bond->object());
+			r.objectCount = 1;
+		}
+	}
+
+	positions_.insert({node, static_cast<uint32_t>(nodes_.size())});
+	nodes_.push_back(r);
+}
+
+void gk::Snapshot::seal() noexcept {
+	targets_.resize(edges_.size());
+	for (std::size_t i = 0; i < edges_.size(); ++i) {
+		auto it = positions_.find(edges_[i]);
+		targets_[i] = positions_.end() == it ? GK_SNAPSHOT_NONE : it->second;
+	}
+	edges_.clear();
+	positions_.clear();
+}
+
+std::string gk::Snapshot::write(const std::string& file, bool compress) const noexcept {
+	Header h{};
+	memcpy(h.magic, GK_SNAPSHOT_MAGIC, sizeof(h.magic));
+	h.version = GK_SNAPSHOT_VERSION;
+	h.strings = static_cast<uint32_t>(strings_.size());
+	h.nodes = nodes_.size();
+	h.properties = properties_.size() / 2;
+	h.groups = groups_.size();
+	h.edges = targets_.size();
+
+	// strings are null terminated so types can be used in place
+	uint64_t blob = 0;
+	for (auto& s : strings_) {
+		blob += s.length() + 1;
+	}
+	h.stringOffsets = align(sizeof(Header));
+	h.stringData = h.stringOffsets + (h.strings + 1) * sizeof(uint64_t);
+	h.nodeOffset = align(h.stringData + blob);
+	h.propertyOffset = h.nodeOffset + h.nodes * sizeof(Record);
+	h.groupOffset = align(h.propertyOffset + properties_.size() * sizeof(uint32_t));
+	h.edgeOffset = align(h.groupOffset + groups_.size() * sizeof(uint32_t));
+	h.size = align(h.edgeOffset + targets_.size() * sizeof(uint32_t));
+
+	std::string data(h.size, '\0');
+	auto base = &data[0];
+	memcpy(base, &h, sizeof(Header));
+	auto offsets = reinterpret_cast<uint64_t*>(base + h.stringOffsets);
+	uint64_t offset = 0;
+	for (std::size_t i = 0; i < strings_.size(); ++i) {
+		offsets[i] = offset;
+		memcpy(base + h.stringData + offset, strings_[i].c_str(), strings_[i].length() + 1);
+		offset += strings_[i].length() + 1;
+	}
+	offsets[strings_.size()] = offset;
+	if (!nodes_.empty()) {
+		memcpy(base + h.nodeOffset, nodes_.data(), nodes_.size() * sizeof(Record));
+	}
+	if (!properties_.empty()) {
+		memcpy(base + h.propertyOffset, properties_.data(), properties_.size() * sizeof(uint32_t));
+	}
+	if (!groups_.empty()) {
+		memcpy(base + h.groupOffset, groups_.data(), groups_.size() * sizeof(uint32_t));
+	}
+	if (!targets_.empty()) {
+		memcpy(base + h.edgeOffset, targets_.data(), targets_.size() * sizeof(uint32_t));
+	}
+	if (compress) {
+		std::string packed(GK_SNAPSHOT_PACKED, sizeof(GK_SNAPSHOT_PACKED));
+		packed.append(reinterpret_cast<const char*>(&h.size), sizeof(h.size));
+		for (std::size_t at = 0; at < data.length(); at += GK_SNAPSHOT_BLOCK) {
+			gk::Codec::frame(base + at, std::min(GK_SNAPSHOT_BLOCK, data.length() - at), packed);
+		}
+		data.swap(packed);
+		base = &data[0];
+	}
+
+	uv_fs_t open_req;
+	uv_fs_open(uv_default_loop(), &open_req, file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR, NULL);
+	auto fd = open_req.result;
+	uv_fs_req_cleanup(&open_req);
+	if (0 > fd) {
+		return "[GraphKit Error: Cannot open file " + file + ".]";
+	}
+	std::string error;
+	std::size_t written = 0;
+	while (written < data.length()) {
+		uv_buf_t iov = uv_buf_init(base + written, data.length() - written);
+		uv_fs_t write_req;
+		uv_fs_write(uv_default_loop(), &write_req, fd, &iov, 1, -1, NULL);
+		auto n = write_req.result;
+		uv_fs_req_cleanup(&write_req);
+		if (0 >= n) {
+			error = "[GraphKit Error: Cannot write file " + file + ".]";
+			break;
+		}
+		written += n;
+	}
+	if (error.empty()) {
+		uv_fs_t sync_req;
+		if (0 > uv_fs_fdatasync(uv_default_loop(), &sync_req, fd, NULL)) {
+			error = "[GraphKit Error: Cannot sync file " + file + ".]";
+		}
+		uv_fs_req_cleanup(&sync_req);
+	}
+	uv_fs_t close_req;
+	uv_fs_close(uv_default_loop(), &close_req, fd, NULL);
+	uv_fs_req_cleanup(&close_req);
+	return error;
+}
+
+bool gk::Snapshot::load(v8::Isolate* isolate, gk::Coordinator* coordinator, const std::string& file) noexcept {
+	uv_fs_t open_req;
+	uv_fs_open(uv_default_loop(), &open_req, file.c_str(), O_RDONLY, 0, NULL);
+	auto fd = open_req.result;
+	uv_fs_req_cleanup(&open_req);
+	if (0 > fd) {
+		return false;
+	}
+	uv_fs_t stat_req;
+	uv_fs_fstat(uv_default_loop(), &stat_req, fd, NULL);
+	auto size = stat_req.statbuf.st_size;
+	uv_fs_req_cleanup(&stat_req);
+	void* map = sizeof(Header) <= size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	uv_fs_t close_req;
+	uv_fs_close(uv_default_loop(), &close_req, fd, NULL);
+	uv_fs_req_cleanup(&close_req);
+	if (MAP_FAILED == map) {
+		return false;
+	}
+
+	// a packed image is unpacked into memory, a plain one is used in place
+	auto base = static_cast<const char*>(map);
+	std::string unpacked;
+	if (0 == memcmp(base, GK_SNAPSHOT_PACKED, sizeof(GK_SNAPSHOT_PACKED))) {
+		auto ok = unpack(base, size, unpacked);
+		munmap(map, size);
+		map = MAP_FAILED;
+		if (!ok || sizeof(Header) > unpacked.size()) {
+			return false;
+		}
+		base = unpacked.data();
+		size = unpacked.size();
+	}
+
+	// every section must lie within the file
+	Header h;
+	memcpy(&h, base, sizeof(Header));
+	auto valid = 0 == memcmp(h.magic, GK_SNAPSHOT_MAGIC, sizeof(h.magic)) &&
+		GK_SNAPSHOT_VERSION == h.version &&
+		h.size == size &&
+		h.stringOffsets <= h.stringData && h.stringData <= size &&
+		(static_cast<uint64_t>(h.strings) + 1) * sizeof(uint64_t) <= h.stringData - h.stringOffsets &&
+		h.nodeOffset <= size && h.nodes <= (size - h.nodeOffset) / sizeof(Record) &&
+		h.propertyOffset <= size && h.properties <= (size - h.propertyOffset) / (2 * sizeof(uint32_t)) &&
+		h.groupOffset <= size && h.groups <= (size - h.groupOffset) / sizeof(uint32_t) &&
+		h.edgeOffset <= size && h.edges <= (size - h.edgeOffset) / sizeof(uint32_t);
+	auto offsets = reinterpret_cast<const uint64_t*>(base + h.stringOffsets);
+	valid = valid && h.stringData <= h.nodeOffset && offsets[h.strings] <= h.nodeOffset - h.stringData;
+	for (uint32_t i = 0; valid && i < h.strings; ++i) {
+		valid = offsets[i] < offsets[i + 1] && '\0' == base[h.stringData + offsets[i + 1] - 1];
+	}
+	if (!valid) {
+		if (MAP_FAILED != map) {
+			munmap(map, size);
+		}
+		return false;
+	}
+
+	auto strings = base + h.stringData;
+	auto string = [&](uint32_t id) -> const char* {
+		return id < h.strings ? strings + offsets[id] : "";
+	};
+	auto records = reinterpret_cast<const Record*>(base + h.nodeOffset);
+	auto properties = reinterpret_cast<const uint32_t*>(base + h.propertyOffset);
+	auto groups = reinterpret_cast<const uint32_t*>(base + h.groupOffset);
+	auto edges = reinterpret_cast<const uint32_t*>(base + h.edgeOffset);
+
+	// Nodes first, then every relationship in one pass
+	std::vector<gk::Node*> nodes(h.nodes, nullptr);
+	for (uint64_t i = 0; i < h.nodes; ++i) {
+		v8::HandleScope scope(isolate);
+		auto& r = records[i];
+		gk::Node* node = nullptr;
+		auto nodeClass = gk::NodeClassFromInt(r.nodeClass);
+		if (gk::NodeClass::Entity == nodeClass) {
+			node = gk::Entity::Instance(isolate, string(r.type));
+		} else if (gk::NodeClass::Action == nodeClass) {
+			node = gk::Action<gk::Entity>::Instance(isolate, string(r.type));
+		} else if (gk::NodeClass::Bond == nodeClass) {
+			node = gk::Bond<gk::Entity>::Instance(isolate, string(r.type));
+		} else {
+			continue;
+		}
+		node->id(r.id);
+		node->indexed(true);
+		if (0 <= r.rank) {
+			node->rank(r.rank);
+		}
+		coordinator->insertNode(isolate, node);
+		nodes[i] = node;
+
+		for (auto g = r.groups; g < r.groups + r.groupCount && g < h.groups; ++g) {
+			std::string* v = new std::string{string(groups[g])};
+			if (node->groups()->insert(*v, v)) {
+				coordinator->insertGroup(isolate, *v, node);
+			} else {
+				delete v;
+			}
+		}
+		for (auto p = r.properties; p < r.properties + r.propertyCount && p < h.properties; ++p) {
+			node->properties()->insert(string(properties[2 * p]), new std::string{string(properties[2 * p + 1])});
+		}
+		node->modified();
+	}
+
+	auto target = [&](uint64_t e) -> gk::Entity* {
+		if (e >= h.edges || edges[e] >= h.nodes) {
+			return nullptr;
+		}
+		return dynamic_cast<gk::Entity*>(nodes[edges[e]]);
+	};
+	for (uint64_t i = 0; i < h.nodes; ++i) {
+		auto& r = records[i];
+		if (nullptr == nodes[i] || 0 == r.subjectCount + r.objectCount) {
+			continue;
+		}
+		v8::HandleScope scope(isolate);
+		auto action = dynamic_cast<gk::Action<gk::Entity>*>(nodes[i]);
+		auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(nodes[i]);
+		for (uint64_t e = 0; e < r.subjectCount + r.objectCount; ++e) {
+			auto t = target(r.edges + e);
+			if (nullptr == t) {
+				continue;
+			}
+			auto subject = e < r.subjectCount;
+			if (action && subject) {
+				action->addSubject(isolate, t);
+			} else if (action) {
+				action->addObject(isolate, t);
+			} else if (bond && subject) {
+				bond->subject(isolate, t);
+			} else if (bond) {
+				bond->object(isolate, t);
+			}
+		}
+	}
+
+	if (MAP_FAILED != map) {
+		munmap(map, size);
+	}
+	return true;
+}
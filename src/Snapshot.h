@@ -0,0 +1,157 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Snapshot.h
+*
+* A binary image of the Graph that is mapped into memory and loaded without
+* parsing. The file holds a header, a string table, one fixed width record
+* per Node and flat arrays of properties, groups and relationships, each
+* section 8 byte aligned and in native byte order. Relationships are stored
+* as Node positions, so they resolve in a single pass whatever the order.
+* A packed image is written as compressed, checksummed blocks instead and
+* unpacked into memory when it is loaded.
+*/
+
+#ifndef GRAPHKIT_SRC_SNAPSHOT_H
+#define GRAPHKIT_SRC_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "exports.h"
+#include "Node.h"
+
+namespace gk {
+	class Coordinator;
+
+	class Snapshot {
+	public:
+
+		/**
+		* Snapshot
+		* Constructor.
+		*/
+		Snapshot() noexcept;
+
+		/**
+		* ~Snapshot
+		* Destructor.
+		*/
+		virtual ~Snapshot();
+
+		// defaults
+		Snapshot(const Snapshot&) = default;
+		Snapshot& operator= (const Snapshot&) = default;
+		Snapshot(Snapshot&&) = default;
+		Snapshot& operator= (Snapshot&&) = default;
+
+		/**
+		* add
+		* Copies a Node into the image, must be called on the v8 thread.
+		* Relationships to Nodes that are never added are dropped.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Node* node
+		*/
+		void add(v8::Isolate* isolate, gk::Node* node) noexcept;
+
+		/**
+		* count
+		* The number of Nodes added.
+		* @return		std::size_t
+		*/
+		std::size_t count() const noexcept;
+
+		/**
+		* seal
+		* Resolves the relationships to Node positions once the last Node is
+		* added, must be called on the v8 thread while every added Node is
+		* alive. The Nodes are not used afterwards.
+		*/
+		void seal() noexcept;
+
+		/**
+		* write
+		* Writes and syncs a sealed image, on any thread.
+		* @param		const std::string& file
+		* @param		bool compress, packs the image in blocks
+		* @return		std::string, the error message or empty
+		*/
+		std::string write(const std::string& file, bool compress = false) const noexcept;
+
+		/**
+		* load
+		* Maps an image and inserts its Nodes into the Graph.
+		* @param		v8::Isolate* isolate
+		* @param		gk::Coordinator* coordinator
+		* @param		const std::string& file
+		* @return		bool, false if the file is not a valid image
+		*/
+		static bool load(v8::Isolate* isolate, gk::Coordinator* coordinator, const std::string& file) noexcept;
+
+	protected:
+		struct Header {
+			char magic[8];
+			uint32_t version;
+			uint32_t strings;
+			uint64_t nodes;
+			uint64_t properties;
+			uint64_t groups;
+			uint64_t edges;
+			uint64_t stringOffsets;
+			uint64_t stringData;
+			uint64_t nodeOffset;
+			uint64_t propertyOffset;
+			uint64_t groupOffset;
+			uint64_t edgeOffset;
+			uint64_t size;
+		};
+
+		struct Record {
+			int64_t id;
+			int64_t rank;
+			uint64_t properties;
+			uint64_t groups;
+			uint64_t edges;
+			uint32_t type;
+			uint32_t propertyCount;
+			uint32_t groupCount;
+			uint32_t subjectCount;
+			uint32_t objectCount;
+			uint32_t nodeClass;
+		};
+
+		std::vector<std::string> strings_;
+		std::unordered_map<std::string, uint32_t> ids_;
+		std::vector<Record> nodes_;
+		std::vector<uint32_t> properties_;
+		std::vector<uint32_t> groups_;
+		std::vector<gk::Node*> edges_;
+		std::vector<uint32_t> targets_;
+		std::unordered_map<gk::Node*, uint32_t> positions_;
+
+		/**
+		* intern
+		* The id of a string in the string table.
+		* @param		const std::string& s
+		* @return		uint32_t
+		*/
+		uint32_t intern(const std::string& s) noexcept;
+	};
+}
+
+#endif
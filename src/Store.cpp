@@ -0,0 +1,1078 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include "Store.h"
+#include "symbols.h"
+#include "Scheduler.h"
+#include "Pool.h"
+
+// Nodes serialised per loop iteration while a checkpoint is written
+static const std::size_t GK_STORE_CHECKPOINT_CHUNK = 4096;
+
+// smaller batches are written plain, the frame would outweigh the savings
+static const std::size_t GK_STORE_FRAME_MIN = 256;
+
+// inserts encoded on the Scheduler once a flush has this many, handed out this many at a time
+static const std::size_t GK_STORE_ENCODE_MIN = 2048;
+static const std::size_t GK_STORE_ENCODE_CHUNK = 256;
+
+gk::Store::Store(const std::string& dir) noexcept
+	: dir_{dir},
+	  options_{},
+	  pending_{},
+	  spare_{},
+	  encoder_{},
+	  workers_{},
+	  pieces_{},
+	  records_{0},
+	  inserts_{},
+	  deferred_{},
+	  queue_{},
+	  waiters_{},
+	  queued_{0},
+	  written_{0},
+	  writing_{false},
+	  applying_{false},
+	  ringing_{false},
+	  closed_{false},
+	  closing_{false},
+	  suspended_{false},
+	  segment_{0},
+	  size_{0},
+	  logged_{0},
+	  fd_{-1},
+	  timer_{new uv_timer_t},
+	  clock_{new uv_timer_t},
+	  idler_{new uv_idle_t},
+	  ticker_{new uv_check_t},
+	  waker_{new uv_idle_t},
+	  poller_{nullptr},
+	  ring_{nullptr},
+	  dirty_{},
+	  changes_{},
+	  undo_{},
+	  marks_{},
+	  reverting_{false},
+	  image_{nullptr},
+	  collect_{},
+	  mutex_{},
+	  idle_{} {
+	uv_timer_init(uv_default_loop(), timer_);
+	timer_->data = this;
+	uv_timer_init(uv_default_loop(), clock_);
+	clock_->data = this;
+	uv_idle_init(uv_default_loop(), idler_);
+	idler_->data = this;
+	uv_check_init(uv_default_loop(), ticker_);
+	ticker_->data = this;
+	uv_idle_init(uv_default_loop(), waker_);
+	options(options_);
+}
+
+gk::Store::~Store() {
+	close();
+	uv_close(reinterpret_cast<uv_handle_t*>(timer_), [](uv_handle_t* handle) {
+		delete reinterpret_cast<uv_timer_t*>(handle);
+	});
+	uv_close(reinterpret_cast<uv_handle_t*>(clock_), [](uv_handle_t* handle) {
+		delete reinterpret_cast<uv_timer_t*>(handle);
+	});
+	uv_close(reinterpret_cast<uv_handle_t*>(idler_), [](uv_handle_t* handle) {
+		delete reinterpret_cast<uv_idle_t*>(handle);
+	});
+	uv_close(reinterpret_cast<uv_handle_t*>(ticker_), [](uv_handle_t* handle) {
+		delete reinterpret_cast<uv_check_t*>(handle);
+	});
+	uv_close(reinterpret_cast<uv_handle_t*>(waker_), [](uv_handle_t* handle) {
+		delete reinterpret_cast<uv_idle_t*>(handle);
+	});
+	if (poller_) {
+		uv_close(reinterpret_cast<uv_handle_t*>(poller_), [](uv_handle_t* handle) {
+			delete reinterpret_cast<uv_poll_t*>(handle);
+		});
+	}
+	delete ring_;
+}
+
+gk::Store::Stats gk::Store::stats() const noexcept {
+	return {options_.durability, nullptr != ring_ && options_.ring, records_, queued_, written_, logged_, segment_};
+}
+
+const gk::Store::Options& gk::Store::options() const noexcept {
+	return options_;
+}
+
+void gk::Store::options(const Options& options) noexcept {
+	options_ = options;
+
+	// periodic checkpoints never keep the process alive
+	uv_timer_stop(clock_);
+	if (0 < options_.interval) {
+		uv_timer_start(clock_, [](uv_timer_t* timer) {
+			auto store = static_cast<gk::Store*>(timer->data);
+			if (0 < store->logged_) {
+				store->checkpoint();
+			}
+		}, options_.interval, options_.interval);
+		uv_unref(reinterpret_cast<uv_handle_t*>(clock_));
+	}
+}
+
+std::string gk::Store::path(long long segment, const char* ext) const noexcept {
+	char name[32];
+	snprintf(name, sizeof(name), "%010lld", segment);
+	return dir_ + "/" + name + ext;
+}
+
+std::vector<long long> gk::Store::files(const char* ext) const noexcept {
+	std::vector<long long> numbers;
+	uv_fs_t scandir_req;
+	uv_fs_scandir(uv_default_loop(), &scandir_req, dir_.c_str(), 0, NULL);
+	uv_dirent_t dent;
+	std::string e{ext};
+	while (0 == uv_fs_scandir_next(&scandir_req, &dent)) {
+		std::string name{dent.name};
+		if (e.length() < name.length() && 0 == name.compare(name.length() - e.length(), e.length(), e)) {
+			numbers.push_back(atoll(name.c_str()));
+		}
+	}
+	uv_fs_req_cleanup(&scandir_req);
+	std::sort(numbers.begin(), numbers.end());
+	return numbers;
+}
+
+void gk::Store::record(Mutation mutation, gk::Node* node, const std::string& key, const std::string& value) noexcept {
+	// a removed Node is no longer indexed when its removal is recorded
+	if (suspended_ || closed_ || Durability::None == options_.durability || (Mutation::Remove != mutation && !node->indexed()) || fold(mutation, node)) {
+		return;
+	}
+	if (options_.coalesce && Durability::Strict != options_.durability && (Mutation::Set == mutation || Mutation::Delete == mutation)) {
+		coalesce(mutation, node, key, value);
+		return;
+	}
+	if (Mutation::Remove == mutation && node->dirty()) {
+		// the Node may be released once removed, its held changes no longer matter
+		node->dirty(false);
+		changes_.erase(node);
+	}
+	if (Mutation::Insert == mutation) {
+		// encoded when flushed, an indexed Node stays alive until its removal is recorded
+		deferred_[node] = inserts_.size();
+		inserts_.emplace_back(pending_.size(), node);
+		buffered();
+		return;
+	}
+	encoder_.record(pending_, mutation, node, key, value);
+	buffered();
+}
+
+void gk::Store::record(Mutation mutation, gk::Node* node, gk::Node* target) noexcept {
+	if (suspended_ || closed_ || Durability::None == options_.durability || !node->indexed() || fold(mutation, node)) {
+		return;
+	}
+	encoder_.record(pending_, mutation, node, target);
+	buffered();
+}
+
+void gk::Store::drop(const gk::NodeClass& nodeClass, const std::string& type) noexcept {
+	// the dropped Nodes are released without recording their removal, nothing may refer to them
+	auto dropped = [&](gk::Node* node) {
+		return nodeClass == node->nodeClass() && type == node->type();
+	};
+	for (auto it = deferred_.begin(); deferred_.end() != it;) {
+		if (dropped(it->first)) {
+			inserts_[it->second].second = nullptr;
+			it = deferred_.erase(it);
+		} else {
+			++it;
+		}
+	}
+	for (auto it = changes_.begin(); changes_.end() != it;) {
+		if (dropped(it->first)) {
+			it->first->dirty(false);
+			it = changes_.erase(it);
+		} else {
+			++it;
+		}
+	}
+	if (suspended_ || closed_ || Durability::None == options_.durability) {
+		return;
+	}
+	encoder_.drop(pending_, nodeClass, type);
+	buffered();
+}
+
+bool gk::Store::fold(Mutation mutation, gk::Node* node) noexcept {
+	if (deferred_.empty()) {
+		return false;
+	}
+	auto it = deferred_.find(node);
+	if (deferred_.end() == it) {
+		return false;
+	}
+	if (Mutation::Remove == mutation) {
+		inserts_[it->second].second = nullptr;
+		deferred_.erase(it);
+	}
+	return true;
+}
+
+void gk::Store::coalesce(Mutation mutation, gk::Node* node, const std::string& key, const std::string& value) noexcept {
+	if (!node->dirty()) {
+		node->dirty(true);
+		dirty_.push_back(node);
+		if (1 == dirty_.size()) {
+			// the idle handle keeps the loop from blocking in poll before the check runs
+			uv_check_start(ticker_, [](uv_check_t* ticker) {
+				static_cast<gk::Store*>(ticker->data)->drain();
+			});
+			uv_idle_start(waker_, [](uv_idle_t* waker) {});
+		}
+	}
+	changes_[node][key] = {Mutation::Set == mutation, value};
+}
+
+void gk::Store::drain() noexcept {
+	uv_check_stop(ticker_);
+	uv_idle_stop(waker_);
+	std::vector<gk::Node*> dirty;
+	dirty.swap(dirty_);
+	for (auto node : dirty) {
+		// a Node removed in the meantime left the map and may be gone
+		auto it = changes_.find(node);
+		if (changes_.end() == it) {
+			continue;
+		}
+		node->dirty(false);
+		encoder_.update(pending_, node, it->second);
+		changes_.erase(it);
+		buffered();
+	}
+}
+
+void gk::Store::buffered() noexcept {
+	// a batch is written when it commits
+	if (!marks_.empty()) {
+		return;
+	}
+	if (options_.batch <= ++records_ || Durability::Strict == options_.durability) {
+		flush();
+	} else if (1 == records_) {
+		uv_timer_start(timer_, [](uv_timer_t* timer) {
+			static_cast<gk::Store*>(timer->data)->flush();
+		}, options_.delay, 0);
+	}
+}
+
+void gk::Store::suspend(bool suspended) noexcept {
+	suspended_ = suspended;
+}
+
+void gk::Store::begin() noexcept {
+	// earlier changes are written on their own, the batch starts with an empty buffer
+	if (marks_.empty()) {
+		flush();
+	}
+	marks_.push_back(undo_.size());
+}
+
+void gk::Store::commit() noexcept {
+	if (1 < marks_.size()) {
+		marks_.pop_back();
+		return;
+	}
+	if (marks_.empty()) {
+		return;
+	}
+	if (!dirty_.empty()) {
+		drain();
+	}
+	marks_.clear();
+	release(0);
+	uv_timer_stop(timer_);
+	records_ = 0;
+
+	// a single record, a torn write drops the whole batch on replay
+	write(take(true));
+}
+
+void gk::Store::rollback() noexcept {
+	if (marks_.empty()) {
+		return;
+	}
+	auto mark = marks_.back();
+	marks_.pop_back();
+	if (!marks_.empty()) {
+		// the inverse changes are recorded and stay in the outer batch
+		revert(mark);
+		return;
+	}
+
+	// nothing was written yet, the records are dropped and the inverse changes not recorded
+	for (auto node : dirty_) {
+		if (changes_.end() != changes_.find(node)) {
+			node->dirty(false);
+		}
+	}
+	dirty_.clear();
+	changes_.clear();
+	uv_check_stop(ticker_);
+	uv_idle_stop(waker_);
+	pending_.clear();
+	inserts_.clear();
+	deferred_.clear();
+	encoder_.reset();
+	records_ = 0;
+	auto suspended = suspended_;
+	suspended_ = true;
+	revert(0);
+	suspended_ = suspended;
+}
+
+bool gk::Store::batching() const noexcept {
+	return !marks_.empty() && !reverting_;
+}
+
+void gk::Store::journal(gk::Node* node, gk::Node* held, std::function<void()>&& revert) noexcept {
+	node->Ref();
+	if (nullptr != held) {
+		held->Ref();
+	}
+	undo_.push_back({node, held, std::move(revert)});
+}
+
+void gk::Store::revert(std::size_t mark) noexcept {
+	reverting_ = true;
+	for (auto i = undo_.size(); mark < i; --i) {
+		undo_[i - 1].revert();
+	}
+	reverting_ = false;
+	release(mark);
+}
+
+void gk::Store::release(std::size_t mark) noexcept {
+	for (auto i = undo_.size(); mark < i; --i) {
+		auto& undo = undo_[i - 1];
+		if (nullptr != undo.held) {
+			undo.held->Unref();
+		}
+		undo.node->Unref();
+	}
+	undo_.resize(mark);
+}
+
+void gk::Store::replay(const std::function<bool(const std::string&)>& restore, const std::function<void(const std::string&)>& apply) noexcept {
+	// the latest checkpoint, then the segments written after it
+	auto checkpoints = files(GK_FS_CHECKPOINT_EXT);
+	if (!checkpoints.empty()) {
+		segment_ = checkpoints.back();
+		auto file = path(segment_, GK_FS_CHECKPOINT_EXT);
+		if (!restore(file)) {
+			apply(file);
+		}
+	}
+	auto covered = segment_;
+	for (auto segment : files(GK_FS_LOG_EXT)) {
+		if (covered < segment) {
+			apply(path(segment));
+			segment_ = segment;
+		}
+	}
+}
+
+std::vector<std::string> gk::Store::segments() const noexcept {
+	std::vector<std::string> paths;
+	for (auto segment : files(GK_FS_LOG_EXT)) {
+		paths.push_back(path(segment));
+	}
+	return paths;
+}
+
+void gk::Store::flush() noexcept {
+	if (!marks_.empty()) {
+		return;
+	}
+	if (!dirty_.empty()) {
+		drain();
+	}
+	uv_timer_stop(timer_);
+	records_ = 0;
+	write(take());
+}
+
+std::string gk::Store::take(bool batch) noexcept {
+	encode();
+	if (pending_.empty() && pieces_.empty()) {
+		inserts_.clear();
+		deferred_.clear();
+		encoder_.reset();
+		return std::string{};
+	}
+
+	// the buffer of an earlier batch is reused
+	std::string data;
+	data.swap(spare_);
+	data.clear();
+	encoder_.table(data);
+	auto at = batch ? encoder_.open(data, Mutation::Batch) : 0;
+	std::size_t first = 0;
+	for (std::size_t i = 0; i < inserts_.size(); ++i) {
+		data.append(pending_, first, inserts_[i].first - first);
+		first = inserts_[i].first;
+		if (!pieces_.empty()) {
+			auto& piece = pieces_[i];
+			data.append(workers_[piece.worker]->buffer, piece.begin, piece.end - piece.begin);
+		}
+	}
+	data.append(pending_, first, std::string::npos);
+	if (batch) {
+		encoder_.close(data, at);
+	}
+	pending_.clear();
+	inserts_.clear();
+	pieces_.clear();
+	deferred_.clear();
+	return data;
+}
+
+void gk::Store::encode() noexcept {
+	// the buffered inserts are encoded with the current state of their Nodes, before the table of the symbols they use
+	pieces_.clear();
+	std::size_t live = 0;
+	for (auto& insert : inserts_) {
+		live += nullptr != insert.second;
+	}
+	if (0 == live) {
+		return;
+	}
+	pieces_.resize(inserts_.size());
+
+	// touching Nodes in the Pool is not thread safe, and small flushes are not worth the handoff
+	auto& scheduler = gk::Scheduler::instance();
+	auto threads = GK_STORE_ENCODE_MIN > live || gk::Pool::enabled() ? 1u : std::max(1u, scheduler.threads());
+	while (workers_.size() < threads) {
+		workers_.emplace_back(new Worker{&encoder_});
+	}
+	for (std::size_t w = 0; w < threads; ++w) {
+		workers_[w]->buffer.clear();
+	}
+	if (1 == threads) {
+		auto& buffer = workers_[0]->buffer;
+		for (std::size_t i = 0; i < inserts_.size(); ++i) {
+			auto begin = buffer.size();
+			if (nullptr != inserts_[i].second) {
+				encoder_.insert(buffer, inserts_[i].second);
+			}
+			pieces_[i] = Piece{0, begin, buffer.size()};
+		}
+		return;
+	}
+
+	// the loop thread waits, so the Nodes stay as they are while the workers read them
+	std::atomic<std::size_t> slot{0};
+	std::atomic<std::size_t> next{0};
+	scheduler.parallel(threads, [&]() {
+		auto w = slot++;
+		auto& worker = *workers_[w];
+		for (auto c = next.fetch_add(GK_STORE_ENCODE_CHUNK); c < inserts_.size(); c = next.fetch_add(GK_STORE_ENCODE_CHUNK)) {
+			auto last = std::min(inserts_.size(), c + GK_STORE_ENCODE_CHUNK);
+			for (auto i = c; i < last; ++i) {
+				auto begin = worker.buffer.size();
+				if (nullptr != inserts_[i].second) {
+					worker.encoder.insert(worker.buffer, inserts_[i].second);
+				}
+				pieces_[i] = Piece{w, begin, worker.buffer.size()};
+			}
+		}
+	});
+}
+
+void gk::Store::write(std::string&& data) noexcept {
+	if (data.empty()) {
+		return;
+	}
+
+	auto batch = new Batch{};
+	batch->req.data = batch;
+	batch->store = this;
+	batch->sequence = ++queued_;
+	batch->segment = options_.segment;
+	if (options_.compress && GK_STORE_FRAME_MIN <= data.length() && gk::Codec::frame(data.data(), data.length(), batch->data)) {
+		spare_.swap(data);
+	} else {
+		batch->data.swap(data);
+	}
+	queue_.push_back(batch);
+	if (Durability::Strict == options_.durability) {
+		settle();
+		return;
+	}
+	pump();
+}
+
+void gk::Store::settle() noexcept {
+	if (closed_) {
+		return;
+	}
+
+	// the batch in flight goes first, its completion may still be pending
+	while (ringing_ && 0 <= ring_->submit(1)) {
+		reap(true);
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		idle_.wait(lock, [&]() {
+			return !applying_;
+		});
+	}
+	std::deque<Batch*> queue;
+	queue.swap(queue_);
+	for (auto batch : queue) {
+		apply(batch);
+	}
+	for (auto batch : queue) {
+		complete(batch);
+	}
+	if (0 < options_.checkpoint && options_.checkpoint <= logged_) {
+		checkpoint();
+	}
+}
+
+void gk::Store::flush(v8::Isolate* isolate, v8::Local<v8::Promise::Resolver> resolver) noexcept {
+	flush();
+	if (written_ == queued_) {
+		resolver->Resolve(GK_UNDEFINED());
+		return;
+	}
+	auto persistent = new v8::Persistent<v8::Promise::Resolver>{isolate, resolver};
+	waiters_.push_back({queued_, "", persistent});
+}
+
+void gk::Store::pump() noexcept {
+	if (writing_ || closed_ || queue_.empty()) {
+		return;
+	}
+	writing_ = true;
+	auto batch = queue_.front();
+	queue_.pop_front();
+	// the batch may complete after the Graph let go of the Store
+	batch->hold = shared_from_this();
+	if (uring()) {
+		submit(batch);
+		return;
+	}
+	applying_ = true;
+	uv_queue_work(uv_default_loop(), &batch->req, [](uv_work_t* req) {
+		auto batch = static_cast<Batch*>(req->data);
+		batch->store->apply(batch);
+		std::lock_guard<std::mutex> lock(batch->store->mutex_);
+		batch->store->applying_ = false;
+		batch->store->idle_.notify_all();
+	}, [](uv_work_t* req, int status) {
+		auto batch = static_cast<Batch*>(req->data);
+		auto store = std::move(batch->hold);
+		store->written(batch);
+	});
+}
+
+bool gk::Store::uring() noexcept {
+	if (!options_.ring) {
+		return false;
+	}
+	if (nullptr == ring_ && gk::Ring::supported()) {
+		// completions wake the loop through the eventfd of the ring
+		auto ring = new gk::Ring{};
+		auto event = ring->notifier();
+		if (!ring->valid() || 0 > event) {
+			delete ring;
+			options_.ring = false;
+			return false;
+		}
+		poller_ = new uv_poll_t;
+		uv_poll_init(uv_default_loop(), poller_, event);
+		poller_->data = this;
+		ring_ = ring;
+	}
+	return nullptr != ring_;
+}
+
+void gk::Store::submit(Batch* batch) noexcept {
+	ringing_ = true;
+	auto data = reinterpret_cast<uint64_t>(batch);
+	if (!open(batch) || batch->roll) {
+		// completed through the ring as well, so never from inside the caller
+		batch->inflight = 1;
+		ring_->prepare(gk::Ring::Op::Nop, -1, nullptr, 0, 0, data);
+	} else {
+		// the sync is linked to the write, a short write cancels it and the rest is submitted again
+		auto sync = Durability::Async != options_.durability;
+		batch->inflight = sync ? 2 : 1;
+		ring_->prepare(gk::Ring::Op::Write, fd_, &batch->data[batch->done], batch->data.length() - batch->done, size_, data, sync);
+		if (sync) {
+			ring_->prepare(gk::Ring::Op::DataSync, fd_, nullptr, 0, 0, data | 1);
+		}
+	}
+	ring_->submit();
+	uv_poll_start(poller_, UV_READABLE, [](uv_poll_t* poller, int status, int events) {
+		auto store = static_cast<gk::Store*>(poller->data);
+		store->ring_->acknowledge();
+		store->reap(false);
+	});
+}
+
+void gk::Store::reap(bool nested) noexcept {
+	std::shared_ptr<gk::Store> store;
+	uint64_t data;
+	int result;
+	while (ring_->complete(data, result)) {
+		auto batch = reinterpret_cast<Batch*>(data & ~static_cast<uint64_t>(1));
+		--batch->inflight;
+		if (batch->roll || !batch->error.empty()) {
+		} else if (0 == (data & 1)) {
+			if (0 >= result) {
+				batch->error = "[GraphKit Error: Cannot write file " + path(segment_) + ".]";
+			} else {
+				batch->done += result;
+				size_ += result;
+			}
+		} else if (0 > result && -ECANCELED != result) {
+			batch->error = "[GraphKit Error: Cannot sync file " + path(segment_) + ".]";
+		}
+		if (0 < batch->inflight) {
+			continue;
+		}
+		if (!batch->roll && batch->error.empty() && batch->done < batch->data.length()) {
+			submit(batch);
+			continue;
+		}
+		if (!batch->roll && !batch->error.empty()) {
+			discard(batch);
+		}
+		ringing_ = false;
+		store = std::move(batch->hold);
+		if (nested) {
+			writing_ = false;
+			complete(batch);
+		} else {
+			written(batch);
+		}
+	}
+	if (!ringing_) {
+		uv_poll_stop(poller_);
+	}
+}
+
+bool gk::Store::open(Batch* batch) noexcept {
+	// a checkpoint covers every segment up to this one
+	if (batch->roll) {
+		batch->covered = segment_;
+		if (0 <= fd_) {
+			uv_fs_t close_req;
+			uv_fs_close(uv_default_loop(), &close_req, fd_, NULL);
+			uv_fs_req_cleanup(&close_req);
+			fd_ = -1;
+		}
+		return true;
+	}
+
+	// each process appends to a segment of its own
+	if (0 > fd_ || batch->segment <= size_) {
+		if (0 <= fd_) {
+			uv_fs_t close_req;
+			uv_fs_close(uv_default_loop(), &close_req, fd_, NULL);
+			uv_fs_req_cleanup(&close_req);
+		}
+		uv_fs_t open_req;
+		uv_fs_open(uv_default_loop(), &open_req, path(++segment_).c_str(), O_CREAT | O_WRONLY | O_APPEND, S_IRUSR | S_IWUSR, NULL);
+		fd_ = open_req.result;
+		size_ = 0;
+		uv_fs_req_cleanup(&open_req);
+		if (0 > fd_) {
+			batch->error = "[GraphKit Error: Cannot open file " + path(segment_) + ".]";
+			return false;
+		}
+	}
+	return true;
+}
+
+void gk::Store::apply(Batch* batch) noexcept {
+	if (!open(batch) || batch->roll) {
+		return;
+	}
+
+	// group commit, one write and one sync for the whole batch
+	while (batch->done < batch->data.length()) {
+		uv_buf_t iov = uv_buf_init(const_cast<char*>(batch->data.data()) + batch->done, batch->data.length() - batch->done);
+		uv_fs_t write_req;
+		uv_fs_write(uv_default_loop(), &write_req, fd_, &iov, 1, -1, NULL);
+		auto n = write_req.result;
+		uv_fs_req_cleanup(&write_req);
+		if (0 >= n) {
+			batch->error = "[GraphKit Error: Cannot write file " + path(segment_) + ".]";
+			discard(batch);
+			return;
+		}
+		batch->done += n;
+		size_ += n;
+	}
+
+	// async durability leaves the pages to the operating system
+	if (Durability::Async == options_.durability) {
+		return;
+	}
+	uv_fs_t sync_req;
+	if (0 > uv_fs_fdatasync(uv_default_loop(), &sync_req, fd_, NULL)) {
+		batch->error = "[GraphKit Error: Cannot sync file " + path(segment_) + ".]";
+		discard(batch);
+	}
+	uv_fs_req_cleanup(&sync_req);
+}
+
+void gk::Store::discard(Batch* batch) noexcept {
+	size_ -= batch->done;
+	batch->done = 0;
+	if (0 > fd_) {
+		return;
+	}
+	uv_fs_t truncate_req;
+	auto truncated = 0 <= uv_fs_ftruncate(uv_default_loop(), &truncate_req, fd_, size_, NULL);
+	uv_fs_req_cleanup(&truncate_req);
+	if (truncated) {
+		return;
+	}
+	uv_fs_t close_req;
+	uv_fs_close(uv_default_loop(), &close_req, fd_, NULL);
+	uv_fs_req_cleanup(&close_req);
+	fd_ = -1;
+}
+
+void gk::Store::written(Batch* batch) noexcept {
+	GK_SCOPE();
+	writing_ = false;
+	auto settled = complete(batch);
+	pump();
+	if (0 < options_.checkpoint && options_.checkpoint <= logged_) {
+		checkpoint();
+	}
+	if (settled) {
+		isolate->RunMicrotasks();
+	}
+}
+
+bool gk::Store::complete(Batch* batch) noexcept {
+	GK_SCOPE();
+	written_ = std::max(written_, batch->sequence);
+	if (!batch->roll) {
+		logged_ += batch->data.length();
+	} else if (image_) {
+		// later records go to newer segments, the image can be written
+		image_->segment = batch->covered;
+		uv_idle_start(idler_, [](uv_idle_t* idler) {
+			static_cast<gk::Store*>(idler->data)->image();
+		});
+	}
+
+	// settle the resolvers waiting on this batch, remembering failures for the others
+	std::vector<Waiter> waiting;
+	for (auto& waiter : waiters_) {
+		if (!batch->error.empty()) {
+			waiter.error = batch->error;
+		}
+		if (waiter.sequence > written_) {
+			waiting.push_back(waiter);
+			continue;
+		}
+		auto resolver = v8::Local<v8::Promise::Resolver>::New(isolate, *waiter.resolver);
+		if (waiter.error.empty()) {
+			resolver->Resolve(GK_UNDEFINED());
+		} else {
+			resolver->Reject(v8::Exception::Error(GK_STRING(waiter.error.c_str())));
+		}
+		waiter.resolver->Reset();
+		delete waiter.resolver;
+	}
+	auto settled = waiters_.size() != waiting.size();
+	waiters_.swap(waiting);
+	if (spare_.capacity() < batch->data.capacity()) {
+		spare_.swap(batch->data);
+	}
+	delete batch;
+	return settled;
+}
+
+void gk::Store::collector(const std::function<std::vector<gk::Node*>()>& collect) noexcept {
+	collect_ = collect;
+}
+
+void gk::Store::checkpoint() noexcept {
+	if (image_ || closed_ || closing_ || !collect_ || !marks_.empty() || Durability::None == options_.durability) {
+		return;
+	}
+	flush();
+
+	// the Nodes are listed now, anything inserted later is in a newer segment
+	image_ = new Image{};
+	image_->req.data = image_;
+	image_->store = this;
+	image_->hold = shared_from_this();
+	image_->segment = -1;
+	image_->nodes = collect_();
+	image_->next = 0;
+	image_->compress = options_.compress;
+	for (auto node : image_->nodes) {
+		node->Ref();
+	}
+	logged_ = 0;
+
+	// roll the log, the image starts once the older segments are closed
+	auto batch = new Batch{};
+	batch->req.data = batch;
+	batch->store = this;
+	batch->sequence = ++queued_;
+	batch->roll = true;
+	queue_.push_back(batch);
+	pump();
+}
+
+void gk::Store::checkpoint(v8::Isolate* isolate, v8::Local<v8::Promise::Resolver> resolver) noexcept {
+	checkpoint();
+	if (!image_) {
+		resolver->Resolve(GK_UNDEFINED());
+		return;
+	}
+	image_->resolvers.push_back(new v8::Persistent<v8::Promise::Resolver>{isolate, resolver});
+}
+
+std::string gk::Store::install(const std::string& file) noexcept {
+	// numbered after everything on disk, so it covers all of it
+	long long segment = 0;
+	auto segments = files(GK_FS_LOG_EXT);
+	auto checkpoints = files(GK_FS_CHECKPOINT_EXT);
+	if (!segments.empty()) {
+		segment = std::max(segment, segments.back());
+	}
+	if (!checkpoints.empty()) {
+		segment = std::max(segment, checkpoints.back());
+	}
+	++segment;
+
+	uv_fs_t mkdir_req;
+	uv_fs_mkdir(uv_default_loop(), &mkdir_req, dir_.c_str(), S_IRWXU, NULL);
+	uv_fs_req_cleanup(&mkdir_req);
+
+	auto tmp = path(segment, GK_FS_CHECKPOINT_EXT) + ".tmp";
+	uv_fs_t copy_req;
+	auto r = uv_fs_copyfile(uv_default_loop(), &copy_req, file.c_str(), tmp.c_str(), 0, NULL);
+	uv_fs_req_cleanup(&copy_req);
+	if (0 > r) {
+		return "[GraphKit Error: Cannot copy file " + file + ".]";
+	}
+	uv_fs_t open_req;
+	uv_fs_open(uv_default_loop(), &open_req, tmp.c_str(), O_RDONLY, 0, NULL);
+	auto fd = open_req.result;
+	uv_fs_req_cleanup(&open_req);
+	if (0 <= fd) {
+		uv_fs_t sync_req;
+		uv_fs_fsync(uv_default_loop(), &sync_req, fd, NULL);
+		uv_fs_req_cleanup(&sync_req);
+		uv_fs_t close_req;
+		uv_fs_close(uv_default_loop(), &close_req, fd, NULL);
+		uv_fs_req_cleanup(&close_req);
+	}
+	if (!publish(segment)) {
+		return "[GraphKit Error: Cannot install file " + file + ".]";
+	}
+	return "";
+}
+
+void gk::Store::image() noexcept {
+	GK_SCOPE();
+	auto image = image_;
+	auto last = std::min(image->nodes.size(), image->next + GK_STORE_CHECKPOINT_CHUNK);
+	for (; image->next < last; ++image->next) {
+		auto node = image->nodes[image->next];
+		if (node->indexed()) {
+			image->snapshot.add(isolate, node);
+		}
+	}
+	if (image->next < image->nodes.size()) {
+		return;
+	}
+
+	// the Nodes stay referenced until sealed, the Snapshot keys relationships by address
+	uv_idle_stop(idler_);
+	image->snapshot.seal();
+	for (auto node : image->nodes) {
+		node->Unref();
+	}
+	image->nodes.clear();
+	image->queued = true;
+	uv_queue_work(uv_default_loop(), &image->req, [](uv_work_t* req) {
+		auto image = static_cast<Image*>(req->data);
+		auto store = image->store;
+		image->error = image->snapshot.write(store->path(image->segment, GK_FS_CHECKPOINT_EXT) + ".tmp", image->compress);
+		if (image->error.empty() && !store->publish(image->segment)) {
+			image->error = "[GraphKit Error: Cannot install file " + store->path(image->segment, GK_FS_CHECKPOINT_EXT) + ".]";
+		}
+	}, [](uv_work_t* req, int status) {
+		static_cast<Image*>(req->data)->store->imaged();
+	});
+}
+
+void gk::Store::imaged() noexcept {
+	GK_SCOPE();
+	auto image = image_;
+	for (auto persistent : image->resolvers) {
+		auto resolver = v8::Local<v8::Promise::Resolver>::New(isolate, *persistent);
+		if (image->error.empty()) {
+			resolver->Resolve(GK_UNDEFINED());
+		} else {
+			resolver->Reject(v8::Exception::Error(GK_STRING(image->error.c_str())));
+		}
+		persistent->Reset();
+		delete persistent;
+	}
+	auto settled = !image->resolvers.empty();
+	auto store = std::move(image->hold);
+	image_ = nullptr;
+	delete image;
+	if (settled) {
+		isolate->RunMicrotasks();
+	}
+}
+
+bool gk::Store::publish(long long segment) const noexcept {
+	auto file = path(segment, GK_FS_CHECKPOINT_EXT);
+	uv_fs_t rename_req;
+	auto r = uv_fs_rename(uv_default_loop(), &rename_req, (file + ".tmp").c_str(), file.c_str(), NULL);
+	uv_fs_req_cleanup(&rename_req);
+	if (0 > r) {
+		return false;
+	}
+
+	// the rename must be durable before the covered files go
+	uv_fs_t open_req;
+	uv_fs_open(uv_default_loop(), &open_req, dir_.c_str(), O_RDONLY, 0, NULL);
+	auto fd = open_req.result;
+	uv_fs_req_cleanup(&open_req);
+	if (0 <= fd) {
+		uv_fs_t sync_req;
+		uv_fs_fsync(uv_default_loop(), &sync_req, fd, NULL);
+		uv_fs_req_cleanup(&sync_req);
+		uv_fs_t close_req;
+		uv_fs_close(uv_default_loop(), &close_req, fd, NULL);
+		uv_fs_req_cleanup(&close_req);
+	}
+
+	std::vector<std::string> covered;
+	for (auto s : files(GK_FS_LOG_EXT)) {
+		if (s <= segment) {
+			covered.push_back(path(s));
+		}
+	}
+	for (auto checkpoint : files(GK_FS_CHECKPOINT_EXT)) {
+		if (checkpoint < segment) {
+			covered.push_back(path(checkpoint, GK_FS_CHECKPOINT_EXT));
+		}
+	}
+
+	// Node files of the older format were loaded into the image too
+	uv_fs_t scandir_req;
+	uv_fs_scandir(uv_default_loop(), &scandir_req, dir_.c_str(), 0, NULL);
+	uv_dirent_t dent;
+	while (0 == uv_fs_scandir_next(&scandir_req, &dent)) {
+		std::string name{dent.name};
+		if (3 < name.length() && 0 == name.compare(name.length() - 3, 3, ".gk")) {
+			covered.push_back(dir_ + "/" + name);
+		}
+	}
+	uv_fs_req_cleanup(&scandir_req);
+
+	for (auto& f : covered) {
+		uv_fs_t unlink_req;
+		uv_fs_unlink(uv_default_loop(), &unlink_req, f.c_str(), NULL);
+		uv_fs_req_cleanup(&unlink_req);
+	}
+	return true;
+}
+
+void gk::Store::close() noexcept {
+	if (closed_) {
+		return;
+	}
+
+	// wait for the batch being written, then write the rest here
+	while (ringing_ && 0 <= ring_->submit(1)) {
+		reap(true);
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		idle_.wait(lock, [&]() {
+			return !applying_;
+		});
+	}
+	closed_ = true;
+	uv_idle_stop(idler_);
+	flush();
+	while (!queue_.empty()) {
+		auto batch = queue_.front();
+		queue_.pop_front();
+		apply(batch);
+		delete batch;
+	}
+	if (0 <= fd_) {
+		uv_fs_t close_req;
+		uv_fs_close(uv_default_loop(), &close_req, fd_, NULL);
+		uv_fs_req_cleanup(&close_req);
+		fd_ = -1;
+	}
+}
+
+void gk::Store::shutdown() noexcept {
+	GK_SCOPE();
+	if (closed_) {
+		return;
+	}
+
+	// the waiting resolvers are settled by writing the queue here
+	closing_ = true;
+	flush();
+	settle();
+	if (image_ && !image_->queued) {
+		uv_idle_stop(idler_);
+		for (auto node : image_->nodes) {
+			node->Unref();
+		}
+		for (auto persistent : image_->resolvers) {
+			auto resolver = v8::Local<v8::Promise::Resolver>::New(isolate, *persistent);
+			resolver->Reject(v8::Exception::Error(GK_STRING("[GraphKit Error: The Graph was closed before the checkpoint was written.]")));
+			persistent->Reset();
+			delete persistent;
+		}
+		delete image_;
+		image_ = nullptr;
+	}
+	close();
+	uv_timer_stop(clock_);
+}
@@ -0,0 +1,592 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Store.h
+*
+* Is responsible for the append only log of the changes made to Nodes, its
+* segments and the checkpoints that bound its replay.
+*/
+
+#ifndef GRAPHKIT_SRC_STORE_H
+#define GRAPHKIT_SRC_STORE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <uv.h>
+#include "exports.h"
+#include "Node.h"
+#include "Mutation.h"
+#include "Snapshot.h"
+#include "Ring.h"
+#include "Codec.h"
+#include "Encoder.h"
+
+namespace gk {
+	class Store : public std::enable_shared_from_this<gk::Store> {
+	public:
+
+		/**
+		* Durability
+		* When a logged change is safe on disk. None keeps the Graph in
+		* memory only, async writes batches without syncing them, group
+		* syncs every batch once and strict writes and syncs each change
+		* before returning.
+		*/
+		enum class Durability {
+			None,
+			Async,
+			Group,
+			Strict
+		};
+
+		/**
+		* Options
+		* batch is the number of records that triggers a group commit, delay
+		* the longest time in milliseconds a record waits before being written
+		* and segment the size in bytes after which a new segment is started.
+		* A checkpoint is taken after checkpoint bytes of log, or every
+		* interval milliseconds if anything was logged, 0 disables either.
+		* coalesce merges the property changes of a loop iteration, strict
+		* durability never coalesces. ring submits batches to io_uring when
+		* the kernel supports it. compress writes each batch of a useful size
+		* as one framed block, compressed and checksummed.
+		*/
+		struct Options {
+			std::size_t batch = 1024;
+			uint64_t delay = 10;
+			std::size_t segment = 64 << 20;
+			std::size_t checkpoint = 64 << 20;
+			uint64_t interval = 300000;
+			bool coalesce = true;
+			Durability durability = Durability::Group;
+			bool ring = true;
+			bool compress = false;
+		};
+
+		/**
+		* Stats
+		* The state of the log, buffered records, batches queued and written
+		* and the bytes logged since the last checkpoint.
+		*/
+		struct Stats {
+			Durability durability;
+			bool ring;
+			std::size_t buffered;
+			long long queued;
+			long long written;
+			std::size_t logged;
+			long long segment;
+		};
+
+		/**
+		* Store
+		* Explicit Constructor, logs to a data directory.
+		* @param		const std::string& dir
+		*/
+		explicit Store(const std::string& dir = "./" GK_FS_DB_DIR) noexcept;
+
+		/**
+		* ~Store
+		* Destructor.
+		*/
+		virtual ~Store();
+
+		// defaults
+		Store(const Store&) = delete;
+		Store& operator= (const Store&) = delete;
+		Store(Store&&) = delete;
+		Store& operator= (Store&&) = delete;
+
+		/**
+		* options
+		* The batching options.
+		* @return		const Options&
+		*/
+		const Options& options() const noexcept;
+
+		/**
+		* options
+		* Sets the batching options.
+		* @param		const Options& options
+		*/
+		void options(const Options& options) noexcept;
+
+		/**
+		* stats
+		* The current state of the log.
+		* @return		Stats
+		*/
+		Stats stats() const noexcept;
+
+		/**
+		* record
+		* Appends a mutation of a Node to the log. Inserts carry the whole
+		* Node, property and group changes carry a key and a value. Changes
+		* are logged as deltas, so their cost follows the size of the change
+		* rather than of the Node.
+		* @param		Mutation mutation
+		* @param		gk::Node* node
+		* @param		const std::string& key
+		* @param		const std::string& value
+		*/
+		void record(Mutation mutation, gk::Node* node, const std::string& key = "", const std::string& value = "") noexcept;
+
+		/**
+		* record
+		* Appends a mutation of a relationship between two Nodes to the log.
+		* @param		Mutation mutation
+		* @param		gk::Node* node
+		* @param		gk::Node* target
+		*/
+		void record(Mutation mutation, gk::Node* node, gk::Node* target) noexcept;
+
+		/**
+		* drop
+		* Appends the drop of every Node of a type to the log as a single
+		* record, the buffered changes of the type are discarded.
+		* @param		const gk::NodeClass& nodeClass
+		* @param		const std::string& type
+		*/
+		void drop(const gk::NodeClass& nodeClass, const std::string& type) noexcept;
+
+		/**
+		* begin
+		* Starts a batch, or a nested one inside the current batch.
+		*/
+		void begin() noexcept;
+
+		/**
+		* commit
+		* Ends a batch. The outermost one writes its records as a single
+		* record, so a torn write drops the whole batch.
+		*/
+		void commit() noexcept;
+
+		/**
+		* rollback
+		* Ends a batch undoing its changes. The outermost one drops its
+		* records, a nested one records the inverse changes instead.
+		*/
+		void rollback() noexcept;
+
+		/**
+		* batching
+		* Whether the changes made now belong to a batch.
+		* @return		bool
+		*/
+		bool batching() const noexcept;
+
+		/**
+		* journal
+		* Registers how to undo a change of the current batch. The Node and
+		* the held Node are kept alive until the batch ends.
+		* @param		gk::Node* node
+		* @param		gk::Node* held, may be nullptr
+		* @param		std::function<void()>&& revert
+		*/
+		void journal(gk::Node* node, gk::Node* held, std::function<void()>&& revert) noexcept;
+
+		/**
+		* collector
+		* Sets the function listing the Nodes written by a checkpoint, in
+		* the order they are loaded.
+		* @param		const std::function<std::vector<gk::Node*>()>& collect
+		*/
+		void collector(const std::function<std::vector<gk::Node*>()>& collect) noexcept;
+
+		/**
+		* checkpoint
+		* Starts a checkpoint unless one is running. It starts a new segment,
+		* copies the Nodes into a Snapshot a chunk per loop iteration and
+		* deletes the segments it covers once it is durable. Changes made in
+		* the meantime land in the newer segments and are replayed on top,
+		* which is safe as every record can be applied twice.
+		*/
+		void checkpoint() noexcept;
+
+		/**
+		* checkpoint
+		* Starts or joins a checkpoint and settles the resolver once the older
+		* segments are deleted, rejecting it if the checkpoint failed.
+		* @param		v8::Isolate* isolate
+		* @param		v8::Local<v8::Promise::Resolver> resolver
+		*/
+		void checkpoint(v8::Isolate* isolate, v8::Local<v8::Promise::Resolver> resolver) noexcept;
+
+		/**
+		* suspend
+		* Stops or resumes recording, used while the log is replayed.
+		* @param		bool suspended
+		*/
+		void suspend(bool suspended) noexcept;
+
+		/**
+		* replay
+		* Passes the latest checkpoint to restore, then the files of the
+		* newer segments in order to apply, which reads their records, the
+		* JSON lines of older segments included. A checkpoint restore rejects
+		* is passed to apply as a segment. Later records are written to a
+		* new segment.
+		* @param		const std::function<bool(const std::string&)>& restore
+		* @param		const std::function<void(const std::string&)>& apply
+		*/
+		void replay(const std::function<bool(const std::string&)>& restore, const std::function<void(const std::string&)>& apply) noexcept;
+
+		/**
+		* segments
+		* The files of the log segments, oldest first.
+		* @return		std::vector<std::string>
+		*/
+		std::vector<std::string> segments() const noexcept;
+
+		/**
+		* install
+		* Makes a Snapshot file the latest checkpoint and deletes everything
+		* older, must be called before the log is replayed.
+		* @param		const std::string& file
+		* @return		std::string, the error message or empty
+		*/
+		std::string install(const std::string& file) noexcept;
+
+		/**
+		* flush
+		* Moves the buffered records into a batch and starts writing it, with
+		* one write and one sync. Flushes happen once a batch fills up or the
+		* delay expires.
+		*/
+		void flush() noexcept;
+
+		/**
+		* flush
+		* Flushes, then settles the resolver once every queued batch is
+		* durable, rejecting it if any of them failed.
+		* @param		v8::Isolate* isolate
+		* @param		v8::Local<v8::Promise::Resolver> resolver
+		*/
+		void flush(v8::Isolate* isolate, v8::Local<v8::Promise::Resolver> resolver) noexcept;
+
+		/**
+		* close
+		* Writes everything still pending on the calling thread, used when
+		* the process exits.
+		*/
+		void close() noexcept;
+
+		/**
+		* shutdown
+		* Closes the log on the v8 thread, used when its Graph is closed. The
+		* waiting resolvers are settled and a checkpoint still copying Nodes
+		* is given up, one being written finishes in the background.
+		*/
+		void shutdown() noexcept;
+
+	protected:
+		struct Batch {
+			uv_work_t req;
+			gk::Store* store;
+			long long sequence;
+			std::size_t segment;
+			std::string data;
+			std::string error;
+			bool roll;
+			long long covered;
+			std::size_t done;
+			int inflight;
+			std::shared_ptr<gk::Store> hold;
+		};
+
+		struct Image {
+			uv_work_t req;
+			gk::Store* store;
+			long long segment;
+			std::vector<gk::Node*> nodes;
+			std::size_t next;
+			gk::Snapshot snapshot;
+			bool compress;
+			std::string error;
+			std::vector<v8::Persistent<v8::Promise::Resolver>*> resolvers;
+			bool queued;
+			std::shared_ptr<gk::Store> hold;
+		};
+
+		struct Waiter {
+			long long sequence;
+			std::string error;
+			v8::Persistent<v8::Promise::Resolver>* resolver;
+		};
+
+		struct Undo {
+			gk::Node* node;
+			gk::Node* held;
+			std::function<void()> revert;
+		};
+
+		struct Worker {
+			explicit Worker(gk::Encoder* shared) noexcept : encoder{shared}, buffer{} {}
+
+			gk::Encoder encoder;
+			std::string buffer;
+		};
+
+		struct Piece {
+			std::size_t worker;
+			std::size_t begin;
+			std::size_t end;
+		};
+
+		const std::string dir_;
+		Options options_;
+		std::string pending_;
+		std::string spare_;
+		gk::Encoder encoder_;
+		std::vector<std::unique_ptr<Worker>> workers_;
+		std::vector<Piece> pieces_;
+		std::size_t records_;
+		std::vector<std::pair<std::size_t, gk::Node*>> inserts_;
+		std::unordered_map<gk::Node*, std::size_t> deferred_;
+		std::deque<Batch*> queue_;
+		std::vector<Waiter> waiters_;
+		long long queued_;
+		long long written_;
+		bool writing_;
+		bool applying_;
+		bool ringing_;
+		bool closed_;
+		bool closing_;
+		bool suspended_;
+		long long segment_;
+		std::size_t size_;
+		std::size_t logged_;
+		uv_file fd_;
+		uv_timer_t* timer_;
+		uv_timer_t* clock_;
+		uv_idle_t* idler_;
+		uv_check_t* ticker_;
+		uv_idle_t* waker_;
+		uv_poll_t* poller_;
+		gk::Ring* ring_;
+		std::vector<gk::Node*> dirty_;
+		std::unordered_map<gk::Node*, std::map<std::string, std::pair<bool, std::string>>> changes_;
+		std::vector<Undo> undo_;
+		std::vector<std::size_t> marks_;
+		bool reverting_;
+		Image* image_;
+		std::function<std::vector<gk::Node*>()> collect_;
+		std::mutex mutex_;
+		std::condition_variable idle_;
+
+		/**
+		* path
+		* The file of a segment.
+		* @param		long long segment
+		* @param		const char* ext
+		* @return		std::string
+		*/
+		std::string path(long long segment, const char* ext = GK_FS_LOG_EXT) const noexcept;
+
+		/**
+		* files
+		* The numbered files of the data directory with an extension, sorted.
+		* @param		const char* ext
+		* @return		std::vector<long long>
+		*/
+		std::vector<long long> files(const char* ext) const noexcept;
+
+		/**
+		* buffered
+		* Counts a buffered record, flushing a full batch or starting the timer.
+		*/
+		void buffered() noexcept;
+
+		/**
+		* coalesce
+		* Holds a property change until the end of the loop iteration.
+		* @param		Mutation mutation, Set or Delete
+		* @param		gk::Node* node
+		* @param		const std::string& key
+		* @param		const std::string& value
+		*/
+		void coalesce(Mutation mutation, gk::Node* node, const std::string& key, const std::string& value) noexcept;
+
+		/**
+		* drain
+		* Appends one update record per dirty Node, the last change of each
+		* key winning.
+		*/
+		void drain() noexcept;
+
+		/**
+		* take
+		* Moves the buffered records out behind the table of their symbols,
+		* encoding the buffered inserts.
+		* @param		bool batch, nests the records in a single batch record
+		* @return		std::string
+		*/
+		std::string take(bool batch = false) noexcept;
+
+		/**
+		* encode
+		* Encodes the buffered inserts into the buffers of the workers, on
+		* the Scheduler when there are enough of them, one piece per insert.
+		* The loop thread waits for the workers, then take splices the pieces
+		* in order.
+		*/
+		void encode() noexcept;
+
+		/**
+		* write
+		* Queues encoded records as a batch and starts writing it.
+		* @param		std::string&& data
+		*/
+		void write(std::string&& data) noexcept;
+
+		/**
+		* revert
+		* Undoes the journaled changes down to a mark, newest first.
+		* @param		std::size_t mark
+		*/
+		void revert(std::size_t mark) noexcept;
+
+		/**
+		* release
+		* Lets go of the Nodes of the journaled changes down to a mark.
+		* @param		std::size_t mark
+		*/
+		void release(std::size_t mark) noexcept;
+
+		/**
+		* fold
+		* Whether a record is carried by an insert of its Node that is still
+		* buffered, as inserts are only encoded when they are flushed. A
+		* removal cancels the insert.
+		* @param		Mutation mutation
+		* @param		gk::Node* node
+		* @return		bool
+		*/
+		bool fold(Mutation mutation, gk::Node* node) noexcept;
+
+		/**
+		* pump
+		* Starts writing the next batch if none is being written.
+		*/
+		void pump() noexcept;
+
+		/**
+		* uring
+		* Whether batches are submitted to io_uring, setting the ring up on
+		* first use.
+		* @return		bool
+		*/
+		bool uring() noexcept;
+
+		/**
+		* submit
+		* Submits the write of a batch and its sync to the ring.
+		* @param		Batch* batch
+		*/
+		void submit(Batch* batch) noexcept;
+
+		/**
+		* reap
+		* Takes the completions of the ring, finishing the batch once its
+		* write and sync are done and submitting the rest of a short write.
+		* @param		bool nested, completes without pumping or running microtasks
+		*/
+		void reap(bool nested) noexcept;
+
+		/**
+		* open
+		* Rolls the log or opens the segment a batch goes to, on any thread.
+		* Each process starts a segment of its own, and a new one once it
+		* reaches the segment size.
+		* @param		Batch* batch
+		* @return		bool, false if the segment could not be opened
+		*/
+		bool open(Batch* batch) noexcept;
+
+		/**
+		* apply
+		* Appends a batch to the current segment and syncs it, on any thread.
+		* Only one batch is applied at a time.
+		* @param		Batch* batch
+		*/
+		void apply(Batch* batch) noexcept;
+
+		/**
+		* discard
+		* Cuts the bytes of a failed batch off the segment, so later batches
+		* never follow a torn record. A segment that cannot be truncated is
+		* closed and the next batch starts a new one, on any thread.
+		* @param		Batch* batch
+		*/
+		void discard(Batch* batch) noexcept;
+
+		/**
+		* settle
+		* Writes every queued batch on the v8 thread before returning, after
+		* the batch being written, used by strict durability.
+		*/
+		void settle() noexcept;
+
+		/**
+		* written
+		* Completes a batch written on the libuv thread pool.
+		* @param		Batch* batch
+		*/
+		void written(Batch* batch) noexcept;
+
+		/**
+		* complete
+		* Completes a batch on the v8 thread and settles the waiting resolvers.
+		* @param		Batch* batch
+		* @return		bool, whether any resolver was settled
+		*/
+		bool complete(Batch* batch) noexcept;
+
+		/**
+		* image
+		* Copies the next chunk of Nodes into the checkpoint, then writes it
+		* on the libuv thread pool once every Node is copied.
+		*/
+		void image() noexcept;
+
+		/**
+		* imaged
+		* Completes a checkpoint on the v8 thread.
+		*/
+		void imaged() noexcept;
+
+		/**
+		* publish
+		* Renames a written checkpoint into place and deletes the segments,
+		* checkpoints and Node files it covers, on any thread.
+		* @param		long long segment
+		* @return		bool
+		*/
+		bool publish(long long segment) const noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,287 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include "Topology.h"
+#include "Entity.h"
+#include "Action.h"
+#include "Bond.h"
+
+gk::Topology::Topology() noexcept
+	: nodes_{},
+	  offsets_{},
+	  targets_{},
+	  lookup_{} {}
+
+gk::Topology::~Topology() {}
+
+void gk::Topology::build(v8::Isolate* isolate, gk::Coordinator::NodeGraph* nodeGraph, const Options& options) noexcept {
+	nodes_.clear();
+	offsets_.clear();
+	targets_.clear();
+	lookup_.clear();
+
+	// vertices, every indexed Entity in Index order
+	auto entities = nodeGraph->findByKey(gk::NodeClass::Entity);
+	if (entities) {
+		for (auto i = 1; i <= entities->count(); ++i) {
+			auto index = entities->select(i);
+			for (auto j = 1; j <= index->count(); ++j) {
+				nodes_.push_back(index->select(j));
+			}
+		}
+	}
+
+	// ranked Nodes first, in rank order
+	if (Ordering::Rank == options.ordering) {
+		std::stable_sort(nodes_.begin(), nodes_.end(), [](gk::Node* a, gk::Node* b) {
+			return 0 <= a->rank() && (0 > b->rank() || a->rank() < b->rank());
+		});
+	}
+	for (std::size_t v = 0; v < nodes_.size(); ++v) {
+		lookup_.insert({nodes_[v], static_cast<Vertex>(v)});
+	}
+
+	// edges as subject, object pairs
+	std::vector<std::pair<Vertex, Vertex>> pairs;
+	auto add = [&](gk::Node* s, gk::Node* o) {
+		auto u = vertex(s);
+		auto v = vertex(o);
+		if (0 > u || 0 > v) {
+			return;
+		}
+		pairs.emplace_back(u, v);
+		if (!options.directed) {
+			pairs.emplace_back(v, u);
+		}
+	};
+
+	if (options.bonds) {
+		auto bonds = nodeGraph->findByKey(gk::NodeClass::Bond);
+		if (bonds) {
+			for (auto i = 1; i <= bonds->count(); ++i) {
+				auto index = bonds->select(i);
+				if (!options.bondType.empty() && options.bondType != index->type()) {
+					continue;
+				}
+				for (auto j = 1; j <= index->count(); ++j) {
+					auto bond = dynamic_cast<gk::Bond<gk::Entity>*>(index->select(j));
+					if (bond && bond->subject() && bond->object()) {
+						add(bond->subject(), bond->object());
+					}
+				}
+			}
+		}
+	}
+
+	if (options.actions) {
+		auto actions = nodeGraph->findByKey(gk::NodeClass::Action);
+		if (actions) {
+			for (auto i = 1; i <= actions->count(); ++i) {
+				auto index = actions->select(i);
+				if (!options.actionType.empty() && options.actionType != index->type()) {
+					continue;
+				}
+				for (auto j = 1; j <= index->count(); ++j) {
+					auto action = dynamic_cast<gk::Action<gk::Entity>*>(index->select(j));
+					if (!action) {
+						continue;
+					}
+					auto subjects = action->subjects(isolate);
+					auto objects = action->objects(isolate);
+					for (auto k = subjects->count(); 0 < k; --k) {
+						for (auto l = objects->count(); 0 < l; --l) {
+							add(subjects->select(k), objects->select(l));
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// counting sort into rows, then sort and deduplicate each row
+	offsets_.assign(nodes_.size() + 1, 0);
+	for (auto& e : pairs) {
+		++offsets_[e.first + 1];
+	}
+	for (std::size_t v = 0; v < nodes_.size(); ++v) {
+		offsets_[v + 1] += offsets_[v];
+	}
+	targets_.resize(pairs.size());
+	std::vector<Offset> cursor(offsets_.begin(), offsets_.end() - 1);
+	for (auto& e : pairs) {
+		targets_[cursor[e.first]++] = e.second;
+	}
+
+	Offset w = 0;
+	for (std::size_t v = 0; v < nodes_.size(); ++v) {
+		auto first = targets_.begin() + offsets_[v];
+		auto last = targets_.begin() + offsets_[v + 1];
+		std::sort(first, last);
+		last = std::unique(first, last);
+		offsets_[v] = w;
+		w = std::copy(first, last, targets_.begin() + w) - targets_.begin();
+	}
+	offsets_[nodes_.size()] = w;
+	targets_.resize(w);
+	targets_.shrink_to_fit();
+
+	if (Ordering::Rank != options.ordering && Ordering::Index != options.ordering) {
+		reorder(options.ordering);
+	}
+}
+
+std::vector<gk::Topology::Vertex> gk::Topology::permutation(Ordering ordering) const noexcept {
+	auto n = vertices();
+	std::vector<Vertex> order;
+	order.reserve(n);
+
+	if (Ordering::Degree == ordering) {
+		for (Vertex v = 0; v < n; ++v) {
+			order.push_back(v);
+		}
+		std::stable_sort(order.begin(), order.end(), [&](Vertex a, Vertex b) {
+			return degree(a) > degree(b);
+		});
+		return order;
+	}
+
+	if (Ordering::BFS != ordering && Ordering::RCM != ordering) {
+		for (Vertex v = 0; v < n; ++v) {
+			order.push_back(v);
+		}
+		return order;
+	}
+
+	// each component is started from its lowest degree vertex
+	std::vector<Vertex> seeds;
+	for (Vertex v = 0; v < n; ++v) {
+		seeds.push_back(v);
+	}
+	std::stable_sort(seeds.begin(), seeds.end(), [&](Vertex a, Vertex b) {
+		return degree(a) < degree(b);
+	});
+
+	std::vector<bool> visited(n, false);
+	std::vector<Vertex> adjacent;
+	for (auto seed : seeds) {
+		if (visited[seed]) {
+			continue;
+		}
+		visited[seed] = true;
+		std::size_t head = order.size();
+		order.push_back(seed);
+		while (head < order.size()) {
+			auto u = order[head++];
+			adjacent.assign(neighbours(u), neighbours(u) + degree(u));
+			if (Ordering::RCM == ordering) {
+				// Cuthill-McKee visits neighbours by increasing degree
+				std::stable_sort(adjacent.begin(), adjacent.end(), [&](Vertex a, Vertex b) {
+					return degree(a) < degree(b);
+				});
+			}
+			for (auto v : adjacent) {
+				if (!visited[v]) {
+					visited[v] = true;
+					order.push_back(v);
+				}
+			}
+		}
+	}
+
+	if (Ordering::RCM == ordering) {
+		std::reverse(order.begin(), order.end());
+	}
+	return order;
+}
+
+void gk::Topology::reorder(Ordering ordering) noexcept {
+	auto n = vertices();
+	auto order = permutation(ordering);
+	std::vector<Vertex> label(n);
+	for (Vertex i = 0; i < n; ++i) {
+		label[order[i]] = i;
+	}
+
+	// rewrite the rows in the new order with relabelled targets
+	std::vector<gk::Node*> nodes(n);
+	std::vector<Offset> offsets(n + 1, 0);
+	std::vector<Vertex> targets(targets_.size());
+	for (Vertex i = 0; i < n; ++i) {
+		auto old = order[i];
+		nodes[i] = nodes_[old];
+		auto first = targets.begin() + offsets[i];
+		auto last = std::transform(neighbours(old), neighbours(old) + degree(old), first, [&](Vertex v) {
+			return label[v];
+		});
+		std::sort(first, last);
+		offsets[i + 1] = offsets[i] + degree(old);
+	}
+
+	nodes_.swap(nodes);
+	offsets_.swap(offsets);
+	targets_.swap(targets);
+	lookup_.clear();
+	for (Vertex v = 0; v < n; ++v) {
+		lookup_.insert({nodes_[v], v});
+	}
+}
+
+gk::Topology::Vertex gk::Topology::bandwidth() const noexcept {
+	Vertex b = 0;
+	for (Vertex u = 0; u < vertices(); ++u) {
+		if (0 < degree(u)) {
+			// rows are sorted, the extremes are the first and last targets
+			auto first = neighbours(u);
+			b = std::max(b, std::max(std::abs(u - first[0]), std::abs(first[degree(u) - 1] - u)));
+		}
+	}
+	return b;
+}
+
+gk::Topology::Vertex gk::Topology::vertices() const noexcept {
+	return static_cast<Vertex>(nodes_.size());
+}
+
+gk::Topology::Offset gk::Topology::edges() const noexcept {
+	return static_cast<Offset>(targets_.size());
+}
+
+gk::Topology::Vertex gk::Topology::degree(Vertex v) const noexcept {
+	return static_cast<Vertex>(offsets_[v + 1] - offsets_[v]);
+}
+
+const gk::Topology::Vertex* gk::Topology::neighbours(Vertex v) const noexcept {
+	return targets_.data() + offsets_[v];
+}
+
+bool gk::Topology::adjacent(Vertex u, Vertex v) const noexcept {
+	auto first = neighbours(u);
+	return std::binary_search(first, first + degree(u), v);
+}
+
+gk::Node* gk::Topology::node(Vertex v) const noexcept {
+	return nodes_[v];
+}
+
+gk::Topology::Vertex gk::Topology::vertex(gk::Node* node) const noexcept {
+	auto it = lookup_.find(node);
+	return lookup_.end() == it ? -1 : it->second;
+}
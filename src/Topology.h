@@ -0,0 +1,187 @@
+/**
+* Copyright (C) 2015 GraphKit, Inc. <http://graphkit.io> and other GraphKit contributors.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program located at the root of the software package
+* in a file called LICENSE.  If not, see <http://www.gnu.org/licenses/>.
+*
+* Topology.h
+*
+* A read only compressed sparse row (CSR) snapshot of the Entity graph. Entities
+* become dense vertex ids and Bonds and Actions become subject to object edges.
+* Once built, a Topology does not reference any v8 data and may be shared
+* across threads.
+*/
+
+#ifndef GRAPHKIT_SRC_TOPOLOGY_H
+#define GRAPHKIT_SRC_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "exports.h"
+#include "Node.h"
+#include "Coordinator.h"
+
+namespace gk {
+	class Topology {
+	public:
+
+		// aliases
+		using Vertex = int;
+		using Offset = long long;
+
+		/**
+		* Ordering
+		* How vertices are numbered. Rank uses the rank stored on each Node by
+		* a previous reorder, falling back to Index order for unranked Nodes.
+		*/
+		enum class Ordering {
+			Rank,
+			Index,
+			BFS,
+			RCM,
+			Degree
+		};
+
+		/**
+		* Options
+		* Selects which relationship Nodes become edges.
+		* An empty type matches every type.
+		*/
+		struct Options {
+			bool bonds = true;
+			bool actions = true;
+			bool directed = false;
+			std::string bondType;
+			std::string actionType;
+			Ordering ordering = Ordering::Rank;
+		};
+
+		/**
+		* Topology
+		* Constructor.
+		*/
+		Topology() noexcept;
+
+		/**
+		* ~Topology
+		* Destructor.
+		*/
+		virtual ~Topology();
+
+		// defaults
+		Topology(const Topology&) = default;
+		Topology& operator= (const Topology&) = default;
+		Topology(Topology&&) = default;
+		Topology& operator= (Topology&&) = default;
+
+		/**
+		* build
+		* Builds the vertex and edge arrays from the Node Graph. Must be called
+		* on the v8 thread.
+		* @param		v8::Isolate* isolate
+		* @param		Coordinator::NodeGraph* nodeGraph
+		* @param		const Options& options
+		*/
+		void build(v8::Isolate* isolate, gk::Coordinator::NodeGraph* nodeGraph, const Options& options) noexcept;
+
+		/**
+		* reorder
+		* Renumbers the vertices for locality and rewrites the rows in the new
+		* order. BFS and RCM (reverse Cuthill-McKee) keep neighbours close
+		* together, Degree places high degree vertices first.
+		* @param		Ordering ordering
+		*/
+		void reorder(Ordering ordering) noexcept;
+
+		/**
+		* bandwidth
+		* The largest distance between the ids of two adjacent vertices.
+		* @return		Vertex
+		*/
+		Vertex bandwidth() const noexcept;
+
+		/**
+		* vertices
+		* The number of vertices.
+		* @return		Vertex
+		*/
+		Vertex vertices() const noexcept;
+
+		/**
+		* edges
+		* The number of stored (directed) edges.
+		* @return		Offset
+		*/
+		Offset edges() const noexcept;
+
+		/**
+		* degree
+		* The number of neighbours of a vertex.
+		* @param		Vertex v
+		* @return		Vertex
+		*/
+		Vertex degree(Vertex v) const noexcept;
+
+		/**
+		* neighbours
+		* The sorted neighbour list of a vertex, degree(v) entries long.
+		* @param		Vertex v
+		* @return		const Vertex*
+		*/
+		const Vertex* neighbours(Vertex v) const noexcept;
+
+		/**
+		* adjacent
+		* Checks if an edge u -> v exists using a binary search.
+		* @param		Vertex u
+		* @param		Vertex v
+		* @return		bool
+		*/
+		bool adjacent(Vertex u, Vertex v) const noexcept;
+
+		/**
+		* node
+		* Retrieves the Entity Node of a vertex. The pointer is only valid
+		* on the v8 thread while the Entity is indexed.
+		* @param		Vertex v
+		* @return		gk::Node*
+		*/
+		gk::Node* node(Vertex v) const noexcept;
+
+		/**
+		* vertex
+		* Retrieves the vertex of an Entity Node, or -1 if not present.
+		* @param		gk::Node* node
+		* @return		Vertex
+		*/
+		Vertex vertex(gk::Node* node) const noexcept;
+
+	protected:
+		std::vector<gk::Node*> nodes_;
+		std::vector<Offset> offsets_;
+		std::vector<Vertex> targets_;
+		std::unordered_map<gk::Node*, Vertex> lookup_;
+
+		/**
+		* permutation
+		* Computes the new order of the current vertex ids.
+		* @param		Ordering ordering
+		* @return		std::vector<Vertex>, the old id at each new position
+		*/
+		std::vector<Vertex> permutation(Ordering ordering) const noexcept;
+	};
+}
+
+#endif
@@ -21,6 +21,11 @@
 
 // file system
 #define GK_FS_DB_DIR								"gk.db"
+#define GK_FS_LOG_EXT								".log"
+#define GK_FS_CHECKPOINT_EXT						".ckpt"
+#define GK_FS_POOL_FILE								"nodes.pool"
+#define GK_FS_INDEX_DIR								"index"
+#define GK_FS_INDEX_EXT								".idx"
 
 // classes
 #define GK_SYMBOL_NODE_CLASS_NODE_CONSTANT			0
@@ -44,6 +49,7 @@
 #define GK_SYMBOL_BOND_SET 							"BondSet"
 #define GK_SYMBOL_MULTISET 							"Multiset"
 #define GK_SYMBOL_HUB 								"Hub"
+#define GK_SYMBOL_JOB 								"Job"
 
 // operations
 #define GK_SYMBOL_OPERATION_NODE_CLASS 				"nodeClass"
@@ -76,5 +82,109 @@
 #define GK_SYMBOL_OPERATION_BONDS					"bonds"
 #define GK_SYMBOL_OPERATION_HASH					"hash"
 #define GK_SYMBOL_OPERATION_GROUP					"group"
+#define GK_SYMBOL_OPERATION_WALK					"walk"
+#define GK_SYMBOL_OPERATION_SIMILAR					"similar"
+#define GK_SYMBOL_OPERATION_SIMILAR_PAIRS			"similarPairs"
+#define GK_SYMBOL_OPERATION_FEATURES				"features"
+#define GK_SYMBOL_OPERATION_REORDER					"reorder"
+#define GK_SYMBOL_OPERATION_CANCEL					"cancel"
+#define GK_SYMBOL_OPERATION_THEN					"then"
+#define GK_SYMBOL_OPERATION_CHECKPOINT				"checkpoint"
+#define GK_SYMBOL_OPERATION_FLUSH					"flush"
+#define GK_SYMBOL_OPERATION_SAVE_SNAPSHOT			"saveSnapshot"
+#define GK_SYMBOL_OPERATION_OPEN					"open"
+#define GK_SYMBOL_OPERATION_BATCH					"batch"
+#define GK_SYMBOL_OPERATION_INSERT_MANY				"insertMany"
+#define GK_SYMBOL_OPERATION_CREATE_ENTITIES			"createEntities"
+#define GK_SYMBOL_OPERATION_STATS					"stats"
+#define GK_SYMBOL_OPERATION_DROP_TYPE				"dropType"
+#define GK_SYMBOL_OPERATION_DROP_CLUSTER			"dropCluster"
+#define GK_SYMBOL_OPERATION_EXPORT_LOG				"exportLog"
+#define GK_SYMBOL_OPERATION_CLOSE					"close"
+
+// options
+#define GK_SYMBOL_OPTION_LENGTH						"length"
+#define GK_SYMBOL_OPTION_WALKS						"walks"
+#define GK_SYMBOL_OPTION_P							"p"
+#define GK_SYMBOL_OPTION_Q							"q"
+#define GK_SYMBOL_OPTION_THREADS					"threads"
+#define GK_SYMBOL_OPTION_SEED						"seed"
+#define GK_SYMBOL_OPTION_FILE						"file"
+#define GK_SYMBOL_OPTION_DIRECTED					"directed"
+#define GK_SYMBOL_OPTION_BOND_TYPE					"bondType"
+#define GK_SYMBOL_OPTION_ACTION_TYPE				"actionType"
+#define GK_SYMBOL_OPTION_ROWS						"rows"
+#define GK_SYMBOL_OPTION_VERTICES					"vertices"
+#define GK_SYMBOL_OPTION_METRIC						"metric"
+#define GK_SYMBOL_OPTION_METRIC_JACCARD				"jaccard"
+#define GK_SYMBOL_OPTION_METRIC_COSINE				"cosine"
+#define GK_SYMBOL_OPTION_TOP_K						"topK"
+#define GK_SYMBOL_OPTION_THRESHOLD					"threshold"
+#define GK_SYMBOL_OPTION_ENTITY						"entity"
+#define GK_SYMBOL_OPTION_SCORE						"score"
+#define GK_SYMBOL_OPTION_SCORES						"scores"
+#define GK_SYMBOL_OPTION_PAIRS						"pairs"
+#define GK_SYMBOL_OPTION_PROPERTIES					"properties"
+#define GK_SYMBOL_OPTION_GROUPS						"groups"
+#define GK_SYMBOL_OPTION_DEGREES					"degrees"
+#define GK_SYMBOL_OPTION_COLUMNS					"columns"
+#define GK_SYMBOL_OPTION_ORDER						"order"
+#define GK_SYMBOL_OPTION_METHOD						"method"
+#define GK_SYMBOL_OPTION_ORDER_RANK					"rank"
+#define GK_SYMBOL_OPTION_ORDER_INDEX				"index"
+#define GK_SYMBOL_OPTION_ORDER_BFS					"bfs"
+#define GK_SYMBOL_OPTION_ORDER_RCM					"rcm"
+#define GK_SYMBOL_OPTION_ORDER_DEGREE				"degree"
+#define GK_SYMBOL_OPTION_BANDWIDTH					"bandwidth"
+#define GK_SYMBOL_OPTION_PREVIOUS					"previous"
+#define GK_SYMBOL_OPTION_ASYNC						"async"
+#define GK_SYMBOL_OPTION_PROGRESS					"progress"
+#define GK_SYMBOL_OPTION_PROMISE					"promise"
+#define GK_SYMBOL_OPTION_CANCELLED					"cancelled"
+#define GK_SYMBOL_OPTION_DONE						"done"
+#define GK_SYMBOL_OPTION_BATCH						"batch"
+#define GK_SYMBOL_OPTION_DELAY						"delay"
+#define GK_SYMBOL_OPTION_SEGMENT					"segment"
+#define GK_SYMBOL_OPTION_CHECKPOINT					"checkpoint"
+#define GK_SYMBOL_OPTION_INTERVAL					"interval"
+#define GK_SYMBOL_OPTION_SNAPSHOT					"snapshot"
+#define GK_SYMBOL_OPTION_MEMORY						"memory"
+#define GK_SYMBOL_OPTION_COALESCE					"coalesce"
+#define GK_SYMBOL_OPTION_DURABILITY					"durability"
+#define GK_SYMBOL_OPTION_DURABILITY_NONE			"none"
+#define GK_SYMBOL_OPTION_DURABILITY_ASYNC			"async"
+#define GK_SYMBOL_OPTION_DURABILITY_GROUP			"group"
+#define GK_SYMBOL_OPTION_DURABILITY_STRICT			"strict"
+#define GK_SYMBOL_OPTION_RING						"ring"
+#define GK_SYMBOL_OPTION_PATH						"path"
+#define GK_SYMBOL_OPTION_COMPRESS					"compress"
+
+// stats
+#define GK_SYMBOL_STAT_BUFFERED						"buffered"
+#define GK_SYMBOL_STAT_QUEUED						"queued"
+#define GK_SYMBOL_STAT_WRITTEN						"written"
+#define GK_SYMBOL_STAT_LOGGED						"logged"
+#define GK_SYMBOL_STAT_SEGMENT						"segment"
+#define GK_SYMBOL_STAT_RESIDENT						"resident"
+#define GK_SYMBOL_STAT_PAGED						"paged"
+
+// log records
+#define GK_SYMBOL_RECORD_INSERT						"insert"
+#define GK_SYMBOL_RECORD_REMOVE						"remove"
+#define GK_SYMBOL_RECORD_SET						"set"
+#define GK_SYMBOL_RECORD_DELETE						"delete"
+#define GK_SYMBOL_RECORD_ADD_GROUP					"addGroup"
+#define GK_SYMBOL_RECORD_REMOVE_GROUP				"removeGroup"
+#define GK_SYMBOL_RECORD_ADD_SUBJECT				"addSubject"
+#define GK_SYMBOL_RECORD_REMOVE_SUBJECT				"removeSubject"
+#define GK_SYMBOL_RECORD_ADD_OBJECT					"addObject"
+#define GK_SYMBOL_RECORD_REMOVE_OBJECT				"removeObject"
+#define GK_SYMBOL_RECORD_SUBJECT					"subject"
+#define GK_SYMBOL_RECORD_OBJECT						"object"
+#define GK_SYMBOL_RECORD_RANK						"rank"
+#define GK_SYMBOL_RECORD_UPDATE						"update"
+#define GK_SYMBOL_RECORD_DROP						"drop"
+#define GK_SYMBOL_RECORD_BATCH						"batch"
+#define GK_SYMBOL_RECORD_SYMBOLS					"symbols"
 
 #endif
\ No newline at end of file
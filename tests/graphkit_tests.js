@@ -134,4 +134,692 @@ g1.clear();
 	if (1 != g1.group('test').count) {
 		console.log('Group test failed.', g1.group('test'));
 	}
-})();
\ No newline at end of file
+})();
+(function() {
+	// test random walks over the Friend Bonds and Read Actions
+	let start = Date.now();
+	let walks = g1.walk({length: 8, walks: 2, p: 0.5, q: 2, type: 'User', seed: 1});
+	if (walks.rows != 2 * g1.Entity.User.count || walks.walks.length != walks.rows * walks.length) {
+		console.log('Walk size test failed.');
+	}
+	for (let i = 0; i < walks.rows; ++i) {
+		if ('User' != walks.vertices[walks.walks[i * walks.length]].type) {
+			console.log('Walk start test failed.');
+		}
+	}
+	[-1, 1.5, NaN].forEach(function(threads) {
+		try {
+			g1.walk({length: 8, walks: 1, threads: threads});
+			console.log('Walk threads test failed.', threads);
+		} catch (e) {}
+	});
+	if (walks.rows != g1.walk({length: 8, walks: 2, type: 'User', threads: 1e9}).rows) {
+		console.log('Walk threads clamp test failed.');
+	}
+	let empty = g1.walk({length: 8, walks: 1, type: 'Nobody'});
+	if (0 != empty.rows || !(empty.walks instanceof Int32Array) || 0 != empty.walks.length) {
+		console.log('Walk empty test failed.', empty);
+	}
+	g1.walk({length: 8, walks: 1, type: 'Nobody', async: true}).then(function(result) {
+		if (0 != result.rows || 0 != result.walks.length) {
+			console.log('Walk empty Job test failed.', result);
+		}
+	}, function(e) {
+		console.log('Walk empty Job test failed.', e);
+	});
+	let file = 'gk.db/walks.bin';
+	let written = g1.walk({length: 8, walks: 2, type: 'User', seed: 1, file: file});
+	if (undefined !== written.walks || written.rows * written.length * 4 != require('fs').statSync(file).size) {
+		console.log('Walk file test failed.');
+	}
+	require('fs').unlinkSync(file);
+	if (require('fs').existsSync('/dev/full')) {
+		try {
+			g1.walk({length: 8, walks: 2, file: '/dev/full'});
+			console.log('Walk file error test failed.');
+		} catch (e) {}
+	}
+	console.log('Walks generated (%d) Time %d', walks.rows, Date.now() - start);
+})();
+
+(function() {
+	// test similarity between Users through the Books they read
+	let start = Date.now();
+	let user = g1.Entity.User[0];
+	let similar = g1.similar(user, {actionType: 'Read', metric: 'jaccard', topK: 5});
+	for (let i = 1; i < similar.length; ++i) {
+		if (similar[i - 1].score < similar[i].score || user == similar[i].entity) {
+			console.log('Similar order test failed.');
+		}
+	}
+	let rejected = [{threshold: NaN}, {threshold: 0}, {threshold: 5}, {topK: -1}, {topK: 1.5}, {topK: NaN}, {topK: Infinity}].every(function(options) {
+		try {
+			g1.similar(user, Object.assign({actionType: 'Read'}, options));
+			return false;
+		} catch (e) {
+			return true;
+		}
+	});
+	if (!rejected) {
+		console.log('Similar options test failed.');
+	}
+	let pairs = g1.similarPairs({actionType: 'Read', metric: 'cosine', threshold: 0.2});
+	for (let i = 0; i < pairs.rows; ++i) {
+		if (0.2 > pairs.scores[i]) {
+			console.log('Similar pairs threshold test failed.');
+		}
+	}
+	try {
+		g1.similarPairs({actionType: 'Read', threads: -1});
+		console.log('Similar pairs threads test failed.');
+	} catch (e) {}
+	console.log('Similar pairs found (%d) Time %d', pairs.rows, Date.now() - start);
+})();
+
+(function() {
+	// test the User feature matrix
+	let start = Date.now();
+	let users = g1.Entity.User;
+	users[0]['age'] = 26;
+	let matrix = g1.features({type: 'User', properties: ['age'], groups: ['test'], degrees: true});
+	if (matrix.rows != users.count || matrix.length != matrix.rows * matrix.columns.length) {
+		console.log('Features size test failed.');
+	}
+	if (users[0].id != matrix[0] || 26 != matrix[1] || matrix[4] != 10 + users[0].actions.count) {
+		console.log('Features row test failed.');
+	}
+	console.log('Features written (%d) Time %d', matrix.rows, Date.now() - start);
+})();
+
+(function() {
+	// test locality reordering of the Entity vertices
+	let start = Date.now();
+	let result = g1.reorder({method: 'rcm'});
+	if (result.vertices != g1.Entity.User.count + g1.Entity.Book.count) {
+		console.log('Reorder vertices test failed.', result);
+	}
+	// the stored ranks are the order the bandwidth was measured in
+	if (g1.reorder({method: 'index'}).previous != result.bandwidth) {
+		console.log('Reorder rank test failed.');
+	}
+
+	// the logged ranks of a small Graph number its Entities 0 to n - 1
+	let g = new gk.Graph({path: 'gk.db/ranked'});
+	if (g.Entity && g.Entity.Ranked) {
+		g.dropType(1, 'Ranked');
+	}
+	let entities = g.createEntities('Ranked', 100);
+	entities.forEach(function(e, i) {
+		let b = g.createBond('Near');
+		b.subject = e;
+		b.object = entities[(i * 7 + 3) % entities.length];
+	});
+	let ranked = g.reorder({method: 'rcm'});
+	g.flush().then(function() {
+		let ranks = {};
+		entities.forEach(function(e) {
+			ranks[e.id] = -1;
+		});
+		g.exportLog().split('\n').forEach(function(line) {
+			if (0 < line.length) {
+				let r = JSON.parse(line);
+				(r.records || [r]).forEach(function(r) {
+					if ('rank' == r.op && r.node[2] in ranks) {
+						ranks[r.node[2]] = +r.value;
+					}
+				});
+			}
+		});
+		let sorted = Object.keys(ranks).map(function(id) {
+			return ranks[id];
+		}).sort(function(a, b) {
+			return a - b;
+		});
+		if (entities.length != ranked.vertices || !sorted.every(function(rank, i) {
+			return rank == i;
+		})) {
+			console.log('Reorder permutation test failed.', ranked, sorted);
+		}
+	}).catch(function(e) {
+		console.log('Reorder permutation test failed.', e);
+	});
+	console.log('Reordered (%d) Bandwidth %d -> %d Time %d', result.vertices, result.previous, result.bandwidth, Date.now() - start);
+})();
+
+(function() {
+	// test walks running as a Job on the scheduler
+	let start = Date.now();
+	let threads = gk.Job.threads();
+	let rejected = [-1, 1.5, NaN, Infinity].every(function(n) {
+		try {
+			gk.Job.threads(n);
+			return false;
+		} catch (e) {
+			return true;
+		}
+	});
+	let clamped = gk.Job.threads(1e9);
+	gk.Job.threads(threads);
+	if (!rejected || 1e9 <= clamped || threads != gk.Job.threads()) {
+		console.log('Job threads test failed.', rejected, clamped);
+	}
+	let walks = g1.walk({length: 8, walks: 4, seed: 3});
+	let progress = 0;
+	let job = g1.walk({length: 8, walks: 4, seed: 3, async: true, progress: function(fraction) {
+		progress = fraction;
+	}});
+	job.then(function(result) {
+		if (result.rows != walks.rows || !result.walks.every(function(v, i) { return v == walks.walks[i]; })) {
+			console.log('Job walk test failed.');
+		}
+		if (1 != progress || 1 != job.progress) {
+			console.log('Job progress test failed.');
+		}
+		console.log('Job walks generated (%d) Time %d', result.rows, Date.now() - start);
+	});
+	let cancelled = g1.walk({length: 8, walks: 4, async: true});
+	cancelled.cancel();
+	cancelled.then(function() {
+		console.log('Job cancel test failed.');
+	}, function() {});
+})();
+
+(function() {
+	// test the log is flushed to disk, in its own directory so the checkpoint below keeps its segments
+	let start = Date.now();
+	let g = new gk.Graph({path: 'gk.db/flushed'});
+	let user = g.createEntity('User');
+	// the insert is written first, a change to a buffered insert is folded into it
+	g.flush().then(function() {
+		user['flushed'] = 'yes';
+		return g.flush();
+	}).then(function() {
+		let updated = g.exportLog().split('\n').some(function(line) {
+			let r = 0 < line.length ? JSON.parse(line) : {};
+			return 'update' == r.op && user.id == r.node[2] && 'flushed' == r.properties[0][0] && 'yes' == r.properties[0][1];
+		});
+		if (!updated) {
+			console.log('Flush test failed.');
+		}
+		console.log('Flushed (%d) Time %d', g.Entity.User.count, Date.now() - start);
+	}).catch(function(e) {
+		console.log('Flush test failed.', e);
+	});
+})();
+
+(function() {
+	// test a checkpoint replaces the older log segments
+	let start = Date.now();
+	g1.createEntity('Checkpointed')['checkpointed'] = 'yes';
+	g1.checkpoint().then(function() {
+		let files = require('fs').readdirSync('./gk.db');
+		let checkpoints = files.filter(function(f) {
+			return f.endsWith('.ckpt');
+		});
+		if (1 != checkpoints.length || files.some(function(f) {
+			return f.endsWith('.log') && parseInt(f) <= parseInt(checkpoints[0]);
+		})) {
+			console.log('Checkpoint test failed.', files);
+		}
+		console.log('Checkpointed (%d) Time %d', g1.Entity.User.count, Date.now() - start);
+	});
+})();
+
+(function() {
+	// test a snapshot holds every Node and cannot be opened once loaded
+	let start = Date.now();
+	let file = require('os').tmpdir() + '/graphkit_snapshot_test.gks';
+	let expected = 0;
+	for (let c of ['Entity', 'Action', 'Bond']) {
+		for (let i = g1[c].count - 1; 0 <= i; --i) {
+			expected += g1[c][i].count;
+		}
+	}
+	g1.saveSnapshot(file).then(function(count) {
+		let data = require('fs').readFileSync(file);
+		if (count != expected || 'GKSNAP' != data.toString('ascii', 0, 6)) {
+			console.log('Snapshot test failed.', count, expected);
+		}
+		try {
+			gk.Graph.open({snapshot: file});
+			console.log('Snapshot open test failed.');
+		} catch (e) {}
+		require('fs').unlinkSync(file);
+		console.log('Snapshot saved (%d) Time %d', count, Date.now() - start);
+	}, function(e) {
+		console.log('Snapshot test failed.', e);
+	});
+})();
+
+(function() {
+	// test Node bodies evicted from a small buffer pool are faulted back in
+	let start = Date.now();
+	let g = new gk.Graph({memory: 1 << 14});
+	let entities = [];
+	for (let i = 0; i < 1000; ++i) {
+		let e = new gk.Entity('Paged');
+		g.insert(e);
+		e['body'] = 'body' + i + 'x'.repeat(100);
+		e.addGroup('paged');
+		entities.push(e);
+	}
+	for (let i = 0; i < entities.length; i += 2) {
+		entities[i]['body'] = 'changed' + i;
+	}
+	for (let i = 0; i < entities.length; ++i) {
+		let expected = i % 2 ? 'body' + i + 'x'.repeat(100) : 'changed' + i;
+		if (expected != entities[i]['body'] || !entities[i].hasGroup('paged')) {
+			console.log('Pool test failed.', i);
+			break;
+		}
+	}
+	g.Entity.Paged.clear();
+	if (g.Entity.Paged.find(1)) {
+		console.log('Pool clear test failed.');
+	}
+	console.log('Paged (%d) Time %d', entities.length, Date.now() - start);
+})();
+
+(function() {
+	// test property changes of one loop iteration are logged as a single update
+	let start = Date.now();
+	let g = new gk.Graph();
+	let e = new gk.Entity('Coalesced');
+	g.insert(e);
+	setImmediate(function() {
+		for (let i = 0; i < 10; ++i) {
+			e['count'] = i;
+			e['scratch'] = i;
+		}
+		delete e['scratch'];
+		g.flush().then(function() {
+			let log = g.exportLog().split('\n').filter(function(line) {
+				return -1 < line.indexOf('"op":"update","node":[1,"Coalesced",' + e.id + ']');
+			});
+			if (1 != log.length || -1 == log[0].indexOf('["count","9"]') || -1 == log[0].indexOf('"deleted":["scratch"]')) {
+				console.log('Coalesce test failed.', log);
+			}
+			console.log('Coalesced (%d) Time %d', log.length, Date.now() - start);
+		});
+	});
+})();
+
+(function() {
+	// test a batch commits its changes together and undoes them when it throws
+	let start = Date.now();
+	let g = new gk.Graph();
+	let e = new gk.Entity('Batched');
+	e['name'] = 'before';
+	g.insert(e);
+	let count = 0;
+	g.batch(function() {
+		for (let i = 0; i < 100; ++i) {
+			g.insert(new gk.Entity('Batched'));
+		}
+	});
+	try {
+		g.batch(function() {
+			e['name'] = 'after';
+			e.addGroup('batched');
+			g.insert(new gk.Entity('Batched'));
+			throw new Error('rollback');
+		});
+	} catch (error) {
+		count = g.Entity.Batched.count;
+	}
+	if (101 != count || 'before' != e['name'] || e.hasGroup('batched')) {
+		console.log('Batch test failed.', count, e['name']);
+	}
+	console.log('Batched (%d) Time %d', count, Date.now() - start);
+})();
+
+(function() {
+	// test bulk inserts take consecutive ids and keep the Index ordered
+	let start = Date.now();
+	let g = new gk.Graph();
+	let before = g.Entity.Bulk ? g.Entity.Bulk.count : 0;
+	let entities = g.createEntities('Bulk', 1000, [{name: 'first'}]);
+	let nodes = [];
+	for (let i = 0; i < 10; ++i) {
+		nodes.push(new gk.Entity('Bulk'));
+	}
+	let inserted = g.insertMany(nodes.concat(entities.slice(0, 1)));
+	let rejected = [-1, 1.5, NaN, Infinity, 1e15].every(function(count) {
+		try {
+			g.createEntities('Bulk', count);
+			return false;
+		} catch (e) {
+			return true;
+		}
+	});
+	let bulk = g.Entity.Bulk;
+	let ordered = true;
+	for (let i = 1; i < bulk.count; ++i) {
+		if (bulk[i - 1].id >= bulk[i].id) {
+			ordered = false;
+		}
+	}
+	if (before + 1010 != bulk.count || 10 != inserted || !ordered || !rejected || 'first' != entities[0]['name'] || entities[999].id != entities[0].id + 999) {
+		console.log('Bulk test failed.', bulk.count, inserted, ordered, rejected);
+	}
+	console.log('Bulk inserted (%d) Time %d', bulk.count, Date.now() - start);
+})();
+
+(function() {
+	// test strict durability writes each change before returning
+	let start = Date.now();
+	let g = new gk.Graph({path: 'gk.db/durable', durability: 'strict'});
+	let e = g.createEntity('Durable');
+	e['name'] = 'strict';
+	let stats = g.stats();
+	let rejected = [{durability: 'group'}, {batch: 1}, {delay: -1}, {segment: -1}, {checkpoint: -1}].every(function(options) {
+		try {
+			new gk.Graph(Object.assign({path: 'gk.db/durable'}, options));
+			return false;
+		} catch (e) {
+			return true;
+		}
+	});
+	let restated = new gk.Graph({path: 'gk.db/durable', durability: 'strict'}).stats().durability;
+	if ('strict' != stats.durability || 0 != stats.buffered || stats.queued != stats.written || !rejected || 'strict' != restated || 'strict' != g.stats().durability) {
+		console.log('Durability test failed.', stats, rejected);
+	}
+	console.log('Durability (%s) Time %d', stats.durability, Date.now() - start);
+})();
+
+(function() {
+	// test Graphs of different paths keep their own Nodes and logs
+	let start = Date.now();
+	let g = new gk.Graph();
+	let t = new gk.Graph({path: 'gk.db/tenant'});
+	let own = g.Entity.Tenant ? g.Entity.Tenant.count : 0;
+	let before = t.Entity && t.Entity.Tenant ? t.Entity.Tenant.count : 0;
+	t.createEntity('Tenant');
+	let shared = new gk.Graph({path: './gk.db/tenant/'});
+	let count = shared.Entity.Tenant.count;
+	if (before + 1 != count || own != (g.Entity.Tenant ? g.Entity.Tenant.count : 0) || g.stats().path == t.stats().path) {
+		console.log('Path test failed.', before, count, own);
+	}
+	let rejected = [123, '', null, {}].every(function(path) {
+		try {
+			new gk.Graph({path: path});
+			return false;
+		} catch (e) {
+			return true;
+		}
+	});
+	if (!rejected) {
+		console.log('Path option test failed.');
+	}
+	console.log('Paths (%d) Time %d', count, Date.now() - start);
+})();
+
+(function() {
+	// test closing a Graph writes its log and lets a new Graph load the directory again
+	let start = Date.now();
+	let g = new gk.Graph({path: 'gk.db/closed', delay: 100000});
+	let before = g.Entity && g.Entity.Closed ? g.Entity.Closed.count : 0;
+	let entities = g.createEntities('Closed', 10);
+	entities[0]['value'] = 'closed';
+	let flushed = g.flush();
+	let checkpointed = g.checkpoint();
+	g.close();
+	let emptied = !g.Entity;
+	let reopened = new gk.Graph({path: 'gk.db/closed', durability: 'strict'});
+	let count = reopened.Entity.Closed.count;
+	let e = reopened.Entity.Closed[before];
+	if (!emptied || before + 10 != count || entities[0].id != e.id || 'closed' != e['value'] || 'strict' != reopened.stats().durability) {
+		console.log('Close test failed.', emptied, before, count);
+	}
+	Promise.all([flushed, checkpointed.catch(function() {})]).then(function() {
+		console.log('Closed (%d) Time %d', count, Date.now() - start);
+	}).catch(function(e) {
+		console.log('Close test failed.', e);
+	});
+})();
+
+(function() {
+	// test records well over 4KB load whole, from Node files and from the log
+	let start = Date.now();
+	let fs = require('fs');
+	let dir = './gk.db/large';
+	(function empty(path) {
+		if (fs.existsSync(path)) {
+			fs.readdirSync(path).forEach(function(f) {
+				fs.statSync(path + '/' + f).isDirectory() ? empty(path + '/' + f) : fs.unlinkSync(path + '/' + f);
+			});
+			fs.rmdirSync(path);
+		}
+	})(dir);
+	fs.mkdirSync(dir);
+	let value = 'large "value" \\ \nü '.repeat(1000);
+	let objects = [];
+	for (let i = 1; i <= 500; ++i) {
+		let properties = 1 == i ? [['value', value]] : [];
+		fs.writeFileSync(dir + '/e' + i + '.gk', JSON.stringify({id: i, nodeClass: 1, type: 'Filed', properties: properties, groups: []}));
+		objects.push({id: i, nodeClass: 1, type: 'Filed'});
+	}
+	fs.writeFileSync(dir + '/a1.gk', JSON.stringify({id: 1, nodeClass: 2, type: 'Filed', properties: [], groups: [], subjects: [], objects: objects}));
+
+	let compare = function(g, type) {
+		let a = g.Action[type][0];
+		let filled = objects.every(function(o) {
+			return a.objects.find(1, type, o.id) == g.Entity[type].find(o.id);
+		});
+		return value == g.Entity[type].find(1)['value'] && objects.length == a.objects.count && filled;
+	};
+	let g = new gk.Graph({path: 'gk.db/large'});
+	let filed = compare(g, 'Filed');
+
+	// the same records written to the log
+	let a = g.createAction('Logged');
+	g.createEntities('Logged', objects.length).forEach(function(e) {
+		a.addObject(e);
+	});
+	g.Entity.Logged.find(1)['value'] = value;
+	g.close();
+	let reloaded = new gk.Graph({path: 'gk.db/large'});
+	let logged = compare(reloaded, 'Logged') && compare(reloaded, 'Filed');
+	if (!filed || !logged) {
+		console.log('Large record test failed.', filed, logged);
+	}
+	console.log('Large records (%d) Time %d', value.length, Date.now() - start);
+})();
+
+(function() {
+	// test IDs leased across a lease boundary are never handed out again after a reload
+	let start = Date.now();
+	let g = new gk.Graph({path: 'gk.db/leased'});
+	let seen = 0;
+	for (let i = g.Entity && g.Entity.Leased ? g.Entity.Leased.count - 1 : -1; 0 <= i; --i) {
+		seen = Math.max(seen, g.Entity.Leased[i].id);
+	}
+	let last = null;
+	for (let i = 0; i < 4100; ++i) {
+		last = g.createEntity('Leased');
+		seen = Math.max(seen, last.id);
+	}
+	g.createEntities('Leased', 5000).forEach(function(e) {
+		seen = Math.max(seen, e.id);
+	});
+	// the newest IDs are not in the Graph anymore, only in the lease
+	g.remove(last);
+	g.remove(g.Entity.Leased.find(seen));
+	g.close();
+	let reopened = new gk.Graph({path: 'gk.db/leased'});
+	let fresh = [reopened.createEntity('Leased').id].concat(reopened.createEntities('Leased', 10).map(function(e) {
+		return e.id;
+	}));
+	if (!fresh.every(function(id) {
+		return seen < id;
+	})) {
+		console.log('ID lease test failed.', seen, fresh);
+	}
+	console.log('Leased IDs (%d) Time %d', seen, Date.now() - start);
+})();
+
+(function() {
+	// test dropping a type detaches it at once and releases its Nodes later
+	let start = Date.now();
+	let g = new gk.Graph({path: 'gk.db/drop'});
+	let kept = g.createEntity('Kept');
+	let entities = g.createEntities('Dropped', 10000);
+	entities[0].addGroup('dropped');
+	g.createAction('Dropped');
+	let dropped = g.dropType(1, 'Dropped') && !g.Entity.Dropped && !g.dropType(1, 'Dropped') && g.dropCluster(2) && !g.Action;
+	// a chunk of Nodes is released each loop iteration
+	let tries = 0;
+	(function released() {
+		if (0 != g.group('dropped').count && 10 > ++tries) {
+			return setImmediate(released);
+		}
+		if (!dropped || !g.Entity.Kept || 0 != g.group('dropped').count) {
+			console.log('Drop test failed.', dropped, g.group('dropped').count);
+		}
+	})();
+	console.log('Dropped (%d) Time %d', entities.length, Date.now() - start);
+})();
+
+(function() {
+	// test a compressed Graph frames its log blocks and reloads them
+	let start = Date.now();
+	let fs = require('fs');
+	let g = new gk.Graph({path: 'gk.db/packed', compress: true});
+	let before = g.Entity && g.Entity.Packed ? g.Entity.Packed.count : 0;
+	let reloaded = true;
+	for (let i = 0; i < before; ++i) {
+		reloaded = reloaded && 'packed' == g.Entity.Packed[i]['name'];
+	}
+	for (let e of g.createEntities('Packed', 100)) {
+		e['name'] = 'packed';
+	}
+	g.flush().then(function() {
+		let framed = fs.readdirSync('./gk.db/packed').filter(function(f) {
+			return f.endsWith('.log');
+		}).some(function(f) {
+			return -1 != fs.readFileSync('./gk.db/packed/' + f).indexOf('\x1fGKZ');
+		});
+		let file = require('os').tmpdir() + '/graphkit_packed_test.gks';
+		return g.saveSnapshot(file).then(function(count) {
+			let data = fs.readFileSync(file);
+			fs.unlinkSync(file);
+			if (!reloaded || !framed || before + 100 != g.Entity.Packed.count || count < before + 100 || 'GKSNAPZ' != data.toString('ascii', 0, 7)) {
+				console.log('Compress test failed.', reloaded, framed, before, g.Entity.Packed.count);
+			}
+			console.log('Compressed (%d) Time %d', g.Entity.Packed.count, Date.now() - start);
+		});
+	}).catch(function(e) {
+		console.log('Compress test failed.', e);
+	});
+})();
+
+(function() {
+	// test a frame with a corrupt length is dropped instead of sizing the read
+	let start = Date.now();
+	let fs = require('fs');
+	let g = new gk.Graph({path: 'gk.db/torn', compress: true});
+	for (let e of g.createEntities('Torn', 100)) {
+		e['name'] = 'torn';
+	}
+	let inserts = function() {
+		return g.exportLog().split('\n').filter(function(line) {
+			return 0 < line.length;
+		}).map(function(line) {
+			let r = JSON.parse(line);
+			return (r.records || [r]).filter(function(r) {
+				return 'insert' == r.op && 'Torn' == r.data.type;
+			}).length;
+		}).reduce(function(a, b) {
+			return a + b;
+		}, 0);
+	};
+	g.flush().then(function() {
+		let before = inserts();
+		let file = './gk.db/torn/' + fs.readdirSync('./gk.db/torn').filter(function(f) {
+			return f.endsWith('.log');
+		}).sort().pop();
+		let data = fs.readFileSync(file);
+		let at = data.indexOf('\x1fGKZ');
+		data.writeUInt32LE(0xffffffff, at + 4);
+		fs.writeFileSync(file, data);
+		let after = inserts();
+		if (-1 == at || before - 100 != after) {
+			console.log('Torn frame test failed.', at, before, after);
+		}
+		console.log('Torn frame (%d) Time %d', after, Date.now() - start);
+	}).catch(function(e) {
+		console.log('Torn frame test failed.', e);
+	});
+})();
+
+(function() {
+	// test the binary log keeps any value and exports it as JSON lines
+	let start = Date.now();
+	let g = new gk.Graph({path: 'gk.db/export'});
+	let value = 'say "hi" \\ \n\t\u0001 ünïcode';
+	let before = g.Entity && g.Entity.Exported ? g.Entity.Exported.count : 0;
+	let reloaded = true;
+	for (let i = 0; i < before; ++i) {
+		reloaded = reloaded && value == g.Entity.Exported[i]['quoted'] && g.Entity.Exported[i].hasGroup('"exported"');
+	}
+	let e = g.createEntity('Exported');
+	e['quoted'] = value;
+	e.addGroup('"exported"');
+	g.flush().then(function() {
+		let records = g.exportLog().split('\n').filter(function(line) {
+			return 0 < line.length;
+		}).map(function(line) {
+			return JSON.parse(line);
+		});
+		let exported = records.some(function(r) {
+			return 'insert' == r.op && e.id == r.data.id && value == r.data.properties[0][1] && '"exported"' == r.data.groups[0];
+		});
+		if (!reloaded || !exported) {
+			console.log('Export test failed.', reloaded, exported);
+		}
+		console.log('Exported (%d) Time %d', records.length, Date.now() - start);
+	}).catch(function(e) {
+		console.log('Export test failed.', e);
+	});
+})();
+
+(function() {
+	// test a flush large enough to be encoded on the workers logs every insert in order
+	let start = Date.now();
+	let g = new gk.Graph({path: 'gk.db/parallel', batch: 1 << 20, delay: 100000});
+	let before = g.Entity && g.Entity.Parallel ? g.Entity.Parallel.count : 0;
+	let reloaded = true;
+	for (let i = 0; i < before; ++i) {
+		let e = g.Entity.Parallel[i];
+		reloaded = reloaded && 'v' + e.id == e['value'] && e.hasGroup('g' + e.id % 10);
+	}
+	let ids = [];
+	g.batch(function() {
+		for (let i = 0; i < 5000; ++i) {
+			let e = g.createEntity('Parallel');
+			e['value'] = 'v' + e.id;
+			e.addGroup('g' + e.id % 10);
+			ids.push(e.id);
+		}
+	});
+	g.flush().then(function() {
+		let logged = [];
+		g.exportLog().split('\n').forEach(function(line) {
+			if (0 < line.length) {
+				let r = JSON.parse(line);
+				(r.records || [r]).forEach(function(r) {
+					if ('insert' == r.op && 'Parallel' == r.data.type && 'v' + r.data.id == r.data.properties[0][1]) {
+						logged.push(r.data.id);
+					}
+				});
+			}
+		});
+		let ordered = logged.slice(-ids.length).join() == ids.join();
+		if (!reloaded || !ordered) {
+			console.log('Parallel test failed.', reloaded, ordered);
+		}
+		console.log('Parallel (%d) Time %d', before + ids.length, Date.now() - start);
+	}).catch(function(e) {
+		console.log('Parallel test failed.', e);
+	});
+})();